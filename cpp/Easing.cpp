@@ -0,0 +1,180 @@
+// Easing.cpp
+#include "Easing.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <map>
+
+// cubic-bezier 采样表的分段数，257 个采样点时最大误差远小于一个像素/一个颜色级
+static const int kBezierTableSegments = 256;
+
+// 命名曲线统一成小写并去掉分隔符，easeInOut、ease-in-out、ease_in_out 视为同一个名字
+static std::string normalizeCurveName(const std::string& name) {
+    std::string result;
+    for (char c : name) {
+        if (c == '-' || c == '_' || c == ' ') continue;
+        result.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+    }
+    return result;
+}
+
+// controls 支持 [x1, y1, x2, y2] 和 [[x1, y1], [x2, y2]] 两种写法
+static bool parseBezierControls(const nlohmann::json& controls, std::array<double, 4>& result) {
+    if (!controls.is_array()) return false;
+    std::vector<double> values;
+    for (const auto& control : controls) {
+        if (control.is_number()) {
+            values.push_back(control.get<double>());
+        } else if (control.is_array()) {
+            for (const auto& value : control) {
+                if (!value.is_number()) return false;
+                values.push_back(value.get<double>());
+            }
+        } else {
+            return false;
+        }
+    }
+    if (values.size() != 4) return false;
+    std::copy(values.begin(), values.end(), result.begin());
+    return true;
+}
+
+Easing Easing::fromKeyframe(const nlohmann::json& keyframe) {
+    Easing easing;
+    if (!keyframe.is_object()) return easing;
+
+    std::string type = keyframe.contains("type") && keyframe["type"].is_string() ? normalizeCurveName(keyframe["type"].get<std::string>()) : "";
+    std::string curveType = keyframe.contains("curveType") && keyframe["curveType"].is_string() ? normalizeCurveName(keyframe["curveType"].get<std::string>()) : "";
+
+    if (type == "hold" || type == "constant" || type == "step") {
+        easing.function = Function::Hold;
+        return easing;
+    }
+
+    std::array<double, 4> controls;
+    if ((curveType.empty() || curveType == "bezier" || curveType == "cubicbezier" || curveType == "custom") &&
+        keyframe.contains("controls") && parseBezierControls(keyframe["controls"], controls)) {
+        easing.function = Function::Bezier;
+        easing.bezierTable = getBezierTable(controls);
+        return easing;
+    }
+
+    // CSS 预设
+    static const std::map<std::string, std::array<double, 4>> cssPresets = {
+        {"ease",      {0.25, 0.1, 0.25, 1.0}},
+        {"easein",    {0.42, 0.0, 1.0, 1.0}},
+        {"easeout",   {0.0, 0.0, 0.58, 1.0}},
+        {"easeinout", {0.42, 0.0, 0.58, 1.0}},
+    };
+    auto presetIt = cssPresets.find(curveType);
+    if (presetIt != cssPresets.end()) {
+        easing.function = Function::Bezier;
+        easing.bezierTable = getBezierTable(presetIt->second);
+        return easing;
+    }
+
+    // easeIn/Out/InOut + 函数族
+    static const std::map<std::string, Function> families = {
+        {"sine", Function::Sine}, {"quad", Function::Quad}, {"cubic", Function::Cubic},
+        {"quart", Function::Quart}, {"quint", Function::Quint}, {"expo", Function::Expo},
+        {"circ", Function::Circ}, {"back", Function::Back},
+    };
+    static const std::array<std::pair<const char*, Mode>, 3> modes = {{
+        {"easeinout", Mode::InOut}, {"easein", Mode::In}, {"easeout", Mode::Out},
+    }};
+    for (const auto& [prefix, mode] : modes) {
+        std::string prefixString(prefix);
+        if (curveType.compare(0, prefixString.size(), prefixString) != 0) continue;
+        auto familyIt = families.find(curveType.substr(prefixString.size()));
+        if (familyIt != families.end()) {
+            easing.function = familyIt->second;
+            easing.mode = mode;
+            return easing;
+        }
+    }
+
+    return easing;
+}
+
+std::shared_ptr<const Easing::BezierTable> Easing::getBezierTable(const std::array<double, 4>& controls) {
+    // 相同控制点的段共用一张表，模板里大量重复的缓动只生成一次
+    static std::map<std::array<double, 4>, std::shared_ptr<const BezierTable>> cache;
+    auto cacheIt = cache.find(controls);
+    if (cacheIt != cache.end()) return cacheIt->second;
+
+    // x 方向控制点限制在 [0, 1]，保证 x(t) 单调
+    double x1 = std::clamp(controls[0], 0.0, 1.0);
+    double y1 = controls[1];
+    double x2 = std::clamp(controls[2], 0.0, 1.0);
+    double y2 = controls[3];
+
+    auto bezier = [](double p1, double p2, double t) {
+        double u = 1.0 - t;
+        return 3.0 * u * u * t * p1 + 3.0 * u * t * t * p2 + t * t * t;
+    };
+
+    auto table = std::make_shared<BezierTable>();
+    table->samples.resize(kBezierTableSegments + 1);
+    for (int i = 0; i <= kBezierTableSegments; i++) {
+        double x = static_cast<double>(i) / kBezierTableSegments;
+        // 只在生成表时二分求解 x(t) = x
+        double lo = 0.0, hi = 1.0, t = x;
+        for (int iteration = 0; iteration < 40; iteration++) {
+            t = (lo + hi) * 0.5;
+            if (bezier(x1, x2, t) < x) lo = t; else hi = t;
+        }
+        table->samples[i] = static_cast<float>(bezier(y1, y2, t));
+    }
+    table->samples.front() = 0.0f;
+    table->samples.back() = 1.0f;
+
+    cache[controls] = table;
+    return table;
+}
+
+double Easing::applyIn(Function function, double t) {
+    switch (function) {
+    case Function::Sine:  return 1.0 - std::cos(t * M_PI / 2.0);
+    case Function::Quad:  return t * t;
+    case Function::Cubic: return t * t * t;
+    case Function::Quart: return t * t * t * t;
+    case Function::Quint: return t * t * t * t * t;
+    case Function::Expo:  return t <= 0.0 ? 0.0 : std::pow(2.0, 10.0 * t - 10.0);
+    case Function::Circ:  return 1.0 - std::sqrt(std::max(0.0, 1.0 - t * t));
+    case Function::Back: {
+        const double c1 = 1.70158;
+        const double c3 = c1 + 1.0;
+        return c3 * t * t * t - c1 * t * t;
+    }
+    default:              return t;
+    }
+}
+
+double Easing::apply(double progress) const {
+    double t = std::clamp(progress, 0.0, 1.0);
+    switch (function) {
+    case Function::Linear:
+        return progress;
+    case Function::Hold:
+        return t < 1.0 ? 0.0 : 1.0;
+    case Function::Bezier: {
+        const auto& samples = bezierTable->samples;
+        double position = t * kBezierTableSegments;
+        int index = std::min(static_cast<int>(position), kBezierTableSegments - 1);
+        double fraction = position - index;
+        return samples[index] + (samples[index + 1] - samples[index]) * fraction;
+    }
+    default:
+        break;
+    }
+
+    switch (mode) {
+    case Mode::In:
+        return applyIn(function, t);
+    case Mode::Out:
+        return 1.0 - applyIn(function, 1.0 - t);
+    case Mode::InOut:
+    default:
+        return t < 0.5 ? applyIn(function, 2.0 * t) / 2.0 : 1.0 - applyIn(function, 2.0 - 2.0 * t) / 2.0;
+    }
+}
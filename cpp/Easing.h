@@ -0,0 +1,48 @@
+// Easing.h
+#ifndef EASING_H
+#define EASING_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "nlohmann/json.hpp"
+
+// 关键帧段的缓动曲线
+// 由关键帧的 type / curveType / controls 解析得到，作用于该关键帧到下一个关键帧之间的段：
+//   type 为 hold/constant/step          -> 保持前一个值直到下一个关键帧
+//   controls 为 [x1, y1, x2, y2]         -> cubic-bezier（curveType 为空、bezier、cubic-bezier 或 custom 时）
+//   curveType 为命名曲线                  -> ease/easeIn/easeOut/easeInOut（CSS 预设）以及
+//                                          easeIn/Out/InOut + Sine/Quad/Cubic/Quart/Quint/Expo/Circ/Back
+//   其它情况                              -> 线性
+// 命名曲线使用闭式公式；cubic-bezier 在解析时预先生成 x -> y 的采样表，求值只做一次查表插值，不做迭代求解
+class Easing {
+public:
+    static Easing fromKeyframe(const nlohmann::json& keyframe);
+
+    bool isLinear() const { return function == Function::Linear; }
+
+    // progress 为段内线性进度 [0, 1]，返回缓动后的进度
+    double apply(double progress) const;
+
+private:
+    enum class Function : std::uint8_t {
+        Linear, Hold, Bezier,
+        Sine, Quad, Cubic, Quart, Quint, Expo, Circ, Back
+    };
+    enum class Mode : std::uint8_t { In, Out, InOut };
+
+    // cubic-bezier 在 x 等分点上的 y 值
+    struct BezierTable {
+        std::vector<float> samples;
+    };
+    static std::shared_ptr<const BezierTable> getBezierTable(const std::array<double, 4>& controls);
+    static double applyIn(Function function, double t);
+
+    Function function = Function::Linear;
+    Mode mode = Mode::In;
+    std::shared_ptr<const BezierTable> bezierTable;
+};
+
+#endif // EASING_H
@@ -2,15 +2,22 @@
 
 #include "Engine.h"
 #include <cmath>
+#include <set>
 #include <thread>
 #include "src/ExpressTool.h"
 #include "src/ScopedProfiler.h"
+#include "src/GLExtensions.h"
+#include "src/GLStateCache.h"
+#include "src/ReadbackRing.h"
 #include "Keyframe.h"
 
 
 #include "src/VideoResource.h"
+#include "src/AsyncVideoResource.h"
+#include "src/YuvTexture.h"
 #include "src/ImageResource.h"
 #include "src/TextResource.h"
+#include "src/ResourceRegistry.h"
 
 
 
@@ -32,42 +39,61 @@ Engine::Engine()
 
 // 析构函数
 Engine::~Engine() {
-    // 清理资源
-    if (offscreenDepthRb)  glDeleteRenderbuffers(1, &offscreenDepthRb);
-    if (offscreenColorTex) glDeleteTextures(1, &offscreenColorTex);
-    if (offscreenFbo)      glDeleteFramebuffers(1, &offscreenFbo);
+    Shutdown();
+}
+
+void Engine::Shutdown() {
+    if (!glContext) return;
+
+    // 先释放所有持有 GL 对象的资源，再销毁上下文
+    clearTracks();
+    finalBlitMaterial.reset();
+    renderPass.reset();
+    shaderManager.reset();
+    RenderTargetPool::instance().reset();
+    RenderTargetPool::instance().releaseCachedRenderTargets();
+    TextResource::releaseSharedResources();
+    YuvTexture::releaseSharedResources();
+
+    destroyCanvas();
+    if (screenBuffer) GLStateCache::instance().deleteBuffers(1, &screenBuffer);
+    if (ndcBuffer)    GLStateCache::instance().deleteBuffers(1, &ndcBuffer);
+    screenBuffer = 0;
+    ndcBuffer = 0;
+
+    glContext->terminate();
+    glContext.reset();
+    GLStateCache::instance().invalidate();
+    window = nullptr;
+}
 
+void Engine::clearTracks() {
+    // 编译好的绘制列表引用着旧的材质、顶点缓冲和着色器程序
+    if (renderPass) renderPass->clearCompiledPasses();
+    rendererMap.clear();
+    sequences.clear();
+    transitionRendererMap.clear();
+    pluginRendererMap.clear();
+    sceneModel.clear();
+    audioClips.clear();
 }
 
 // 初始化 Engine
-bool Engine::Init(int width, int height, float globalRenderScale, bool isVisible) {
+bool Engine::Init(int width, int height, float globalRenderScale, bool isVisible, GLContextBackend backend) {
     this->globalRenderScale = globalRenderScale;
-        // 初始化 GLFW
-    if (!glfwInit()) {
-        std::cerr << "无法初始化 GLFW" << std::endl;
-        return false;
-    }
-
-    if (!isVisible)
-    {
-        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
-    }
-    GLFWwindow* window = glfwCreateWindow(width, height, "Video Rendering", NULL, NULL);
-    if (!window) {
-        std::cerr << "无法创建窗口" << std::endl;
-        glfwTerminate();
-        return false;
-    }
 
-    glfwMakeContextCurrent(window);
-
-    // 初始化 GLEW
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "无法初始化 GLEW" << std::endl;
-        glfwTerminate();
+    // 创建 OpenGL 上下文并加载函数
+    glContext = GLContext::create(backend, width, height, isVisible);
+    if (!glContext) {
+        std::cerr << "无法创建 OpenGL 上下文" << std::endl;
         return false;
     }
+    GLFWwindow* window = glContext->getWindow();
+    GLExtensions::load(*glContext);
+    // 新上下文的状态与缓存无关
+    GLStateCache::instance().invalidate();
 
+    std::clog << "OpenGL Context: " << glContext->getName() << std::endl;
     std::clog << "OpenGL Version: " << glGetString(GL_VERSION) << std::endl;
     std::clog << "GLSL Version: " << glGetString(GL_SHADING_LANGUAGE_VERSION) << std::endl;
     std::clog << "Renderer: " << glGetString(GL_RENDERER) << std::endl;
@@ -81,19 +107,62 @@ bool Engine::Init(int width, int height, float globalRenderScale, bool isVisible
     // }
 
 
-        
+
     this->window = window;
+    this->shaderManager = std::make_shared<ShaderManager>();
+    YuvTexture::setShaderManager(shaderManager);
+
+    glGenBuffers(1, &ndcBuffer);
+    float ndcVertices[] =  {
+        // x, y, z, u, v
+        -1, 1, 0, 0, 1,
+        1, 1, 0, 1, 1,
+        -1, -1, 0, 0, 0,
+        1, -1, 0, 1, 0,
+    };
+    
+    GLStateCache::instance().bindBuffer(GL_ARRAY_BUFFER, ndcBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(ndcVertices), ndcVertices, GL_STATIC_DRAW);
+
+    return createCanvas(width, height);
+}
+
+bool Engine::Prepare(int width, int height, float globalRenderScale) {
+    this->globalRenderScale = globalRenderScale;
+    if (width == renderTargetWidth && height == renderTargetHeight) {
+        return true;
+    }
+
+    // 旧尺寸的渲染器引用着旧的渲染目标，先全部释放
+    clearTracks();
+    destroyCanvas();
+    RenderTargetPool::instance().reset();
+    return createCanvas(width, height);
+}
+
+void Engine::applyJobSettings(const nlohmann::json& tracksJson) {
+    // colorRange: "limited"（默认）/ "full"
+    setOutputFullRange(tracksJson.value("colorRange", "limited") == "full");
+    setReadbackDepth(tracksJson.value("readbackDepth", 3));
+    setAsyncVideoDecode(tracksJson.value("asyncDecode", true));
+    setScaledVideoDecode(tracksJson.value("scaledDecode", true));
+    // encoder: {"codec", "preset", "tune", "crf", "bitrateKbps", "maxrateKbps", "bufsizeKbps", "gop", "bFrames", "threads", "threadType", "pixelFormat", "audioBitrateKbps", "options"}
+    setEncoderProfile(EncoderProfile::fromJson(tracksJson.value("encoder", nlohmann::json::object())));
+}
+
+// 创建与画布尺寸相关的资源：离屏 FBO、相机、渲染通道
+bool Engine::createCanvas(int width, int height) {
     this->renderTargetWidth = width;
     this->renderTargetHeight = height;
 
-
     // ---------- 创建 1920×1080 离屏 FBO ----------
+    GLStateCache& state = GLStateCache::instance();
     glGenFramebuffers(1, &offscreenFbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, offscreenFbo);
+    state.bindFramebuffer(GL_FRAMEBUFFER, offscreenFbo);
 
     // 颜色纹理
     glGenTextures(1, &offscreenColorTex);
-    glBindTexture(GL_TEXTURE_2D, offscreenColorTex);
+    state.bindTexture(offscreenColorTex);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, renderTargetWidth, renderTargetHeight,
                 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -113,27 +182,13 @@ bool Engine::Init(int width, int height, float globalRenderScale, bool isVisible
         std::cerr << "离屏 FBO 创建失败\n";
         return false;
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
     updateCamera();
 
-    glGenBuffers(1, &ndcBuffer);
-    float ndcVertices[] =  {
-        // x, y, z, u, v
-        -1, 1, 0, 0, 1,
-        1, 1, 0, 1, 1,
-        -1, -1, 0, 0, 0,
-        1, -1, 0, 1, 0,
-    };
-    
-    glBindBuffer(GL_ARRAY_BUFFER, ndcBuffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(ndcVertices), ndcVertices, GL_STATIC_DRAW);
-
     defaultRenderTargetInfo = {"screen", width, height};
 
     sequenceRenderTargetInfo = {"sequenceRenderTarget", width, height};
 
-    this->shaderManager = std::make_shared<ShaderManager>();
     this->renderPass = std::make_unique<RenderPass>(shaderManager, renderTargetWidth, renderTargetHeight, defaultRenderTargetInfo, offscreenFbo);
 
     finalBlitMaterial = std::make_shared<Material>(Blit);
@@ -143,137 +198,162 @@ bool Engine::Init(int width, int height, float globalRenderScale, bool isVisible
     finalBlitMaterial->uniforms["u_texture"].value = this->sequenceRenderTargetInfo;//.get(); // 存储 Material* 指针
     finalBlitMaterial->renderTargetInfo = defaultRenderTargetInfo; // 渲染到屏幕
 
+    yuvConverter = std::make_unique<YuvConverter>(shaderManager, width, height);
+
 
 
     return true;
 }
 
+void Engine::destroyCanvas() {
+    yuvConverter.reset();
+    if (offscreenDepthRb)  glDeleteRenderbuffers(1, &offscreenDepthRb);
+    if (offscreenColorTex) GLStateCache::instance().deleteTextures(1, &offscreenColorTex);
+    if (offscreenFbo)      GLStateCache::instance().deleteFramebuffers(1, &offscreenFbo);
+    offscreenDepthRb = 0;
+    offscreenColorTex = 0;
+    offscreenFbo = 0;
+}
+
 // 更新画布（例如窗口大小改变）
 
 // 设置混合模式
 void Engine::setBlendingMode(const std::string& mode) {
+    GLStateCache& state = GLStateCache::instance();
     if (mode == "normal") {
         // glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-        glBlendEquation(GL_FUNC_ADD);
+        state.blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        state.blendEquation(GL_FUNC_ADD);
     } else if (mode == "additive") {
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-        glBlendEquation(GL_FUNC_ADD);
+        state.blendFunc(GL_SRC_ALPHA, GL_ONE);
+        state.blendEquation(GL_FUNC_ADD);
     } else if (mode == "multiply") {
-        glBlendFunc(GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA);
-        glBlendEquation(GL_FUNC_ADD);
+        state.blendFunc(GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA);
+        state.blendEquation(GL_FUNC_ADD);
     } else if (mode == "subtract") {
-        glBlendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_ONE);
-        glBlendEquation(GL_FUNC_SUBTRACT);
+        state.blendFunc(GL_ONE_MINUS_SRC_ALPHA, GL_ONE);
+        state.blendEquation(GL_FUNC_SUBTRACT);
     } else {
         std::cerr << "Unknown blending mode: " << mode << ". Defaulting to 'normal'.\n";
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glBlendEquation(GL_FUNC_ADD);
+        state.blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        state.blendEquation(GL_FUNC_ADD);
     }
 }
 
 // 渲染当前帧
-bool Engine::render(FFmpegWriter& writer, const std::vector<std::vector<nlohmann::json>>& sequences, int& index, int& nextIndex, GLuint pboIds[2], bool isDebug) {
+bool Engine::render(FFmpegWriter& writer, const SceneModel& scene, ReadbackRing& readbackRing, bool isDebug) {
     ScopedProfiler profiler("Engine::Render");
 
     // 计算全局时间（毫秒）
     double globalTime = currentTime * 1000.0;
 
+    // 画面与上一帧完全相同：不渲染、不读回，编码器直接重复上一帧转换好的 YUV 数据
+    if (isStaticFrame(scene, globalTime))
+    {
+        // 之前渲染的帧还在读回环中，先全部送出，保证帧顺序（之后连续的静态帧环为空，不会等待）
+        readbackRing.drain();
+        if (!writer.pushRepeatFrame()) {
+            std::cerr << "送入编码队列失败，跳过该帧" << std::endl;
+        }
+        staticFrameCount++;
+        if (isDebug && window)
+        {
+            presentDebugWindow();
+        }
+        return true;
+    }
+    renderedFrameCount++;
+
     std::vector<std::shared_ptr<Material>> visibleRendererMaterials;
 
-    // bool nextRenderPassAdded = false;
-    // 判断哪些渲染器可见
-    for (size_t i = 0; i < sequences.size(); i++)
-    {
-        std::shared_ptr<TransitionRenderer> currentTransitionRenderer = nullptr;
-        std::set<std::shared_ptr<VideoRenderer>> visibleRenderers;    
-        const auto& sequenceArray = sequences[i];
-        for (size_t j = 0; j < sequenceArray.size(); j++)
+    // 解码视频片段在当前时间对应的画面
+    auto updateVideoFrame = [&](const TrackModel& track, size_t j) {
+        const auto& videoResource = scene.videoResources[track.rendererIndex[j]];
+        if (videoResource)
         {
-            const auto& sequence = sequenceArray[j];
-            if (!sequence.is_object()) continue;
-            if (!sequence.contains("id")) continue;
-            std::string seqId = sequence["id"];
+            // 获取 originalTime
+            double originalTime = track.getOriginalTime(j, globalTime);
+            ScopedProfiler profilerVideoResource("sequence videoResource-》" + scene.videoRenderers[track.rendererIndex[j]]->getName());
+            videoResource->getFrameAt(fmod(originalTime/1000.f, videoResource->getDuration()));
+        }
+    };
 
+    // 判断哪些渲染器可见（只访问编译后的场景模型，通过区间索引只处理当前活动的片段）
+    for (const auto& track : scene.tracks)
+    {
+        std::vector<int> visibleRenderers;
+        for (int j : track.visibilityIndex.query(globalTime))
+        {
             // 判断是否可见
-            bool isVisible = trackUtils->isVisibleAtTime(globalTime, sequence);
+            if (!track.isVisibleAtTime(j, globalTime)) continue;
+            int rendererIndex = track.rendererIndex[j];
 
-            if (sequence["type"].get<std::string>() == "plugin")
+            if (track.type[j] == SequenceType::Plugin)
             {
-                auto rendererIt = pluginRendererMap.find(seqId);
-                if (rendererIt == pluginRendererMap.end()) {
-                    continue; // 找不到渲染器
+                const auto& renderer = scene.pluginRenderers[rendererIndex];
+                if (renderer->hasUniformTime)
+                {
+                    double time = track.getSequenceTime(j, globalTime);
+                    renderer->updateTime(static_cast<float>(time/1000));
                 }
-                auto renderer = rendererIt->second;
-                if (isVisible) {
-                    if (renderer->hasUniformTime)
-                    {
-                        double time = trackUtils->getSequenceTime(globalTime, sequence);
-                        renderer->updateTime(static_cast<float>(time/1000));
-                    }
-                    visibleRendererMaterials.push_back(renderer->getMaterialPass());
-                    Keyframe::updatePluginRenderer(*renderer, globalTime, sequence, *this);
+                visibleRendererMaterials.push_back(renderer->getMaterialPass());
+                if (track.keyframeIndex[j] >= 0)
+                {
+                    Keyframe::updatePluginRenderer(*renderer, globalTime, scene.keyframes[track.keyframeIndex[j]], *this);
                 }
             }
             else 
             {
-                auto rendererIt = rendererMap.find(seqId);
-                if (rendererIt == rendererMap.end()) {
-                    continue; // 找不到渲染器
-                }
-                auto renderer = rendererIt->second;
-        
-                std::shared_ptr<RendererResource> resource = renderer->getRendererResource();
-                std::shared_ptr<VideoResource> videoResource = std::dynamic_pointer_cast<VideoResource>(resource);
-                if (videoResource)
+                const auto& renderer = scene.videoRenderers[rendererIndex];
+                updateVideoFrame(track, j);
+
+                renderer->setRenderTarget(sequenceRenderTargetInfo);
+                visibleRenderers.push_back(rendererIndex);
+                visibleRendererMaterials.push_back(renderer->getMaterialPass());
+                if (track.keyframeIndex[j] >= 0)
                 {
-                    // 获取 originalTime
-                    double originalTime = trackUtils->getOriginalTime(globalTime, sequence);
-                    ScopedProfiler profilerVideoResource("sequence videoResource-》" + seqId);
-                    videoResource->getFrameAt(fmod(originalTime/1000.f, videoResource->getDuration()));
-                }
-        
-                if (isVisible) {
-                    renderer->setRenderTarget(sequenceRenderTargetInfo);
-                    visibleRenderers.insert(renderer);
-                    visibleRendererMaterials.push_back(renderer->getMaterialPass());
-                    Keyframe::updateRenderer(*renderer, globalTime, sequence, *this);
+                    Keyframe::updateRenderer(*renderer, globalTime, scene.keyframes[track.keyframeIndex[j]], *this);
                 }
             }
+        }
 
-            if (sequence.contains("transition"))
+        int currentTransition = -1;
+        for (int k : track.transitionWindowIndex.query(globalTime))
+        {
+            int transitionIndex = track.transitions[k];
+            double transitionTime = globalTime - scene.transitionStart[transitionIndex];
+            double transitionDuration = scene.transitionDuration[transitionIndex];
+            if (transitionTime >= 0 && transitionTime < transitionDuration)
             {
-                const auto& transition = sequence["transition"];
-                std::string transitionId = transition["id"];
-                auto transitionRendererIt = transitionRendererMap.find(transitionId);
-                if (transitionRendererIt == transitionRendererMap.end()) {
-                    continue; // 找不到渲染器
-                }
-                auto transitionRenderer = transitionRendererIt->second;
-
-                double transitionTime = trackUtils->getTransitionTime(globalTime, transition, sequence);
-                double transitionDuration = transition["duration"];
-                if (transitionTime >= 0 && transitionTime < transitionDuration)
-                {
-                    double time = transitionTime/transitionDuration;
-                    transitionRenderer->updateTime(time);
-                    currentTransitionRenderer = transitionRenderer;
-                }
+                double time = transitionTime/transitionDuration;
+                scene.transitionRenderers[transitionIndex]->updateTime(time);
+                currentTransition = transitionIndex;
             }
         }
 
-        if (currentTransitionRenderer)
+        if (currentTransition >= 0)
         {
+            const auto& currentTransitionRenderer = scene.transitionRenderers[currentTransition];
             RenderTargetInfo renderTargetInfo;
             currentTransitionRenderer->updateRenderTargetInfo(renderTargetInfo);
-            auto reuslt = visibleRenderers.find(currentTransitionRenderer->firstRenderer);
-            if (reuslt == visibleRenderers.end())
+            auto isRendered = [&](const std::shared_ptr<VideoRenderer>& renderer) {
+                for (int rendererIndex : visibleRenderers)
+                {
+                    if (scene.videoRenderers[rendererIndex] == renderer) return true;
+                }
+                return false;
+            };
+            // 转场两侧不可见的片段也需要当前时间的画面
+            int firstSequence = scene.transitionFirstSequence[currentTransition];
+            int secondSequence = scene.transitionSecondSequence[currentTransition];
+            if (!isRendered(currentTransitionRenderer->firstRenderer))
             {
+                if (firstSequence >= 0) updateVideoFrame(track, firstSequence);
                 visibleRendererMaterials.push_back(currentTransitionRenderer->firstRenderer->getMaterialPass());
             }
-            reuslt = visibleRenderers.find(currentTransitionRenderer->secondRenderer);
-            if (reuslt == visibleRenderers.end())
+            if (!isRendered(currentTransitionRenderer->secondRenderer))
             {
+                if (secondSequence >= 0) updateVideoFrame(track, secondSequence);
                 visibleRendererMaterials.push_back(currentTransitionRenderer->secondRenderer->getMaterialPass());
             }
             visibleRendererMaterials.push_back(currentTransitionRenderer->getMaterialPass());
@@ -284,24 +364,31 @@ bool Engine::render(FFmpegWriter& writer, const std::vector<std::vector<nlohmann
 
     // glBindFramebuffer(GL_FRAMEBUFFER, 0);
     // ① 绑定离屏 FBO
-    glBindFramebuffer(GL_FRAMEBUFFER, offscreenFbo);
-    glViewport(0, 0, renderTargetWidth, renderTargetHeight);
+    GLStateCache& state = GLStateCache::instance();
+    state.bindFramebuffer(GL_FRAMEBUFFER, offscreenFbo);
+    state.viewport(0, 0, renderTargetWidth, renderTargetHeight);
     // // ② 清屏
     // glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
     // glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 
     // 清除画布
-    glClearColor(0.0, 0.0, 0.0, 0.0);
+    state.clearColor(0.0, 0.0, 0.0, 0.0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // 启用深度测试
     // glEnable(GL_DEPTH_TEST);
     // glDepthFunc(GL_LEQUAL);
 
-    glEnable(GL_BLEND);
+    state.setBlendEnabled(true);
     setBlendingMode("normal");
 
+    UniformBlock::FrameData frameData{};
+    frameData.viewMatrix = camera->getViewMatrix();
+    frameData.projectionMatrix = camera->getProjectionMatrix();
+    frameData.canvasSize = glm::vec2(renderTargetWidth, renderTargetHeight);
+    renderPass->setFrameData(frameData);
+
     {
         ScopedProfiler profilerVideoResource("renderPass->render");
         //渲染机这里有报错，需要慢慢定位
@@ -312,52 +399,137 @@ bool Engine::render(FFmpegWriter& writer, const std::vector<std::vector<nlohmann
         // ScopedProfiler profilerVideoResource("ffpegWriter->writeFrame");
 
         // 绑定当前的PBO并启动异步读取
-        glBindFramebuffer(GL_FRAMEBUFFER, offscreenFbo);   // ← 加这一行
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, pboIds[index]);
-        glPixelStorei(GL_PACK_ALIGNMENT, 1);
-        glReadPixels(0, 0, renderTargetWidth, renderTargetHeight, GL_RGB, GL_UNSIGNED_BYTE, 0);
-
-        // 处理上一个PBO中的数据
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, pboIds[nextIndex]);
-        GLubyte* src = (GLubyte*)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
-        if (src) {
-            // 将像素数据直接传递给FFmpegWriter
-            if (!writer.pushFrame(src, renderTargetWidth, renderTargetHeight)) {
-                std::cerr << "编码队列已满，跳过该帧" << std::endl;
-            }
-            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        if (readbackYuv)
+        {
+            // 转换 pass 已经完成翻转，读回的 Y/U/V 平面直接拷贝进 AVFrame
+            yuvConverter->convert(offscreenColorTex);
+            readbackRing.acquire();
+            yuvConverter->readPlanes();
+        }
+        else
+        {
+            state.bindFramebuffer(GL_FRAMEBUFFER, offscreenFbo);   // ← 加这一行
+            readbackRing.acquire();
+            glPixelStorei(GL_PACK_ALIGNMENT, 1);
+            glReadPixels(0, 0, renderTargetWidth, renderTargetHeight, GL_RGB, GL_UNSIGNED_BYTE, 0);
         }
 
-        // 解绑PBO
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readbackRing.submit();
 
-        // 交换PBO索引
-        index = (index + 1) % 2;
-        nextIndex = (nextIndex + 1) % 2;
+        // 送出 GPU 已经完成读回的帧，未完成的留到之后的帧，不在这里等待
+        readbackRing.poll();
 
-        if (isDebug)
+        if (isDebug && window)
         {
-            // 把 offscreenFbo -> 0
-            int winW, winH;
-            glfwGetFramebufferSize(window, &winW, &winH);
-
-            glBindFramebuffer(GL_READ_FRAMEBUFFER, offscreenFbo);
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);          // 默认帧缓冲
-            glBlitFramebuffer(0, 0, renderTargetWidth, renderTargetHeight,
-                            0, 0, winW, winH,
-                            GL_COLOR_BUFFER_BIT, GL_LINEAR);
-
-            glfwSwapBuffers(window);
-            glfwPollEvents();
+            presentDebugWindow();
         }
     }
 
     return true;
 }
 
+bool Engine::isStaticFrame(const SceneModel& scene, double globalTime) {
+    activeClips.clear();
+    bool timeInvariant = hasPreviousFrame;
+    for (size_t i = 0; i < scene.tracks.size(); i++)
+    {
+        const auto& track = scene.tracks[i];
+        for (int j : track.visibilityIndex.query(globalTime))
+        {
+            if (!track.isVisibleAtTime(j, globalTime)) continue;
+            activeClips.emplace_back(static_cast<int>(i), j);
+            int rendererIndex = track.rendererIndex[j];
+            if (track.type[j] == SequenceType::Plugin)
+            {
+                if (scene.pluginRenderers[rendererIndex]->hasUniformTime) timeInvariant = false;
+            }
+            else if (scene.videoResources[rendererIndex])
+            {
+                timeInvariant = false;
+            }
+            int keyframeIndex = track.keyframeIndex[j];
+            if (keyframeIndex >= 0 && timeInvariant && !scene.keyframes[keyframeIndex].isConstantBetween(previousFrameTime, globalTime))
+            {
+                timeInvariant = false;
+            }
+        }
+        for (int k : track.transitionWindowIndex.query(globalTime))
+        {
+            int transitionIndex = track.transitions[k];
+            double transitionTime = globalTime - scene.transitionStart[transitionIndex];
+            if (transitionTime >= 0 && transitionTime < scene.transitionDuration[transitionIndex])
+            {
+                activeClips.emplace_back(-1, transitionIndex);
+                timeInvariant = false;
+            }
+        }
+    }
+
+    bool isStatic = timeInvariant && activeClips == previousActiveClips;
+    activeClips.swap(previousActiveClips);
+    previousFrameTime = globalTime;
+    hasPreviousFrame = true;
+    return isStatic;
+}
+
+void Engine::queueReadback(FFmpegWriter& writer, const uint8_t* src) {
+    // 读回缓冲映射失败：重复上一帧，丢帧会让之后的所有画面提前一帧，与音频错开
+    if (!src) {
+        if (!writer.pushRepeatFrame()) {
+            std::cerr << "送入编码队列失败，跳过该帧" << std::endl;
+        }
+        return;
+    }
+    // 将像素数据直接传递给FFmpegWriter
+    bool pushed = readbackYuv ? writer.pushYuvFrame(src, renderTargetWidth, renderTargetHeight)
+                              : writer.pushFrame(src, renderTargetWidth, renderTargetHeight);
+    if (!pushed) {
+        std::cerr << "送入编码队列失败，跳过该帧" << std::endl;
+    }
+}
+
+size_t Engine::readbackFrameSize() const {
+    if (readbackYuv) return yuvConverter->getFrameSize();
+    return static_cast<size_t>(renderTargetWidth) * renderTargetHeight * 3;
+}
+
+void Engine::presentDebugWindow() {
+    // 把 offscreenFbo -> 0
+    int winW, winH;
+    glfwGetFramebufferSize(window, &winW, &winH);
+
+    GLStateCache& state = GLStateCache::instance();
+    state.bindFramebuffer(GL_READ_FRAMEBUFFER, offscreenFbo);
+    state.bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);          // 默认帧缓冲
+    glBlitFramebuffer(0, 0, renderTargetWidth, renderTargetHeight,
+                    0, 0, winW, winH,
+                    GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+    glfwSwapBuffers(window);
+    glfwPollEvents();
+}
+
+// 收集材质图中所有 pass 引用的着色器（嵌套的依赖 pass 也包含在内）
+void Engine::collectShaderPrograms(const nlohmann::json& node, std::vector<std::pair<std::string, std::string>>& programs) {
+    if (node.is_object()) {
+        auto vertexShader = node.find("vertexShader");
+        auto fragmentShader = node.find("fragmentShader");
+        if (vertexShader != node.end() && fragmentShader != node.end() && vertexShader->is_string() && fragmentShader->is_string()) {
+            programs.emplace_back(vertexShader->get<std::string>(), fragmentShader->get<std::string>());
+        }
+    }
+    if (node.is_object() || node.is_array()) {
+        for (const auto& child : node) {
+            collectShaderPrograms(child, programs);
+        }
+    }
+}
+
 // 更新相机设置
 void Engine::updateCamera() {
-    glGenBuffers(1, &screenBuffer);
+    if (!screenBuffer) {
+        glGenBuffers(1, &screenBuffer);
+    }
 
     // 设置正交投影
     float aspect = renderTargetWidth / static_cast<float>(renderTargetHeight);
@@ -379,7 +551,7 @@ void Engine::updateCamera() {
          w, -h, 0.0f, 1.0f, 0.0f,
     };
 
-    glBindBuffer(GL_ARRAY_BUFFER, screenBuffer);
+    GLStateCache::instance().bindBuffer(GL_ARRAY_BUFFER, screenBuffer);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
 
     screenCamera->setOrthographic(-orthoWidth / 2.0f, orthoWidth / 2.0f, -orthoHeight / 2.0f, orthoHeight / 2.0f, 0.0f, 2000.0f);
@@ -435,6 +607,40 @@ void Engine::updateRenderer(std::shared_ptr<VideoRenderer> renderer, const nlohm
 }
 
 
+// 屏幕上的最大缩放低于源分辨率的这个比例时才降低解码分辨率，接近原尺寸时缩放本身不划算
+static const double kScaledDecodeThreshold = 0.75;
+// 关键帧缓动可能在两个关键帧之间越过端点的取值，按这个间隔（毫秒）采样可见区间
+static const double kDisplayScaleSampleMs = 1000.0 / 30.0;
+static const int kMaxDisplayScaleSamples = 4096;
+
+double Engine::getMaxDisplayScale(const nlohmann::json& sequence, const VideoResource& resource) {
+    // 静态缩放与 updateRenderer 一致：适配画布后再乘 adjust.scale
+    const auto& adjustScale = sequence["adjust"]["scale"];
+    std::array<float, 2> sequenceScale = {adjustScale["x"].get<float>(), adjustScale["y"].get<float>()};
+    glm::vec3 scale = trackUtils->getSequenceScale(static_cast<float>(resource.getHeight()), static_cast<float>(renderTargetHeight),
+                                                   static_cast<float>(resource.getWidth()), static_cast<float>(renderTargetWidth), sequenceScale);
+    // 旋转后屏幕上的横向可能对应源的纵向，两个方向取较大的缩放
+    double maxScale = std::max(std::fabs(scale.x), std::fabs(scale.y));
+
+    // 缩放关键帧与 Keyframe::updateRendererAdjust 一致：取值直接作为缩放，缺少的一个方向为 1
+    SequenceKeyframes keyframes = SequenceKeyframes::compile(sequence);
+    if (keyframes.hasKeyframe && (keyframes.scaleX.isNumber() || keyframes.scaleY.isNumber())) {
+        const auto& timer = sequence["timer"];
+        double start = timer.value("offset", 0.0);
+        double rate = timer.value("rate", 1.0);
+        double duration = timer.value("duration", 0.0) * (timer.value("originalDuration", 0.0) / (rate > 0.0 ? rate : 1.0));
+        int samples = static_cast<int>(std::ceil(duration / kDisplayScaleSampleMs));
+        samples = std::min(std::max(samples, 1), kMaxDisplayScaleSamples);
+        for (int i = 0; i <= samples; i++) {
+            double time = start + duration * i / samples;
+            double x = keyframes.scaleX.isNumber() ? keyframes.scaleX.evaluateNumber(time) : 1.0;
+            double y = keyframes.scaleY.isNumber() ? keyframes.scaleY.evaluateNumber(time) : 1.0;
+            maxScale = std::max(maxScale, std::max(std::fabs(x), std::fabs(y)));
+        }
+    }
+    return maxScale;
+}
+
 // 定义一个函数来判断文件是否为视频资源
 bool Engine::isVideoResource(const std::string& filePath) {
     // 定义支持的视频文件扩展名（小写）
@@ -470,10 +676,35 @@ void Engine::UpdateTracks(const nlohmann::json& tracksJsons) {
 
     std::map<std::string, std::shared_ptr<RendererResource>> rendererResourceMap;
 
-    rendererMap.clear();
-    sequences.clear();
-    transitionRendererMap.clear();
-    pluginRendererMap.clear();
+    // 同一路径的视频、图片在片段之间共享解码器和纹理
+    ResourceRegistry resourceRegistry([this](const std::string& path) -> std::shared_ptr<VideoResource> {
+        if (asyncVideoDecode) {
+            return std::make_shared<AsyncVideoResource>(path);
+        }
+        return std::make_shared<VideoResource>(path);
+    });
+
+    // 上一个任务的视频资源留给本任务按路径复用（常驻服务模式），解复用器、解码器和纹理都不必重新创建
+    std::set<VideoResource*> offeredVideoResources;
+    for (const auto& [id, renderer] : rendererMap)
+    {
+        auto videoResource = std::dynamic_pointer_cast<VideoResource>(renderer->getRendererResource());
+        // 解码方式变了的资源不复用；共享的资源只登记一次
+        bool isAsync = std::dynamic_pointer_cast<AsyncVideoResource>(videoResource) != nullptr;
+        if (videoResource && isAsync == asyncVideoDecode && offeredVideoResources.insert(videoResource.get()).second)
+        {
+            resourceRegistry.addReusable(videoResource);
+        }
+    }
+
+    // 共享的视频按所有使用者中最大的屏幕缩放解码，解码尺寸在所有片段创建完之后统一设置
+    struct VideoDecodeRequest {
+        double scale = 0.0;
+        std::vector<std::shared_ptr<VideoRenderer>> renderers;
+    };
+    std::map<std::shared_ptr<VideoResource>, VideoDecodeRequest> videoDecodeRequests;
+
+    clearTracks();
     // 按顺序迭代 tracks
     const nlohmann::json& tracks = tracksJsons["tracks"];
     for (int i = static_cast<int>(tracks.size()) - 1; i >= 0;i--)
@@ -491,8 +722,17 @@ void Engine::UpdateTracks(const nlohmann::json& tracksJsons) {
         }
 
         std::vector<nlohmann::json> sequenceArray;
+        // 上一个片段尾部转场的时长，即本片段处在转场后半段的时长
+        double previousTransitionDuration = 0.0;
         // 迭代 sequences
         for (const auto& sequence : trackJson["sequences"]) {
+            double leadInTransition = previousTransitionDuration;
+            double tailTransition = 0.0;
+            if (sequence.contains("transition") && sequence["transition"].is_object()) {
+                tailTransition = sequence["transition"].value("duration", 0.0);
+            }
+            previousTransitionDuration = tailTransition;
+            bool inTransition = leadInTransition > 0.0 || sequence.contains("transition");
             if (!sequence.contains("id")) continue;
 
             std::string seqId = sequence["id"].get<std::string>();
@@ -517,11 +757,12 @@ void Engine::UpdateTracks(const nlohmann::json& tracksJsons) {
                 if (trackType == "graphic") {
                     if (isVideoResource(resourcePath))
                     {
-                        resource = std::make_shared<VideoResource>(resourcePath);
+                        auto usage = ResourceRegistry::VideoUsage::fromSequence(sequence, leadInTransition, tailTransition);
+                        resource = resourceRegistry.acquireVideo(resourcePath, sequence["resource"].value("rotate", 0), usage);
                     }
                     else 
                     {
-                        resource = std::make_shared<ImageResource>(resourcePath);
+                        resource = resourceRegistry.acquireImage(resourcePath);
                     }
                 } else if (trackType == "text") {
                     std::optional<std::array<double, 4>> color = CoreUtils::convertHexToColorArray(sequence["resource"].value("color", "#db1116ff"));
@@ -542,6 +783,24 @@ void Engine::UpdateTracks(const nlohmann::json& tracksJsons) {
                 bool initialized = renderer->initialize(sequence["resource"].value("rotate", 0), sequenceRenderTargetInfo);
 
                 if (initialized && renderer) {
+                    auto videoResource = std::dynamic_pointer_cast<VideoResource>(resource);
+                    // 视频片段的音频，轨道静音（audioDisable）时跳过
+                    AudioClip audioClip;
+                    if (videoResource && !trackJson.value("audioDisable", false) &&
+                        AudioClip::fromSequence(resourcePath, sequence, audioClip)) {
+                        audioClips.push_back(audioClip);
+                    }
+                    if (videoResource) {
+                        // 插件和转场可能放大或按像素采样画面，这类片段保持源分辨率
+                        bool hasPlugins = sequence.contains("plugins") && sequence["plugins"].is_array() && !sequence["plugins"].empty();
+                        double decodeScale = 1.0;
+                        if (scaledVideoDecode && !hasPlugins && !inTransition) {
+                            decodeScale = getMaxDisplayScale(sequence, *videoResource);
+                        }
+                        VideoDecodeRequest& request = videoDecodeRequests[videoResource];
+                        request.scale = std::max(request.scale, decodeScale);
+                        request.renderers.push_back(renderer);
+                    }
                     // 添加到新的渲染器映射表
                     rendererMap[seqId] = renderer;
                     // 添加到新的序列列表
@@ -555,6 +814,10 @@ void Engine::UpdateTracks(const nlohmann::json& tracksJsons) {
                         rendererResourceMap["textureResourceId:" + resourceId] = resource;
                     }
                 }
+                else
+                {
+                    resourceRegistry.discard(resource);
+                }
             }
         }
         sequences.push_back(sequenceArray);
@@ -580,6 +843,21 @@ void Engine::UpdateTracks(const nlohmann::json& tracksJsons) {
         }
     }
 
+    resourceRegistry.logStats();
+
+    for (auto& [videoResource, request] : videoDecodeRequests)
+    {
+        // 解码尺寸变化时纹理会换成新的对象，共享它的所有片段都要更新
+        GLuint oldTexture = videoResource->getTexture();
+        videoResource->setDecodeScale(request.scale < kScaledDecodeThreshold ? request.scale : 1.0);
+        if (videoResource->getTexture() != oldTexture)
+        {
+            for (const auto& renderer : request.renderers)
+            {
+                Material::updateTextrue(renderer->getMaterialPass(), oldTexture, videoResource->getTexture());
+            }
+        }
+    }
 
     // // 更新渲染器映射和序列列表
     // rendererMap = newRendererMap;
@@ -653,6 +931,25 @@ void Engine::UpdateTracks(const nlohmann::json& tracksJsons) {
     }
     shaderManager->setExtendShader(materialData["shaders"]);
 
+    // 渲染开始前编译好本任务用到的全部程序，避免首帧和转场帧卡顿
+    {
+        ScopedProfiler profiler("Engine::UpdateTracks shader warm-up");
+        shaderManager->setBinaryCacheDirectory(tracksJsons.value("shaderCacheDir", ShaderManager::defaultBinaryCacheDirectory()));
+        std::vector<std::pair<std::string, std::string>> programs = {
+            {Stand.vertexShader, Stand.fragmentShader},
+            {StandBatchRenderer::kVertexShader, StandBatchRenderer::kFragmentShader},
+            {Blit.vertexShader, Blit.fragmentShader},
+            {Outline.vertexShader, Outline.fragmentShader},
+            {YuvConverter::kVertexShader, YuvConverter::kLumaFragmentShader},
+            {YuvConverter::kVertexShader, YuvConverter::kChromaFragmentShader},
+            {YuvTexture::kVertexShader, YuvTexture::kFragmentShader},
+        };
+        if (materialData.contains("materialPasses")) {
+            collectShaderPrograms(materialData["materialPasses"], programs);
+        }
+        shaderManager->warmUp(programs);
+    }
+
 
     for (size_t i = 0; i < sequences.size(); i++)
     {
@@ -669,29 +966,40 @@ void Engine::UpdateTracks(const nlohmann::json& tracksJsons) {
             updateRenderer(renderer, sequence);
         }
     }
+
+    // 把时间轴编译成场景模型，逐帧渲染不再遍历 JSON
+    sceneModel = SceneModel::compile(sequences, rendererMap, pluginRendererMap, transitionRendererMap);
+
+    // 本任务没有用到的文本渲染目标不再保留
+    RenderTargetPool::instance().releaseCachedRenderTargets();
 }
 
 // 播放序列
-void Engine::Play(double startTime, double endTime, double stepTime, bool isDebug, std::string outputPath, int fps, int mBitRate) {
+bool Engine::Play(double startTime, double endTime, double stepTime, bool isDebug, std::string outputPath, int fps, int mBitRate) {
     FFmpegWriter writer(outputPath, renderTargetWidth, renderTargetHeight, fps, mBitRate); // 仅构造函数，不再调用 initialize
+    writer.setColorRange(outputFullRange);
+    writer.setEncoderProfile(encoderProfile);
+    if (!audioClips.empty()) {
+        // 输出第 0 帧对应全局时间 startTime + stepTime，音频从同一时间开始
+        writer.setAudioMixer(std::make_unique<AudioMixer>(audioClips, (startTime + stepTime) * 1000.0, 48000, 2));
+    }
     if (!writer.initialize(outputPath)) { // 初始化必须调用
         std::cerr << "初始化 FFmpeg Writer 失败" << std::endl;
-        return;
+        return false;
     }
     writer.startEncoding();
 
-    // 在初始化时创建两个PBO（双缓冲）
-    GLuint pboIds[2];
-    glGenBuffers(2, pboIds);
-    for (int i = 0; i < 2; ++i) {
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, pboIds[i]);
-        glBufferData(GL_PIXEL_PACK_BUFFER, renderTargetWidth * renderTargetHeight * 3, nullptr, GL_STREAM_READ);
-    }
-    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readbackYuv = yuvConverter->isAvailable();
+    yuvConverter->setFullRange(outputFullRange);
 
-    int index = 0;
-    int nextIndex = 1;
+    // 在初始化时创建 readbackDepth 块PBO，GPU 最多落后这么多帧渲染线程才需要等待
+    ReadbackRing readbackRing(readbackDepth, readbackFrameSize(), [&](const uint8_t* data) {
+        queueReadback(writer, data);
+    });
 
+    hasPreviousFrame = false;
+    staticFrameCount = 0;
+    renderedFrameCount = 0;
 
     currentTime = startTime;
     {
@@ -699,8 +1007,10 @@ void Engine::Play(double startTime, double endTime, double stepTime, bool isDebu
         // 播放循环
         while (currentTime < endTime) {
             currentTime += stepTime;
-            render(writer, sequences, index,  nextIndex, pboIds, isDebug);
+            render(writer, sceneModel, readbackRing, isDebug);
         }
+        // 最后几帧还在读回环中
+        readbackRing.drain();
     }
 
     {
@@ -712,5 +1022,11 @@ void Engine::Play(double startTime, double endTime, double stepTime, bool isDebu
         writer.finalize();
     }
 
-    glfwTerminate();
+    readbackRing.logReport();
+    RenderTargetPool::instance().logMemoryReport();
+    GLStateCache::instance().logCounters();
+    UniformBlock::logCounters();
+    renderPass->logMemoizationReport();
+    std::clog << "静态帧（重复上一帧）/渲染帧: " << staticFrameCount << "/" << renderedFrameCount << std::endl;
+    return true;
 }
\ No newline at end of file
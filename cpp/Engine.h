@@ -14,6 +14,7 @@
 
 // 包含依赖类的头文件
 #include "TrackUtils.h"
+#include "SceneModel.h"
 #include "CoreUtils.h"
 #include "src/ShaderManager.h"
 #include "src/RenderPass.h"
@@ -23,20 +24,42 @@
 #include "src/PluginRenderer.h"
 #include "src/FFmpegWriter.h"
 #include "src/Materials.h"
+#include "src/GLContext.h"
+#include "src/YuvConverter.h"
+
+class ReadbackRing;
+class VideoResource;
 
 class Engine {
 public:
     Engine();
     ~Engine();
 
-    bool Init(int width, int height, float globalRenderScale, bool isVisible);
+    // backend 选择 OpenGL 上下文：Auto 时调试预览用 GLFW 窗口，否则用 EGL 离屏上下文
+    bool Init(int width, int height, float globalRenderScale, bool isVisible, GLContextBackend backend = GLContextBackend::Auto);
+    // 常驻服务模式下每个任务开始前调用：画布尺寸变化时重建离屏帧缓冲，着色器、字体和渲染目标池保持不变
+    bool Prepare(int width, int height, float globalRenderScale);
+    // 读取任务 JSON 中与画布无关的设置（colorRange、readbackDepth、asyncDecode、scaledDecode、encoder），命令行和常驻服务共用
+    void applyJobSettings(const nlohmann::json& tracksJson);
     void UpdateTracks(const nlohmann::json& tracksJson);
-    void Play(double startTime, double endTime, double stepTime, bool isDebug, std::string outputPath, int fps, int mBitRate);
+    bool Play(double startTime, double endTime, double stepTime, bool isDebug, std::string outputPath, int fps, int mBitRate);
+    // 释放所有 GL 资源并销毁上下文（析构时自动调用）
+    void Shutdown();
 
     GLuint getNdcBuffer() const { return ndcBuffer; };
     RenderTargetInfo getSequenceRenderTargetInfo() { return sequenceRenderTargetInfo; };
     int getRenderTargetWidth() const { return renderTargetWidth; };
     int getRenderTargetHeight() const { return renderTargetHeight; };
+    // 输出视频使用完整范围（0-255）还是有限范围的 BT.709 YUV，下一次 Play 生效
+    void setOutputFullRange(bool fullRange) { outputFullRange = fullRange; };
+    // 异步读回的 PBO 块数（至少 1），下一次 Play 生效
+    void setReadbackDepth(int depth) { readbackDepth = depth < 1 ? 1 : depth; };
+    // 编码器配置，下一次 Play 生效
+    void setEncoderProfile(const EncoderProfile& profile) { encoderProfile = profile; };
+    // 视频片段在各自的后台线程解码（默认），或在渲染线程同步解码；下一次 UpdateTracks 生效
+    void setAsyncVideoDecode(bool async) { asyncVideoDecode = async; };
+    // 按视频片段在屏幕上的最大尺寸降低解码和上传的分辨率（默认开启）；下一次 UpdateTracks 生效
+    void setScaledVideoDecode(bool scaled) { scaledVideoDecode = scaled; };
 
     std::unique_ptr<RenderPass> renderPass;
     float globalRenderScale = 1.0f;
@@ -47,6 +70,8 @@ private:
     std::map<std::string, std::shared_ptr<TransitionRenderer>> transitionRendererMap;
     std::map<std::string, std::shared_ptr<PluginRenderer>> pluginRendererMap;
     std::vector<std::vector<nlohmann::json>> sequences; // 直接使用 JSON 对象
+    SceneModel sceneModel; // 由 sequences 编译出的逐帧渲染数据
+    std::vector<AudioClip> audioClips; // 可见轨道上视频片段的音频，Play 时交给编码器混音
 
     std::shared_ptr<Camera> camera;
     std::shared_ptr<Camera> screenCamera;
@@ -61,18 +86,50 @@ private:
     RenderTargetInfo defaultRenderTargetInfo;
     std::shared_ptr<Material> finalBlitMaterial;
 
-    GLFWwindow* window;
+    std::unique_ptr<GLContext> glContext;
+    GLFWwindow* window = nullptr; // 只有窗口后端才有，用于调试预览
 
     // 离屏渲染资源
     GLuint offscreenFbo = 0;
     GLuint offscreenColorTex = 0;
     GLuint offscreenDepthRb  = 0;
+
+    // 读回前在 GPU 上转换为 YUV420P；不可用时读回 RGB，由编码线程转换
+    std::unique_ptr<YuvConverter> yuvConverter;
+    bool readbackYuv = false;
+    bool outputFullRange = false;
+    // 读回环的 PBO 块数
+    int readbackDepth = 3;
+    EncoderProfile encoderProfile;
+    bool asyncVideoDecode = true;
+    bool scaledVideoDecode = true;
+
+    // 静态帧检测：上一帧的活动片段（轨道下标, 片段下标；转场记为 (-1, 转场下标)）和时间
+    std::vector<std::pair<int, int>> activeClips;
+    std::vector<std::pair<int, int>> previousActiveClips;
+    double previousFrameTime = 0.0;
+    bool hasPreviousFrame = false;
+    int staticFrameCount = 0;
+    int renderedFrameCount = 0;
     
     // 辅助方法
+    bool createCanvas(int width, int height);
+    void destroyCanvas();
+    void clearTracks();
     void setBlendingMode(const std::string& mode);
-    bool render(FFmpegWriter& writer, const std::vector<std::vector<nlohmann::json>>& sequences, int& index, int& nextIndex, GLuint pboIds[2], bool isDebug);
+    bool render(FFmpegWriter& writer, const SceneModel& scene, ReadbackRing& readbackRing, bool isDebug);
+    // 根据编译后的时间轴判断当前帧是否与上一帧画面完全相同：活动片段不变，且没有视频、随时间变化的插件、转场，关键帧取值也不变
+    bool isStaticFrame(const SceneModel& scene, double globalTime);
+    // 把读回环交付的像素送入编码器，src 为 nullptr（映射失败）时重复上一帧
+    void queueReadback(FFmpegWriter& writer, const uint8_t* src);
+    // 每帧读回的字节数：YUV420P 或 RGB24
+    size_t readbackFrameSize() const;
+    void presentDebugWindow();
     void updateCamera();
+    static void collectShaderPrograms(const nlohmann::json& node, std::vector<std::pair<std::string, std::string>>& programs);
     void updateRenderer(std::shared_ptr<VideoRenderer> renderer, const nlohmann::json& sequence);
+    // 视频片段在可见区间内相对源分辨率的最大缩放（屏幕像素 / 源像素），考虑缩放关键帧
+    double getMaxDisplayScale(const nlohmann::json& sequence, const VideoResource& resource);
     bool isVideoResource(const std::string& filePath);
 };
 
@@ -0,0 +1,119 @@
+// IntervalIndex.cpp
+#include "IntervalIndex.h"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+// 单次查询中游标最多逐个推进的区间数，超过则直接二分定位
+static const size_t kMaxIncrementalStep = 32;
+
+void IntervalIndex::build(const std::vector<double>& starts, const std::vector<double>& ends) {
+    this->starts = starts;
+    this->ends = ends;
+
+    size_t n = starts.size();
+    byStart.resize(n);
+    std::iota(byStart.begin(), byStart.end(), 0);
+    std::stable_sort(byStart.begin(), byStart.end(), [&](int a, int b) { return starts[a] < starts[b]; });
+
+    byEnd.resize(n);
+    std::iota(byEnd.begin(), byEnd.end(), 0);
+    std::stable_sort(byEnd.begin(), byEnd.end(), [&](int a, int b) { return ends[a] < ends[b]; });
+
+    treeSize = 1;
+    while (treeSize < n)
+    {
+        treeSize *= 2;
+    }
+    sortedStarts.resize(n);
+    maxEndTree.assign(2 * treeSize, -std::numeric_limits<double>::infinity());
+    sortedEnds.resize(n);
+    for (size_t i = 0; i < n; i++)
+    {
+        sortedStarts[i] = starts[byStart[i]];
+        maxEndTree[treeSize + i] = ends[byStart[i]];
+        sortedEnds[i] = ends[byEnd[i]];
+    }
+    for (size_t node = treeSize - 1; node > 0; node--)
+    {
+        maxEndTree[node] = std::max(maxEndTree[2 * node], maxEndTree[2 * node + 1]);
+    }
+
+    startCursor = 0;
+    endCursor = 0;
+    hasQueried = false;
+    active.clear();
+}
+
+void IntervalIndex::clear() {
+    build({}, {});
+}
+
+const std::vector<int>& IntervalIndex::query(double time) const {
+    if (!hasQueried || time < lastTime)
+    {
+        seek(time);
+    }
+    else
+    {
+        size_t target = std::upper_bound(sortedStarts.begin() + startCursor, sortedStarts.end(), time) - sortedStarts.begin();
+        if (target - startCursor > kMaxIncrementalStep)
+        {
+            seek(time);
+        }
+        else
+        {
+            advance(time);
+        }
+    }
+    hasQueried = true;
+    lastTime = time;
+    return active;
+}
+
+// 随机访问：二分出两个游标的位置，再在起点 <= time 的区间中用最大终点树找出仍然覆盖 time 的区间，
+// 开销为 O((k + 1) log n)，k 为活动区间数
+void IntervalIndex::seek(double time) const {
+    startCursor = std::upper_bound(sortedStarts.begin(), sortedStarts.end(), time) - sortedStarts.begin();
+    endCursor = std::lower_bound(sortedEnds.begin(), sortedEnds.end(), time) - sortedEnds.begin();
+
+    active.clear();
+    if (startCursor > 0)
+    {
+        collectCovering(1, 0, treeSize, startCursor, time);
+    }
+    std::sort(active.begin(), active.end());
+}
+
+void IntervalIndex::collectCovering(size_t node, size_t nodeBegin, size_t nodeSize, size_t limit, double time) const {
+    if (nodeBegin >= limit || maxEndTree[node] < time)
+    {
+        return;
+    }
+    if (nodeSize == 1)
+    {
+        active.push_back(byStart[nodeBegin]);
+        return;
+    }
+    size_t half = nodeSize / 2;
+    collectCovering(2 * node, nodeBegin, half, limit, time);
+    collectCovering(2 * node + 1, nodeBegin + half, half, limit, time);
+}
+
+// 顺序播放：先加入新开始的区间，再移除已经结束的区间
+void IntervalIndex::advance(double time) const {
+    while (startCursor < byStart.size() && sortedStarts[startCursor] <= time)
+    {
+        int interval = byStart[startCursor++];
+        active.insert(std::lower_bound(active.begin(), active.end(), interval), interval);
+    }
+    while (endCursor < byEnd.size() && sortedEnds[endCursor] < time)
+    {
+        int interval = byEnd[endCursor++];
+        auto it = std::lower_bound(active.begin(), active.end(), interval);
+        if (it != active.end() && *it == interval)
+        {
+            active.erase(it);
+        }
+    }
+}
@@ -0,0 +1,47 @@
+// IntervalIndex.h
+#ifndef INTERVAL_INDEX_H
+#define INTERVAL_INDEX_H
+
+#include <cstddef>
+#include <vector>
+
+// 时间区间索引：查询某一时刻覆盖它的全部闭区间 [start, end]
+// 顺序播放时用起止两个游标增量维护活动集合，时间回退或大幅跳跃时改用二分查找重新定位，
+// 每帧开销只与活动区间数量相关，而不是与区间总数相关
+class IntervalIndex {
+public:
+    void build(const std::vector<double>& starts, const std::vector<double>& ends);
+    void clear();
+
+    // 返回在 time 时刻活动的区间下标（按 build 时的原始顺序升序排列）
+    const std::vector<int>& query(double time) const;
+
+    size_t size() const { return starts.size(); }
+
+private:
+    void seek(double time) const;
+    void advance(double time) const;
+    // 把 byStart 中位置 < limit 且终点 >= time 的区间加入 active；node 覆盖位置 [nodeBegin, nodeBegin + nodeSize)
+    void collectCovering(size_t node, size_t nodeBegin, size_t nodeSize, size_t limit, double time) const;
+
+    std::vector<double> starts;
+    std::vector<double> ends;
+
+    std::vector<int> byStart;           // 按起点排序的区间下标
+    std::vector<double> sortedStarts;   // 与 byStart 对齐的起点
+    // 按 byStart 顺序建立的最大终点树（下标 1 为根，叶子从 treeSize 开始），随机访问时只进入最大终点仍覆盖 time 的子树，
+    // 前面有一个贯穿全片的长区间（背景层）时也不必逐个回溯
+    std::vector<double> maxEndTree;
+    size_t treeSize = 0;
+    std::vector<int> byEnd;             // 按终点排序的区间下标
+    std::vector<double> sortedEnds;     // 与 byEnd 对齐的终点
+
+    // 查询状态（属于缓存，不影响查询结果）
+    mutable size_t startCursor = 0;     // 起点 <= 上次查询时间的区间数
+    mutable size_t endCursor = 0;       // 终点 <  上次查询时间的区间数
+    mutable double lastTime = 0.0;
+    mutable bool hasQueried = false;
+    mutable std::vector<int> active;
+};
+
+#endif // INTERVAL_INDEX_H
@@ -10,97 +10,139 @@
 #include "src/ScopedProfiler.h"
 
 
-nlohmann::json Keyframe::getKeyframeValue(const nlohmann::json& keyframeArray, double globalTime, Engine& engine) {
-    if (!keyframeArray.is_array() || keyframeArray.empty())
-        return {};
-
-    const nlohmann::json* preKeyframe = nullptr;
+bool SequenceKeyframes::isAnimated() const {
+    if (hasKeyframe) return true;
+    for (const auto& plugin : plugins) {
+        if (!plugin.isEmpty && plugin.hasKeyframe) return true;
+    }
+    return false;
+}
 
-    for (const auto& keyframe : keyframeArray) {
-        if (!keyframe.contains("offset") || !keyframe.contains("value") || !keyframe.contains("type"))
-            continue; // 忽略无效关键帧
+bool SequenceKeyframes::isConstantBetween(double a, double b) const {
+    if (hasKeyframe) {
+        for (const KeyframeCurve* curve : {&transformX, &transformY, &rotate, &scaleX, &scaleY, &opacity,
+                                           &fontSize, &strokeWidth, &color, &strokeColor}) {
+            if (!curve->isConstantBetween(a, b)) return false;
+        }
+    }
+    for (const auto& plugin : plugins) {
+        if (plugin.isEmpty || !plugin.hasKeyframe) continue;
+        for (const auto& control : plugin.controls) {
+            if (!control.curve.isConstantBetween(a, b)) return false;
+            for (const auto& curve : control.elementCurves) {
+                if (!curve.isConstantBetween(a, b)) return false;
+            }
+        }
+    }
+    return true;
+}
 
-        double offset = keyframe["offset"].get<double>();
+// 读取关键帧对象中 key 对应的曲线，不存在或不是数组时返回空曲线
+static KeyframeCurve compileCurve(const nlohmann::json& keyframeObject, const std::string& key) {
+    auto it = keyframeObject.find(key);
+    if (it == keyframeObject.end() || !it->is_array()) return KeyframeCurve();
+    return KeyframeCurve(*it);
+}
 
-        if (globalTime < offset) {
-            if (!preKeyframe) {
-                // 如果这是第一个关键帧且当前时间小于第一个关键帧的offset，直接返回当前关键帧值
-                return keyframe["value"];
-            } else {
-                // 获取当前关键帧和前一个关键帧的值
-                auto curValJson = keyframe["value"];
-                auto preValJson = (*preKeyframe)["value"];
+SequenceKeyframes SequenceKeyframes::compile(const nlohmann::json& sequence) {
+    SequenceKeyframes keyframes;
+    keyframes.id = sequence.value("id", "");
+    keyframes.isText = sequence.value("type", "") == "text";
 
-                // 尝试转换成颜色数组
-                std::optional<std::array<double, 4>> curColorOpt, preColorOpt;
+    if (sequence.contains("keyframe") && Keyframe::isPlainNoEmptyObject(sequence["keyframe"])) {
+        const auto& kf = sequence["keyframe"];
+        keyframes.hasKeyframe = true;
+        keyframes.transformX = compileCurve(kf, "adjust.transform.x");
+        keyframes.transformY = compileCurve(kf, "adjust.transform.y");
+        keyframes.rotate = compileCurve(kf, "adjust.rotate");
+        keyframes.scaleX = compileCurve(kf, "adjust.scale.x");
+        keyframes.scaleY = compileCurve(kf, "adjust.scale.y");
+        keyframes.opacity = compileCurve(kf, "adjust.opacity");
+        keyframes.fontSize = compileCurve(kf, "resource.fontSize");
+        keyframes.strokeWidth = compileCurve(kf, "resource.strokeWidth");
+        keyframes.color = compileCurve(kf, "resource.color");
+        keyframes.strokeColor = compileCurve(kf, "resource.strokeColor");
+    }
 
-                if (curValJson.is_string())
-                    curColorOpt = CoreUtils::convertHexToColorArray(curValJson.get<std::string>());
-                if (preValJson.is_string())
-                    preColorOpt = CoreUtils::convertHexToColorArray(preValJson.get<std::string>());
+    if (keyframes.isText && sequence.contains("resource") && sequence["resource"].is_object()) {
+        const auto& sequenceResource = sequence["resource"];
+        keyframes.textPath = sequenceResource.value("absolutePath", "");
+        keyframes.text = sequenceResource.value("text", "xxx");
+        keyframes.strokeEnabled = sequenceResource.value("strokeEnabled", false);
+        keyframes.baseFontSize = sequenceResource.value("fontSize", 60);
+        keyframes.baseStrokeWidth = sequenceResource.value("strokeWidth", 0);
+        keyframes.baseColor = CoreUtils::convertHexToColorArray(sequenceResource.value("color", "#db1116ff"));
+        keyframes.baseStrokeColor = CoreUtils::convertHexToColorArray(sequenceResource.value("strokeColor", "#db1116ff"));
+    }
 
-                double factor = (globalTime - (*preKeyframe)["offset"].get<double>()) /
-                                (offset - (*preKeyframe)["offset"].get<double>());
+    if (sequence.contains("plugins") && sequence["plugins"].is_array()) {
+        for (const auto& plugin : sequence["plugins"]) {
+            PluginKeyframes pluginKeyframes;
+            pluginKeyframes.isEmpty = !Keyframe::isPlainNoEmptyObject(plugin);
+            if (!pluginKeyframes.isEmpty) {
+                pluginKeyframes.id = plugin.value("id", "");
+                const nlohmann::json emptyObject = nlohmann::json::object();
+                const auto& kf = plugin.contains("keyframe") && plugin["keyframe"].is_object() ? plugin["keyframe"] : emptyObject;
+                pluginKeyframes.hasKeyframe = !kf.empty();
 
-                if (curColorOpt && preColorOpt && curColorOpt->size() == preColorOpt->size()) {
-                    // 颜色插值
-                    std::vector<double> interpolated(curColorOpt->size());
-                    for (size_t i = 0; i < interpolated.size(); i++) {
-                        interpolated[i] = factor * ((*curColorOpt)[i] - (*preColorOpt)[i]) + (*preColorOpt)[i];
+                if (plugin.contains("control") && plugin["control"].is_object()) {
+                    for (auto& [key, value] : plugin["control"].items()) {
+                        ControlKeyframes control;
+                        control.name = "control_" + key;
+                        control.staticValue = ExpressTool::convertJsonValueToUniformValue(value);
+                        if (value.is_array()) {
+                            control.isArray = true;
+                            for (size_t i = 0; i < value.size(); ++i) {
+                                control.elementValues.push_back(value[i].is_number() ? value[i].get<float>() : 0.0f);
+                                control.elementCurves.push_back(compileCurve(kf, "control." + key + "[" + std::to_string(i) + "]"));
+                            }
+                        } else {
+                            control.curve = compileCurve(kf, "control." + key);
+                        }
+                        pluginKeyframes.controls.push_back(std::move(control));
                     }
-                    return CoreUtils::convertColorArrayToHex(interpolated);
-                } else if (curValJson.is_number() && preValJson.is_number()) {
-                    // 数值插值
-                    double curNum = curValJson.get<double>();
-                    double preNum = preValJson.get<double>();
-                    double interpolatedNum = factor * (curNum - preNum) + preNum;
-                    return interpolatedNum;
-                } else {
-                    // 类型不匹配或无法插值时直接返回前一个值
-                    return preValJson;
                 }
             }
+            keyframes.plugins.push_back(std::move(pluginKeyframes));
         }
-        preKeyframe = &keyframe;
     }
 
-    // 如果globalTime超过所有关键帧，返回最后一个关键帧的值
-    return (*preKeyframe)["value"];
+    return keyframes;
 }
 
-void Keyframe::updateRendererAdjust(VideoRenderer& renderer, double globalTime, const nlohmann::json& sequence, Engine& engine) {
+
+void Keyframe::updateRendererAdjust(VideoRenderer& renderer, double globalTime, const SequenceKeyframes& keyframes, Engine& engine) {
     // ScopedProfiler profiler("Keyframe::updateRendererAdjust " + renderer.getName());
 
-    if (!sequence.contains("keyframe") || !sequence["keyframe"].is_object()) return;
-    auto kf = sequence["keyframe"];
-    
-    if (kf.contains("adjust.transform.x") && kf["adjust.transform.x"].is_array()) {
-        double x = getKeyframeValue(kf["adjust.transform.x"], globalTime, engine).get<double>();
+    if (!keyframes.hasKeyframe) return;
+
+    if (keyframes.transformX.isNumber()) {
+        double x = keyframes.transformX.evaluateNumber(globalTime);
         renderer.position.x = static_cast<float>(x * engine.getRenderTargetWidth());
     }
     
-    if (kf.contains("adjust.transform.y") && kf["adjust.transform.y"].is_array()) {
-        double y = getKeyframeValue(kf["adjust.transform.y"], globalTime, engine).get<double>();
+    if (keyframes.transformY.isNumber()) {
+        double y = keyframes.transformY.evaluateNumber(globalTime);
         renderer.position.y = static_cast<float>(-y * engine.getRenderTargetHeight());
     }
     
-    if (kf.contains("adjust.rotate") && kf["adjust.rotate"].is_array()) {
-        double rotate = getKeyframeValue(kf["adjust.rotate"], globalTime, engine).get<double>();
+    if (keyframes.rotate.isNumber()) {
+        double rotate = keyframes.rotate.evaluateNumber(globalTime);
         renderer.rotation = glm::vec3(0, 0, static_cast<float>(rotate * M_PI / 180.0));
     }
     
-    // 处理缩放（排除文本资源）
-    if (!std::dynamic_pointer_cast<TextResource>(renderer.getRendererResource())) {
+    // 处理缩放（排除文本资源，文本的缩放体现在字号上）
+    if (!keyframes.isText) {
         glm::vec3 scale(1.0f);
         bool hasScale = false;
         
-        if (kf.contains("adjust.scale.x") && kf["adjust.scale.x"].is_array()) {
-            scale.x = static_cast<float>(getKeyframeValue(kf["adjust.scale.x"], globalTime, engine).get<double>());
+        if (keyframes.scaleX.isNumber()) {
+            scale.x = static_cast<float>(keyframes.scaleX.evaluateNumber(globalTime));
             hasScale = true;
         }
         
-        if (kf.contains("adjust.scale.y") && kf["adjust.scale.y"].is_array()) {
-            scale.y = static_cast<float>(getKeyframeValue(kf["adjust.scale.y"], globalTime, engine).get<double>());
+        if (keyframes.scaleY.isNumber()) {
+            scale.y = static_cast<float>(keyframes.scaleY.evaluateNumber(globalTime));
             hasScale = true;
         }
         
@@ -110,56 +152,54 @@ void Keyframe::updateRendererAdjust(VideoRenderer& renderer, double globalTime,
     }
     
     // 处理透明度
-    if (kf.contains("adjust.opacity") && kf["adjust.opacity"].is_array()) {
-        double opacity = getKeyframeValue(kf["adjust.opacity"], globalTime, engine).get<double>();
+    if (keyframes.opacity.isNumber()) {
+        double opacity = keyframes.opacity.evaluateNumber(globalTime);
         renderer.setColorAlpha(static_cast<float>(opacity));
     }
     
     renderer.updateMaterialUniforms();
 }
 
-void Keyframe::updateTextRenderer(VideoRenderer& renderer, double globalTime, const nlohmann::json& sequence, Engine& engine) {    
+void Keyframe::updateTextRenderer(VideoRenderer& renderer, double globalTime, const SequenceKeyframes& keyframes, Engine& engine) {    
     // ScopedProfiler profiler("Keyframe::updateTextRenderer " + renderer.getName());
-    auto kf = sequence.value("keyframe", nlohmann::json::object());
     glm::vec2 scale(1.0f);
     bool hasValue = false;
     
-    if (kf.contains("adjust.scale.x") && kf["adjust.scale.x"].is_array()) {
-        scale.x = static_cast<float>(getKeyframeValue(kf["adjust.scale.x"], globalTime, engine).get<double>());
+    if (keyframes.scaleX.isNumber()) {
+        scale.x = static_cast<float>(keyframes.scaleX.evaluateNumber(globalTime));
         hasValue = true;
     }
     
-    if (kf.contains("adjust.scale.y") && kf["adjust.scale.y"].is_array()) {
-        scale.y = static_cast<float>(getKeyframeValue(kf["adjust.scale.y"], globalTime, engine).get<double>());
+    if (keyframes.scaleY.isNumber()) {
+        scale.y = static_cast<float>(keyframes.scaleY.evaluateNumber(globalTime));
         hasValue = true;
     }
     
     // 处理文本资源属性
-    const nlohmann::json sequenceResource = sequence["resource"];
-    bool isStroke = sequenceResource.value("strokeEnabled", false);
+    bool isStroke = keyframes.strokeEnabled;
 
-    std::optional<std::array<double, 4>> color = CoreUtils::convertHexToColorArray(sequenceResource.value("color", "#db1116ff"));
-    std::optional<std::array<double, 4>> strokeColor = CoreUtils::convertHexToColorArray(sequenceResource.value("strokeColor", "#db1116ff"));
-    int strokeWidth = isStroke ? sequenceResource.value("strokeWidth", 0) : 0;
-    int fontSize = static_cast<int>(sequenceResource.value("fontSize", 60)*scale.x);
+    std::optional<std::array<double, 4>> color = keyframes.baseColor;
+    std::optional<std::array<double, 4>> strokeColor = keyframes.baseStrokeColor;
+    int strokeWidth = isStroke ? keyframes.baseStrokeWidth : 0;
+    int fontSize = static_cast<int>(keyframes.baseFontSize*scale.x);
 
-    if (kf.contains("resource.fontSize") && kf["resource.fontSize"].is_array()) {
-        fontSize = static_cast<int>(getKeyframeValue(kf["resource.fontSize"], globalTime, engine).get<double>()*scale.x);
+    if (keyframes.fontSize.isNumber()) {
+        fontSize = static_cast<int>(keyframes.fontSize.evaluateNumber(globalTime)*scale.x);
         hasValue = true;
     }
     
-    if (kf.contains("resource.strokeWidth") && kf["resource.strokeWidth"].is_array()) {
-        strokeWidth = isStroke ? static_cast<int>(getKeyframeValue(kf["resource.strokeWidth"], globalTime, engine).get<double>()) : 0;
+    if (keyframes.strokeWidth.isNumber()) {
+        strokeWidth = isStroke ? static_cast<int>(keyframes.strokeWidth.evaluateNumber(globalTime)) : 0;
         hasValue = true;
     }
     
-    if (kf.contains("resource.color") && kf["resource.color"].is_array()) {
-        color = CoreUtils::convertHexToColorArray(getKeyframeValue(kf["resource.color"], globalTime, engine).get<std::string>());
+    if (keyframes.color.isColor()) {
+        color = keyframes.color.evaluateColor(globalTime);
         hasValue = true;
     }
     
-    if (kf.contains("resource.strokeColor") && kf["resource.strokeColor"].is_array()) {
-        strokeColor = CoreUtils::convertHexToColorArray(getKeyframeValue(kf["resource.strokeColor"], globalTime, engine).get<std::string>());
+    if (keyframes.strokeColor.isColor()) {
+        strokeColor = keyframes.strokeColor.evaluateColor(globalTime);
         hasValue = true;
     }
     
@@ -167,51 +207,81 @@ void Keyframe::updateTextRenderer(VideoRenderer& renderer, double globalTime, co
     strokeWidth = static_cast<int>(strokeWidth*engine.globalRenderScale);
 
     if (hasValue) {
-        std::string resourcePath = sequenceResource.value("absolutePath", "");
-        auto resource = std::make_shared<TextResource>(resourcePath, sequenceResource.value("text", "xxx"), fontSize, color, strokeWidth, strokeColor);
+        // 参数与上一帧相同时沿用已有的文本纹理
+        const auto& last = keyframes.lastTextState;
+        if (last && last->fontSize == fontSize && last->strokeWidth == strokeWidth && last->color == color && last->strokeColor == strokeColor) {
+            return;
+        }
+        keyframes.lastTextState = SequenceKeyframes::TextState{fontSize, strokeWidth, color, strokeColor};
+
+        auto resource = std::make_shared<TextResource>(keyframes.textPath, keyframes.text, fontSize, color, strokeWidth, strokeColor);
         renderer.updateRendererResource(resource, 0);
     }
 }
 
-nlohmann::json Keyframe::getKeyframeControl(const nlohmann::json& plugin, double globalTime, Engine& engine)
+// 按 ExpressTool::convertJsonValueToUniformValue 的规则把数组转换成向量
+static UniformValue makeVectorUniformValue(const std::vector<float>& values) {
+    UniformValue uv;
+    if (values.size() == 2) {
+        uv.type = UniformType::Vec2f;
+        uv.value = glm::vec2(values[0], values[1]);
+    } else if (values.size() == 3) {
+        uv.type = UniformType::Vec3f;
+        uv.value = glm::vec3(values[0], values[1], values[2]);
+    } else if (values.size() == 4) {
+        uv.type = UniformType::Vec4f;
+        uv.value = glm::vec4(values[0], values[1], values[2], values[3]);
+    } else {
+        uv.type = UniformType::Int;
+        uv.value = std::monostate{};
+    }
+    return uv;
+}
+
+std::unordered_map<std::string, UniformValue> Keyframe::getKeyframeControl(const PluginKeyframes& plugin, double globalTime)
 {
-    nlohmann::json keyframeControl = nlohmann::json::object();
-    
-    if (!plugin.contains("control") || !plugin["control"].is_object()) return keyframeControl;
+    std::unordered_map<std::string, UniformValue> keyframeControl;
     
-    for (auto& [key, value] : plugin["control"].items()) {
-        if (value.is_array()) {
-            keyframeControl[key] = nlohmann::json::array();//value.size()
-            for (size_t i = 0; i < value.size(); ++i) {
-                std::string controlKey = "control." + key + "[" + std::to_string(i) + "]";
-                if (plugin.contains("keyframe") && plugin["keyframe"].contains(controlKey)) {
-                    keyframeControl[key][i] = getKeyframeValue(plugin["keyframe"][controlKey], globalTime, engine);
-                } else {
-                    keyframeControl[key][i] = value[i];
+    for (const auto& control : plugin.controls) {
+        if (control.isArray) {
+            bool hasKeyframe = false;
+            std::vector<float> values = control.elementValues;
+            for (size_t i = 0; i < values.size(); ++i) {
+                if (control.elementCurves[i].isNumber()) {
+                    values[i] = static_cast<float>(control.elementCurves[i].evaluateNumber(globalTime));
+                    hasKeyframe = true;
                 }
             }
+            keyframeControl[control.name] = hasKeyframe ? makeVectorUniformValue(values) : control.staticValue;
         } else {
-            std::string controlKey = "control." + key;
-            if (plugin.contains("keyframe") && plugin["keyframe"].contains(controlKey)) {
-                keyframeControl[key] = getKeyframeValue(plugin["keyframe"][controlKey], globalTime, engine);
-            } else {
-                keyframeControl[key] = value;
+            UniformValue uv = control.staticValue;
+            if (!control.curve.empty()) {
+                KeyframeValue value = control.curve.evaluate(globalTime);
+                if (value.type == KeyframeValueType::Number && value.isInteger) {
+                    uv.type = UniformType::Int;
+                    uv.value = static_cast<int>(value.value[0]);
+                } else if (value.type == KeyframeValueType::Number) {
+                    uv.type = UniformType::Float;
+                    uv.value = static_cast<float>(value.value[0]);
+                } else if (value.type == KeyframeValueType::Color) {
+                    uv.type = UniformType::Vec4f;
+                    uv.value = glm::vec4(value.value[0], value.value[1], value.value[2], value.value[3]);
+                }
             }
+            keyframeControl[control.name] = uv;
         }
     }
     return keyframeControl;
 }
 
-void Keyframe::updateRendererPlugin(VideoRenderer& renderer, double globalTime, const nlohmann::json& sequence, Engine& engine, const nlohmann::json& plugin, int pluginIndex) {
+void Keyframe::updateRendererPlugin(VideoRenderer& renderer, double globalTime, const SequenceKeyframes& keyframes, Engine& engine, const PluginKeyframes& plugin, int pluginIndex) {
     // ScopedProfiler profiler("Keyframe::updateRendererPlugin " + renderer.getName());
-    nlohmann::json keyframeControl = getKeyframeControl(plugin, globalTime, engine);
     try {
-        nlohmann::json tempPlugin = nlohmann::json::object();
-        tempPlugin["control"] = keyframeControl;
-        const auto& expressValue = ExpressTool::collectMaterialExpressValue(renderer.getRendererResource(), renderer.getName(), renderer.getMaterialPass(), tempPlugin, pluginIndex, engine.getSequenceRenderTargetInfo());
+        const auto& keyframeControl = getKeyframeControl(plugin, globalTime);
+        const auto& expressValue = ExpressTool::collectMaterialExpressValue(renderer.getRendererResource(), renderer.getName(), renderer.getMaterialPass(), keyframeControl, pluginIndex, engine.getSequenceRenderTargetInfo());
         ExpressTool::caculateMaterialExpress(renderer.getName(), renderer.getMaterialPass(), expressValue, pluginIndex);
     } catch (const std::exception& e) {
-        std::cerr << "片段（id=" << sequence.value("id", "") << "）的插件（id=" << plugin.value("id", "") << "）关键帧属性报错:" << e.what() << std::endl;
+        std::cerr << "片段（id=" << keyframes.id << "）的插件（id=" << plugin.id << "）关键帧属性报错:" << e.what() << std::endl;
     }
 }
 
@@ -219,48 +289,38 @@ bool Keyframe::isPlainNoEmptyObject(const nlohmann::json& val) {
     return val.is_object() && !val.empty();
 }
 
-void Keyframe::updateRenderer(VideoRenderer& renderer, double globalTime, const nlohmann::json& sequence, Engine& engine) {
+void Keyframe::updateRenderer(VideoRenderer& renderer, double globalTime, const SequenceKeyframes& keyframes, Engine& engine) {
     ScopedProfiler profiler("Keyframe::updateRenderer " + renderer.getName());
-    if (sequence.contains("keyframe") && isPlainNoEmptyObject(sequence["keyframe"])) {
-        updateRendererAdjust(renderer, globalTime, sequence, engine);
+    if (keyframes.hasKeyframe) {
+        updateRendererAdjust(renderer, globalTime, keyframes, engine);
 
-        std::shared_ptr<RendererResource> resource = renderer.getRendererResource();
-        std::shared_ptr<TextResource> textResource = std::dynamic_pointer_cast<TextResource>(resource);
-        if (textResource) {
-            updateTextRenderer(renderer, globalTime, sequence, engine);
+        if (keyframes.isText) {
+            updateTextRenderer(renderer, globalTime, keyframes, engine);
         }
     }
-    if (sequence.contains("plugins") && sequence["plugins"].is_array()) {
-        bool hasValue = false;
-        const auto& plugins = sequence["plugins"];
-        
-        for (size_t i = 0; i < plugins.size(); ++i) {
-            const auto& plugin = plugins[i];
-            if (isPlainNoEmptyObject(plugin)) {
-                updateRendererPlugin(renderer, globalTime, sequence, engine, plugin, static_cast<int>(i));
-                hasValue = true;
-            }
-        }
-        if (hasValue) {// && renderer.materialTexture.renderTa
-            renderer.updateVerticeBuffer();
+
+    bool hasValue = false;
+    for (size_t i = 0; i < keyframes.plugins.size(); ++i) {
+        const auto& plugin = keyframes.plugins[i];
+        if (!plugin.isEmpty) {
+            updateRendererPlugin(renderer, globalTime, keyframes, engine, plugin, static_cast<int>(i));
+            hasValue = true;
         }
     }
+    if (hasValue) {// && renderer.materialTexture.renderTa
+        renderer.updateVerticeBuffer();
+    }
 }
 
-void Keyframe::updatePluginRenderer(PluginRenderer& pluginRenderer, double globalTime, const nlohmann::json& sequence, Engine& engine)
+void Keyframe::updatePluginRenderer(PluginRenderer& pluginRenderer, double globalTime, const SequenceKeyframes& keyframes, Engine& engine)
 {
     ScopedProfiler profiler("Keyframe::updatePluginRenderer " + pluginRenderer.getName());
     auto sequenceRenderTarget = engine.getSequenceRenderTargetInfo();
-    const auto& plugins = sequence["plugins"];
-    for (size_t j = 0; j < plugins.size(); j++)
+    auto name = pluginRenderer.getName();
+    for (size_t j = 0; j < keyframes.plugins.size(); j++)
     {
-        auto& plugin = plugins[j];
-        nlohmann::json keyframeControl = getKeyframeControl(plugin, globalTime, engine);
-        nlohmann::json tempPlugin = nlohmann::json::object();
-        tempPlugin["control"] = keyframeControl;
-
-        auto name = pluginRenderer.getName();
-        const auto& expressValue = ExpressTool::collectMaterialExpressValue(nullptr, name, pluginRenderer.getMaterialPass(), tempPlugin, static_cast<int>(j), sequenceRenderTarget);
+        const auto& keyframeControl = getKeyframeControl(keyframes.plugins[j], globalTime);
+        const auto& expressValue = ExpressTool::collectMaterialExpressValue(nullptr, name, pluginRenderer.getMaterialPass(), keyframeControl, static_cast<int>(j), sequenceRenderTarget);
         ExpressTool::caculateMaterialExpress(name, pluginRenderer.getMaterialPass(), expressValue, static_cast<int>(j));
     }
     pluginRenderer.updateVerticeBuffer(engine);
@@ -5,36 +5,101 @@
 // #pragma once
 
 #include <glm/glm.hpp>
+#include <array>
 #include <string>
 #include <vector>
 #include <optional>
+#include <unordered_map>
 #include "nlohmann/json.hpp"
+#include "KeyframeCurve.h"
+#include "src/Materials.h"
 
 class Engine;  // Forward declaration
 class VideoRenderer;  // Forward declaration
 class PluginRenderer;
 
+// 插件单个控制参数编译后的关键帧
+struct ControlKeyframes {
+    std::string name;                          // "control_" + key，即表达式里的变量名
+    UniformValue staticValue;                  // 没有关键帧时的取值
+    KeyframeCurve curve;                       // 标量参数的关键帧 control.<key>
+    bool isArray = false;
+    std::vector<float> elementValues;          // 数组参数的原始元素
+    std::vector<KeyframeCurve> elementCurves;  // 数组参数逐元素的关键帧 control.<key>[i]，与 elementValues 对齐
+};
+
+// 插件编译后的关键帧
+struct PluginKeyframes {
+    std::string id;
+    bool isEmpty = true;                       // 不是非空对象
+    bool hasKeyframe = false;                  // plugin["keyframe"] 是非空对象
+    std::vector<ControlKeyframes> controls;
+};
+
+// 单个片段编译后的关键帧，UpdateTracks 时从 JSON 生成一次，逐帧求值不再访问 JSON
+struct SequenceKeyframes {
+    std::string id;
+    bool hasKeyframe = false;                  // sequence["keyframe"] 是非空对象
+    bool isText = false;
+
+    KeyframeCurve transformX;
+    KeyframeCurve transformY;
+    KeyframeCurve rotate;
+    KeyframeCurve scaleX;
+    KeyframeCurve scaleY;
+    KeyframeCurve opacity;
+
+    // 文本资源的关键帧与静态属性
+    KeyframeCurve fontSize;
+    KeyframeCurve strokeWidth;
+    KeyframeCurve color;
+    KeyframeCurve strokeColor;
+    std::string textPath;
+    std::string text;
+    bool strokeEnabled = false;
+    int baseFontSize = 60;
+    int baseStrokeWidth = 0;
+    std::optional<std::array<double, 4>> baseColor;
+    std::optional<std::array<double, 4>> baseStrokeColor;
+
+    std::vector<PluginKeyframes> plugins;      // 与 sequence["plugins"] 一一对应，下标即插件序号
+
+    // 是否需要逐帧更新
+    bool isAnimated() const;
+    // a、b 两个时刻所有关键帧的取值是否都相同，此时逐帧更新的结果不变
+    bool isConstantBetween(double a, double b) const;
+
+    static SequenceKeyframes compile(const nlohmann::json& sequence);
+
+    // 上一次生成文本资源时的参数，参数不变时不再重建文本纹理
+    struct TextState {
+        int fontSize;
+        int strokeWidth;
+        std::optional<std::array<double, 4>> color;
+        std::optional<std::array<double, 4>> strokeColor;
+    };
+    mutable std::optional<TextState> lastTextState;
+};
+
 class Keyframe {
 public:
-    // 获取关键帧插值结果
-    static nlohmann::json getKeyframeValue(const nlohmann::json& keyframeArray, double globalTime, Engine& engine);
-
     // 更新渲染器调整参数（位置、旋转、缩放、透明度）
-    static void updateRendererAdjust(VideoRenderer& renderer, double globalTime, const nlohmann::json& sequence, Engine& engine);
+    static void updateRendererAdjust(VideoRenderer& renderer, double globalTime, const SequenceKeyframes& keyframes, Engine& engine);
 
     // 更新文本渲染器属性
-    static void updateTextRenderer(VideoRenderer& renderer, double globalTime, const nlohmann::json& sequence, Engine& engine);
+    static void updateTextRenderer(VideoRenderer& renderer, double globalTime, const SequenceKeyframes& keyframes, Engine& engine);
 
-    static nlohmann::json getKeyframeControl(const nlohmann::json& plugin, double globalTime, Engine& engine);
+    // 求插件控制参数在 globalTime 的取值，键为 "control_" + key
+    static std::unordered_map<std::string, UniformValue> getKeyframeControl(const PluginKeyframes& plugin, double globalTime);
     // 更新渲染器插件参数
-    static void updateRendererPlugin(VideoRenderer& renderer, double globalTime, const nlohmann::json& sequence, Engine& engine, const nlohmann::json& plugin, int pluginIndex);
+    static void updateRendererPlugin(VideoRenderer& renderer, double globalTime, const SequenceKeyframes& keyframes, Engine& engine, const PluginKeyframes& plugin, int pluginIndex);
 
     // 检查是否是非空普通对象
     static bool isPlainNoEmptyObject(const nlohmann::json& val);
 
     // 主更新函数
-    static void updateRenderer(VideoRenderer& renderer, double globalTime, const nlohmann::json& sequence, Engine& engine);
-    static void updatePluginRenderer(PluginRenderer& pluginRenderer, double globalTime, const nlohmann::json& sequence, Engine& engine);
+    static void updateRenderer(VideoRenderer& renderer, double globalTime, const SequenceKeyframes& keyframes, Engine& engine);
+    static void updatePluginRenderer(PluginRenderer& pluginRenderer, double globalTime, const SequenceKeyframes& keyframes, Engine& engine);
 
 // protected:
     // 颜色转换工具函数
@@ -42,4 +107,4 @@ public:
     // static std::string convertColorArrayToHex(const std::vector<double>& colorArray);
 };
 
-#endif
\ No newline at end of file
+#endif
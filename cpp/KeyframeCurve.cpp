@@ -0,0 +1,133 @@
+// KeyframeCurve.cpp
+#include "KeyframeCurve.h"
+#include <algorithm>
+#include <numeric>
+#include "CoreUtils.h"
+
+
+KeyframeCurve::KeyframeCurve(const nlohmann::json& keyframeArray) {
+    if (!keyframeArray.is_array()) return;
+
+    struct Key {
+        double offset;
+        KeyframeValueType type;
+        std::array<double, 4> value;
+        Easing easing;
+        bool isInteger;
+    };
+    std::vector<Key> keys;
+    keys.reserve(keyframeArray.size());
+
+    for (const auto& keyframe : keyframeArray) {
+        if (!keyframe.is_object() || !keyframe.contains("offset") || !keyframe.contains("value") || !keyframe.contains("type"))
+            continue; // 忽略无效关键帧
+        if (!keyframe["offset"].is_number())
+            continue;
+
+        Key key{keyframe["offset"].get<double>(), KeyframeValueType::Other, {0.0, 0.0, 0.0, 1.0}, Easing::fromKeyframe(keyframe), false};
+        const auto& value = keyframe["value"];
+        if (value.is_number()) {
+            key.type = KeyframeValueType::Number;
+            key.value[0] = value.get<double>();
+            key.isInteger = value.is_number_integer();
+        } else if (value.is_string()) {
+            auto color = CoreUtils::convertHexToColorArray(value.get<std::string>());
+            if (color) {
+                key.type = KeyframeValueType::Color;
+                key.value = *color;
+            }
+        }
+        keys.push_back(key);
+    }
+    if (keys.empty()) return;
+
+    // 编辑器输出的关键帧本身按 offset 升序，这里稳定排序只是兜底
+    std::stable_sort(keys.begin(), keys.end(), [](const Key& a, const Key& b) { return a.offset < b.offset; });
+
+    uniformType = keys[0].type;
+    for (const auto& key : keys) {
+        if (key.type != uniformType) {
+            uniformType = KeyframeValueType::Other;
+            break;
+        }
+    }
+    stride = uniformType == KeyframeValueType::Number ? 1 : 4;
+
+    bool isLinear = std::all_of(keys.begin(), keys.end(), [](const Key& key) { return key.easing.isLinear(); });
+
+    offsets.reserve(keys.size());
+    types.reserve(keys.size());
+    integers.reserve(keys.size());
+    values.reserve(keys.size() * stride);
+    for (const auto& key : keys) {
+        offsets.push_back(key.offset);
+        types.push_back(key.type);
+        integers.push_back(key.isInteger);
+        values.insert(values.end(), key.value.begin(), key.value.begin() + stride);
+        if (!isLinear) easings.push_back(key.easing);
+    }
+}
+
+size_t KeyframeCurve::findSegment(double time) const {
+    size_t count = offsets.size();
+    // 先检查上次命中的段及其下一段
+    for (size_t k = cursor; k <= count && k <= cursor + 1; k++) {
+        bool afterLeft = k == 0 || offsets[k - 1] <= time;
+        bool beforeRight = k == count || time < offsets[k];
+        if (afterLeft && beforeRight) {
+            cursor = k;
+            return k;
+        }
+    }
+    cursor = std::upper_bound(offsets.begin(), offsets.end(), time) - offsets.begin();
+    return cursor;
+}
+
+KeyframeValue KeyframeCurve::valueAt(size_t index) const {
+    KeyframeValue result;
+    result.type = types[index];
+    result.isInteger = integers[index];
+    const double* value = &values[index * stride];
+    for (size_t c = 0; c < stride; c++) {
+        result.value[c] = value[c];
+    }
+    return result;
+}
+
+KeyframeValue KeyframeCurve::evaluate(double time) const {
+    if (empty()) return KeyframeValue();
+
+    size_t k = findSegment(time);
+    if (k == 0) return valueAt(0);
+    if (k == offsets.size()) return valueAt(k - 1);
+
+    // 类型不匹配或无法插值时直接返回前一个值
+    if (types[k - 1] != types[k] || types[k] == KeyframeValueType::Other) return valueAt(k - 1);
+
+    double factor = (time - offsets[k - 1]) / (offsets[k] - offsets[k - 1]);
+    if (!easings.empty()) factor = easings[k - 1].apply(factor);
+    const double* pre = &values[(k - 1) * stride];
+    const double* cur = &values[k * stride];
+    KeyframeValue result;
+    result.type = types[k];
+    size_t channels = types[k] == KeyframeValueType::Number ? 1 : 4;
+    for (size_t c = 0; c < channels; c++) {
+        result.value[c] = factor * (cur[c] - pre[c]) + pre[c];
+    }
+    return result;
+}
+
+double KeyframeCurve::evaluateNumber(double time) const {
+    return evaluate(time).value[0];
+}
+
+std::array<double, 4> KeyframeCurve::evaluateColor(double time) const {
+    return evaluate(time).value;
+}
+
+bool KeyframeCurve::isConstantBetween(double a, double b) const {
+    if (offsets.size() <= 1) return true;
+    double from = std::min(a, b);
+    double to = std::max(a, b);
+    return to <= offsets.front() || from >= offsets.back();
+}
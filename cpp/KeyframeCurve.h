@@ -0,0 +1,63 @@
+// KeyframeCurve.h
+#ifndef KEYFRAME_CURVE_H
+#define KEYFRAME_CURVE_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "nlohmann/json.hpp"
+#include "Easing.h"
+
+// 单个关键帧值的类型
+enum class KeyframeValueType : std::uint8_t {
+    Number,  // 数值，单通道
+    Color,   // 十六进制颜色，编译时解析为 RGBA 四通道
+    Other    // 其它类型，不参与插值
+};
+
+// 关键帧求值结果
+struct KeyframeValue {
+    KeyframeValueType type = KeyframeValueType::Other;
+    std::array<double, 4> value = {0.0, 0.0, 0.0, 1.0};
+    // 取的是某个关键帧本身的值且 JSON 中为整数（插值结果总是浮点数），与 ExpressTool::convertJsonValueToUniformValue 的 Int / Float 区分一致
+    bool isInteger = false;
+};
+
+// 由关键帧 JSON 数组预编译出的类型化曲线
+// 偏移和各通道的值存放在连续数组中，段查找优先复用上次命中的位置（顺序播放时为 O(1)），否则二分查找
+class KeyframeCurve {
+public:
+    KeyframeCurve() = default;
+    explicit KeyframeCurve(const nlohmann::json& keyframeArray);
+
+    bool empty() const { return offsets.empty(); }
+    bool isNumber() const { return !empty() && uniformType == KeyframeValueType::Number; }
+    bool isColor() const { return !empty() && uniformType == KeyframeValueType::Color; }
+
+    // 两端之外取端点值，
+    // 相邻关键帧类型一致时按前一个关键帧的缓动插值，否则取前一个关键帧的值
+    KeyframeValue evaluate(double time) const;
+
+    // a、b 两个时刻的取值是否一定相同：两个时刻都在第一个关键帧之前或都在最后一个关键帧之后（空曲线和单个关键帧总是相同）
+    bool isConstantBetween(double a, double b) const;
+
+    // 仅在 isNumber() / isColor() 时使用
+    double evaluateNumber(double time) const;
+    std::array<double, 4> evaluateColor(double time) const;
+
+private:
+    // 返回 offset <= time 的关键帧个数，即 time 所在段右端关键帧的下标
+    size_t findSegment(double time) const;
+    KeyframeValue valueAt(size_t index) const;
+
+    std::vector<double> offsets;
+    std::vector<KeyframeValueType> types;
+    std::vector<bool> integers;          // 每个关键帧的值是否为 JSON 整数
+    std::vector<double> values;          // 每个关键帧 stride 个通道
+    std::vector<Easing> easings;         // 每个关键帧到下一个关键帧的缓动，全部为线性时为空
+    size_t stride = 1;
+    KeyframeValueType uniformType = KeyframeValueType::Other;  // 所有关键帧类型一致时的类型
+    mutable size_t cursor = 0;           // 上次命中的段
+};
+
+#endif // KEYFRAME_CURVE_H
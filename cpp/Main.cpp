@@ -12,6 +12,7 @@
 #include <fstream>           // 用于文件操作
 
 #include "Engine.h"
+#include "RenderServer.h"
 #include "src/ScopedProfiler.h"
 
 #include "nlohmann/json.hpp"
@@ -45,9 +46,27 @@ void SetConsoleEncoding() {
     // Linux默认就是UTF-8，无需特殊设置
 }
 
-int main() {
+int main(int argc, char* argv[]) {
     SetConsoleEncoding();
 
+    // 常驻服务模式：--server 从标准输入逐行读取任务；--socket <path> 监听 Unix domain socket
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--server") {
+            RenderServer server;
+            return server.runStream(std::cin, std::cout);
+        }
+        if (arg == "--socket" && i + 1 < argc) {
+#ifndef _WIN32
+            RenderServer server;
+            return server.runUnixSocket(argv[i + 1]);
+#else
+            std::cerr << "Windows 下不支持 --socket，请使用 --server" << std::endl;
+            return 1;
+#endif
+        }
+    }
+
     try {
         ScopedProfiler profiler("main");
 
@@ -87,11 +106,25 @@ int main() {
 
         Engine engine;
         float globalRenderScale = tracksJson.contains("globalRenderScale") ?  tracksJson["globalRenderScale"].get<float>() : 1.0f;
-        engine.Init(tracksJson["width"], tracksJson["height"], globalRenderScale, tracksJson["isDebug"]);  // 替换为实际的 WIDTH 和 HEIGHT
+        bool isDebug = tracksJson.value("isDebug", false);
+        // contextBackend: "auto"（默认）/ "window" / "headless"
+        GLContextBackend contextBackend = GLContext::parseBackend(tracksJson.value("contextBackend", "auto"));
+        if (!engine.Init(tracksJson["width"], tracksJson["height"], globalRenderScale, isDebug, contextBackend)) {
+            json errorJson;
+            errorJson["error"] = "渲染引擎初始化失败";
+            std::cerr << errorJson.dump() << std::endl;
+            return 1;
+        }
+        engine.applyJobSettings(tracksJson);
         engine.UpdateTracks(tracksJson);
 
         // 执行播放，并获取结果
-        engine.Play(tracksJson["startTime"], tracksJson["endTime"], tracksJson["stepTime"], tracksJson["isDebug"], tracksJson["outputPath"], tracksJson["fps"], tracksJson["mBitRate"]);
+        if (!engine.Play(tracksJson["startTime"], tracksJson["endTime"], tracksJson["stepTime"], isDebug, tracksJson["outputPath"], tracksJson["fps"], tracksJson["mBitRate"])) {
+            json errorJson;
+            errorJson["error"] = "渲染失败";
+            std::cerr << errorJson.dump() << std::endl;
+            return 1;
+        }
         json resultJson;
         resultJson["result"] = "处理成功";
         // 输出结果 JSON
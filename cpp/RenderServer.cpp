@@ -0,0 +1,154 @@
+// RenderServer.cpp
+#include "RenderServer.h"
+#include <chrono>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#endif
+
+using json = nlohmann::json;
+
+RenderServer::~RenderServer() {
+    engine.reset();
+}
+
+json RenderServer::handleJob(const std::string& line, bool& quit) {
+    json response;
+    try {
+        json tracksJson = json::parse(line);
+        if (tracksJson.contains("id")) {
+            response["id"] = tracksJson["id"];
+        }
+        if (tracksJson.value("command", "") == "quit") {
+            quit = true;
+            response["result"] = "已退出";
+            return response;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+
+        float globalRenderScale = tracksJson.contains("globalRenderScale") ? tracksJson["globalRenderScale"].get<float>() : 1.0f;
+        int width = tracksJson["width"];
+        int height = tracksJson["height"];
+        bool isDebug = tracksJson.value("isDebug", false);
+
+        if (!engine) {
+            // 第一个任务决定上下文后端，之后的任务沿用同一个上下文
+            GLContextBackend contextBackend = GLContext::parseBackend(tracksJson.value("contextBackend", "auto"));
+            engine = std::make_unique<Engine>();
+            if (!engine->Init(width, height, globalRenderScale, isDebug, contextBackend)) {
+                engine.reset();
+                response["error"] = "渲染引擎初始化失败";
+                return response;
+            }
+        }
+        else if (!engine->Prepare(width, height, globalRenderScale)) {
+            response["error"] = "渲染引擎准备画布失败";
+            return response;
+        }
+
+        engine->applyJobSettings(tracksJson);
+        engine->UpdateTracks(tracksJson);
+        if (!engine->Play(tracksJson["startTime"], tracksJson["endTime"], tracksJson["stepTime"], isDebug, tracksJson["outputPath"], tracksJson["fps"], tracksJson["mBitRate"])) {
+            response["error"] = "渲染失败";
+            return response;
+        }
+
+        response["result"] = "处理成功";
+        response["elapsedMs"] = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+    catch (json::parse_error& e) {
+        response["error"] = "解析错误: " + std::string(e.what());
+    }
+    catch (json::type_error& e) {
+        response["error"] = "类型错误: " + std::string(e.what());
+    }
+    catch (std::exception& e) {
+        response["error"] = "未知错误: " + std::string(e.what());
+    }
+    return response;
+}
+
+int RenderServer::runStream(std::istream& input, std::ostream& output) {
+    std::string line;
+    bool quit = false;
+    while (!quit && std::getline(input, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+        output << handleJob(line, quit).dump() << std::endl;
+    }
+    return 0;
+}
+
+#ifndef _WIN32
+int RenderServer::runUnixSocket(const std::string& socketPath) {
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cerr << "socket 路径过长: " << socketPath << std::endl;
+        return 1;
+    }
+
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        std::cerr << "无法创建 socket: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    // 客户端提前断开时 write 不应终止整个服务
+    std::signal(SIGPIPE, SIG_IGN);
+
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    unlink(socketPath.c_str());
+    if (bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(listenFd, 8) < 0) {
+        std::cerr << "无法监听 " << socketPath << ": " << std::strerror(errno) << std::endl;
+        close(listenFd);
+        return 1;
+    }
+
+    // GL 上下文只属于当前线程，连接按顺序处理
+    bool quit = false;
+    while (!quit) {
+        int clientFd = accept(listenFd, nullptr, nullptr);
+        if (clientFd < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "accept 失败: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        std::string pending;
+        char buffer[4096];
+        while (!quit) {
+            ssize_t received = read(clientFd, buffer, sizeof(buffer));
+            if (received <= 0) break;
+            pending.append(buffer, static_cast<size_t>(received));
+
+            size_t newline;
+            while (!quit && (newline = pending.find('\n')) != std::string::npos) {
+                std::string line = pending.substr(0, newline);
+                pending.erase(0, newline + 1);
+                if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+                std::string reply = handleJob(line, quit).dump() + "\n";
+                const char* data = reply.data();
+                size_t remaining = reply.size();
+                while (remaining > 0) {
+                    ssize_t written = write(clientFd, data, remaining);
+                    if (written <= 0) break;
+                    data += written;
+                    remaining -= static_cast<size_t>(written);
+                }
+            }
+        }
+        close(clientFd);
+    }
+
+    close(listenFd);
+    unlink(socketPath.c_str());
+    return 0;
+}
+#endif
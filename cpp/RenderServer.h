@@ -0,0 +1,35 @@
+// RenderServer.h
+#ifndef RENDER_SERVER_H
+#define RENDER_SERVER_H
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include "Engine.h"
+#include "nlohmann/json.hpp"
+
+// 常驻渲染服务
+// 每行一个任务 JSON（与单任务模式的输入相同），每个任务完成后输出一行结果 JSON：
+//   {"id": ..., "result": "处理成功", "elapsedMs": ...} 或 {"id": ..., "error": "..."}
+// id 原样回显，便于客户端对应请求；{"command": "quit"} 结束服务
+// GL 上下文、着色器、字体、渲染目标池以及相同路径的视频解码器在任务之间保留，
+// 画布尺寸变化时只重建画布相关的资源
+class RenderServer {
+public:
+    ~RenderServer();
+
+    // 从 input 逐行读取任务，结果写到 output，input 结束或收到 quit 时返回
+    int runStream(std::istream& input, std::ostream& output);
+
+#ifndef _WIN32
+    // 在 Unix domain socket 上监听，依次处理每个连接中的任务
+    int runUnixSocket(const std::string& socketPath);
+#endif
+
+private:
+    nlohmann::json handleJob(const std::string& line, bool& quit);
+
+    std::unique_ptr<Engine> engine;
+};
+
+#endif // RENDER_SERVER_H
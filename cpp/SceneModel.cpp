@@ -0,0 +1,159 @@
+// SceneModel.cpp
+#include "SceneModel.h"
+#include <iostream>
+#include "src/VideoRenderer.h"
+#include "src/VideoResource.h"
+#include "src/PluginRenderer.h"
+#include "src/TransitionRenderer.h"
+
+
+bool TrackModel::isVisibleAtTime(size_t i, double globalTime) const {
+    double sequenceTime = globalTime - offset[i];
+    return (sequenceTime >= 0) && (sequenceTime <= trimmedDuration[i]);
+}
+
+double TrackModel::getSequenceTime(size_t i, double globalTime) const {
+    return globalTime - offset[i];
+}
+
+double TrackModel::getOriginalTime(size_t i, double globalTime) const {
+    double originalTime = (globalTime - offset[i]) * rate[i] + originalStart[i];
+    if (originalTime < originalStart[i])
+    {
+        return originalStart[i];
+    }
+    else if (originalTime > originalDuration[i])
+    {
+        return originalDuration[i];
+    }
+    return originalTime;
+}
+
+void SceneModel::clear() {
+    tracks.clear();
+    videoRenderers.clear();
+    videoResources.clear();
+    pluginRenderers.clear();
+    transitionStart.clear();
+    transitionDuration.clear();
+    transitionFirstSequence.clear();
+    transitionSecondSequence.clear();
+    transitionRenderers.clear();
+    keyframes.clear();
+}
+
+SceneModel SceneModel::compile(const std::vector<std::vector<nlohmann::json>>& sequences,
+                               const std::map<std::string, std::shared_ptr<VideoRenderer>>& rendererMap,
+                               const std::map<std::string, std::shared_ptr<PluginRenderer>>& pluginRendererMap,
+                               const std::map<std::string, std::shared_ptr<TransitionRenderer>>& transitionRendererMap) {
+    SceneModel scene;
+    scene.tracks.reserve(sequences.size());
+
+    for (const auto& sequenceArray : sequences)
+    {
+        TrackModel track;
+        for (const auto& sequence : sequenceArray)
+        {
+            if (!sequence.is_object() || !sequence.contains("id")) continue;
+            std::string seqId = sequence["id"];
+            std::string type = sequence.value("type", "");
+
+            int rendererIndex = -1;
+            SequenceType sequenceType;
+            if (type == "plugin")
+            {
+                auto rendererIt = pluginRendererMap.find(seqId);
+                if (rendererIt == pluginRendererMap.end() || !rendererIt->second) continue;
+                sequenceType = SequenceType::Plugin;
+                rendererIndex = static_cast<int>(scene.pluginRenderers.size());
+                scene.pluginRenderers.push_back(rendererIt->second);
+            }
+            else
+            {
+                auto rendererIt = rendererMap.find(seqId);
+                if (rendererIt == rendererMap.end() || !rendererIt->second) continue;
+                sequenceType = type == "text" ? SequenceType::Text : SequenceType::Graphic;
+                rendererIndex = static_cast<int>(scene.videoRenderers.size());
+                scene.videoRenderers.push_back(rendererIt->second);
+                scene.videoResources.push_back(std::dynamic_pointer_cast<VideoResource>(rendererIt->second->getRendererResource()));
+            }
+
+            const auto& timer = sequence["timer"];
+            double offset = timer["offset"].get<double>();
+            double duration = timer["duration"].get<double>();
+            double originalDuration = timer["originalDuration"].get<double>();
+            double rate = timer["rate"].get<double>();
+            double trimmedDuration = duration * (originalDuration / rate);
+
+            int transitionIndex = -1;
+            if (sequence.contains("transition") && sequence["transition"].contains("id"))
+            {
+                const auto& transition = sequence["transition"];
+                auto transitionIt = transitionRendererMap.find(transition["id"].get<std::string>());
+                if (transitionIt != transitionRendererMap.end() && transitionIt->second)
+                {
+                    double transitionDuration = transition["duration"].get<double>();
+                    transitionIndex = static_cast<int>(scene.transitionRenderers.size());
+                    scene.transitionStart.push_back((offset + trimmedDuration) - transitionDuration / 2);
+                    scene.transitionDuration.push_back(transitionDuration);
+                    scene.transitionFirstSequence.push_back(-1);
+                    scene.transitionSecondSequence.push_back(-1);
+                    scene.transitionRenderers.push_back(transitionIt->second);
+                    track.transitions.push_back(transitionIndex);
+                }
+            }
+
+            track.offset.push_back(offset);
+            track.trimmedDuration.push_back(trimmedDuration);
+            track.rate.push_back(rate);
+            track.originalStart.push_back(timer["start"].get<double>() * originalDuration);
+            track.originalDuration.push_back(originalDuration);
+            track.type.push_back(sequenceType);
+            track.rendererIndex.push_back(rendererIndex);
+            track.transitionIndex.push_back(transitionIndex);
+
+            // 没有任何关键帧时，UpdateTracks 里已经算好的结果在整个时间轴上都不会变化，不需要逐帧更新
+            SequenceKeyframes keyframes = SequenceKeyframes::compile(sequence);
+            if (keyframes.isAnimated())
+            {
+                track.keyframeIndex.push_back(static_cast<int>(scene.keyframes.size()));
+                scene.keyframes.push_back(std::move(keyframes));
+            }
+            else
+            {
+                track.keyframeIndex.push_back(-1);
+            }
+        }
+
+        // 建立可见区间与转场窗口的索引
+        std::vector<double> ends(track.size());
+        for (size_t j = 0; j < track.size(); j++)
+        {
+            ends[j] = track.offset[j] + track.trimmedDuration[j];
+        }
+        track.visibilityIndex.build(track.offset, ends);
+
+        std::vector<double> transitionStarts;
+        std::vector<double> transitionEnds;
+        for (int transitionIndex : track.transitions)
+        {
+            transitionStarts.push_back(scene.transitionStart[transitionIndex]);
+            transitionEnds.push_back(scene.transitionStart[transitionIndex] + scene.transitionDuration[transitionIndex]);
+
+            // 找到转场前后两个片段，转场期间即使片段不可见也要准备好它的画面
+            const auto& transitionRenderer = scene.transitionRenderers[transitionIndex];
+            for (size_t j = 0; j < track.size(); j++)
+            {
+                if (track.type[j] == SequenceType::Plugin) continue;
+                const auto& renderer = scene.videoRenderers[track.rendererIndex[j]];
+                if (renderer == transitionRenderer->firstRenderer) scene.transitionFirstSequence[transitionIndex] = static_cast<int>(j);
+                if (renderer == transitionRenderer->secondRenderer) scene.transitionSecondSequence[transitionIndex] = static_cast<int>(j);
+            }
+        }
+        track.transitionWindowIndex.build(transitionStarts, transitionEnds);
+
+        scene.tracks.push_back(std::move(track));
+    }
+
+    return scene;
+}
@@ -0,0 +1,77 @@
+// SceneModel.h
+#ifndef SCENE_MODEL_H
+#define SCENE_MODEL_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "nlohmann/json.hpp"
+#include "IntervalIndex.h"
+#include "Keyframe.h"
+
+class VideoRenderer;
+class VideoResource;
+class PluginRenderer;
+class TransitionRenderer;
+
+// 片段类型标签，替代每帧的 sequence["type"] 字符串比较
+enum class SequenceType : std::uint8_t {
+    Graphic,
+    Text,
+    Plugin
+};
+
+// 单条轨道编译后的片段数据（struct-of-arrays，保持轨道内原有顺序）
+struct TrackModel {
+    std::vector<double> offset;            // timer.offset（毫秒）
+    std::vector<double> trimmedDuration;   // duration * (originalDuration / rate)
+    std::vector<double> rate;              // timer.rate
+    std::vector<double> originalStart;     // start * originalDuration
+    std::vector<double> originalDuration;  // timer.originalDuration
+    std::vector<SequenceType> type;
+    std::vector<int> rendererIndex;        // Plugin 指向 pluginRenderers，其余指向 videoRenderers
+    std::vector<int> transitionIndex;      // 片段尾部的转场，-1 表示没有
+    std::vector<int> keyframeIndex;        // 指向 SceneModel::keyframes，-1 表示没有需要逐帧求值的关键帧
+
+    std::vector<int> transitions;          // 本轨道的转场（SceneModel 中的下标），按轨道顺序
+    IntervalIndex visibilityIndex;         // 片段可见区间 [offset, offset + trimmedDuration]
+    IntervalIndex transitionWindowIndex;   // 转场窗口，下标对应 transitions
+
+    size_t size() const { return offset.size(); }
+
+    // 与 TrackUtils 中基于 JSON 的同名方法计算方式保持一致
+    bool isVisibleAtTime(size_t i, double globalTime) const;
+    double getSequenceTime(size_t i, double globalTime) const;
+    double getOriginalTime(size_t i, double globalTime) const;
+};
+
+// UpdateTracks 时由工程 JSON 一次性编译出的场景模型，逐帧渲染只访问这里的数据
+struct SceneModel {
+    std::vector<TrackModel> tracks;
+
+    // 渲染器按编译顺序存放，片段通过 rendererIndex 直接索引
+    std::vector<std::shared_ptr<VideoRenderer>> videoRenderers;
+    std::vector<std::shared_ptr<VideoResource>> videoResources; // 与 videoRenderers 对齐，非视频资源为 nullptr
+    std::vector<std::shared_ptr<PluginRenderer>> pluginRenderers;
+
+    // 转场窗口：[transitionStart, transitionStart + transitionDuration)
+    std::vector<double> transitionStart;
+    std::vector<double> transitionDuration;
+    std::vector<int> transitionFirstSequence;   // 转场前后两个片段在所属轨道中的下标，-1 表示没有
+    std::vector<int> transitionSecondSequence;
+    std::vector<std::shared_ptr<TransitionRenderer>> transitionRenderers;
+
+    // 有动画的片段编译后的关键帧
+    std::vector<SequenceKeyframes> keyframes;
+
+    void clear();
+
+    static SceneModel compile(const std::vector<std::vector<nlohmann::json>>& sequences,
+                              const std::map<std::string, std::shared_ptr<VideoRenderer>>& rendererMap,
+                              const std::map<std::string, std::shared_ptr<PluginRenderer>>& pluginRendererMap,
+                              const std::map<std::string, std::shared_ptr<TransitionRenderer>>& transitionRendererMap);
+};
+
+#endif // SCENE_MODEL_H
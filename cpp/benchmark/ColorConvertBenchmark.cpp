@@ -0,0 +1,179 @@
+// ColorConvertBenchmark.cpp
+// ColorConverter 与 sws_scale 的对比：每种读回格式分别测量单帧耗时，并统计与 sws_scale 输出的最大差值
+// 计时前先检查 SSE4.1、AVX2 的输出与标量实现逐字节一致，不一致时以非零值退出
+// 用法：ColorConvertBenchmark [宽 高 帧数]，默认 1920 1080 200
+
+#include "../src/ColorConverter.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+extern "C" {
+    #include <libswscale/swscale.h>
+    #include <libavutil/imgutils.h>
+}
+
+namespace {
+
+struct Planes {
+    std::vector<std::uint8_t> data;
+    std::uint8_t* plane[3];
+    int stride[3];
+
+    // NV12 时 plane[1] 为交错的 UV 平面，plane[2] 不使用
+    Planes(int width, int height, ColorConverter::ChromaLayout chroma = ColorConverter::ChromaLayout::I420) {
+        int chromaWidth = (width + 1) / 2;
+        int chromaHeight = (height + 1) / 2;
+        data.resize(static_cast<size_t>(width) * height + 2 * static_cast<size_t>(chromaWidth) * chromaHeight);
+        plane[0] = data.data();
+        plane[1] = plane[0] + static_cast<size_t>(width) * height;
+        stride[0] = width;
+        if (chroma == ColorConverter::ChromaLayout::NV12) {
+            plane[2] = nullptr;
+            stride[1] = 2 * chromaWidth;
+            stride[2] = 0;
+        } else {
+            plane[2] = plane[1] + static_cast<size_t>(chromaWidth) * chromaHeight;
+            stride[1] = chromaWidth;
+            stride[2] = chromaWidth;
+        }
+    }
+};
+
+// 返回单帧平均毫秒数
+double measure(int frames, const std::function<void()>& convert) {
+    convert();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        convert();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / frames;
+}
+
+int maxDifference(const Planes& a, const Planes& b) {
+    int difference = 0;
+    for (size_t i = 0; i < a.data.size(); i++) {
+        difference = std::max(difference, std::abs(a.data[i] - b.data[i]));
+    }
+    return difference;
+}
+
+// 各像素排列、色度排列和范围下，CPU 支持的每个 SIMD 实现与标量实现的输出逐字节比较，返回不一致的组合数
+// 除给定尺寸外再测一个宽度不是 8、16 倍数的奇数尺寸，覆盖向量循环之后的尾部
+int checkIsaConsistency(int width, int height, std::mt19937& random) {
+    const ColorConverter::PixelLayout pixelLayouts[] = {ColorConverter::PixelLayout::RGB24, ColorConverter::PixelLayout::RGBA, ColorConverter::PixelLayout::BGRA};
+    const char* const pixelLayoutNames[] = {"RGB24", "RGBA", "BGRA"};
+    const ColorConverter::ChromaLayout chromaLayouts[] = {ColorConverter::ChromaLayout::I420, ColorConverter::ChromaLayout::NV12};
+    const ColorConverter::Isa simdIsas[] = {ColorConverter::Isa::SSE41, ColorConverter::Isa::AVX2};
+    const int sizes[][2] = {{width, height}, {61, 35}};
+
+    int mismatches = 0;
+    for (const auto& size : sizes) {
+        for (int p = 0; p < 3; p++) {
+            int bytesPerPixel = pixelLayouts[p] == ColorConverter::PixelLayout::RGB24 ? 3 : 4;
+            std::vector<std::uint8_t> source(static_cast<size_t>(size[0]) * size[1] * bytesPerPixel);
+            for (auto& value : source) value = static_cast<std::uint8_t>(random());
+            int sourceStride = size[0] * bytesPerPixel;
+
+            for (ColorConverter::ChromaLayout chroma : chromaLayouts) {
+                for (bool fullRange : {false, true}) {
+                    ColorConverter scalarConverter(size[0], size[1], pixelLayouts[p], fullRange, 1);
+                    scalarConverter.setIsa(ColorConverter::Isa::Scalar);
+                    Planes expected(size[0], size[1], chroma);
+                    scalarConverter.convert(source.data(), sourceStride, expected.plane, expected.stride, chroma);
+
+                    for (ColorConverter::Isa isa : simdIsas) {
+                        if (static_cast<int>(isa) > static_cast<int>(ColorConverter::detectIsa())) continue;
+                        ColorConverter converter(size[0], size[1], pixelLayouts[p], fullRange, 1);
+                        converter.setIsa(isa);
+                        Planes output(size[0], size[1], chroma);
+                        converter.convert(source.data(), sourceStride, output.plane, output.stride, chroma);
+                        auto mismatch = std::mismatch(output.data.begin(), output.data.end(), expected.data.begin());
+                        if (mismatch.first != output.data.end()) {
+                            mismatches++;
+                            std::cerr << "[错误] " << ColorConverter::isaName(isa) << " 与标量输出不一致: " << pixelLayoutNames[p]
+                                      << (chroma == ColorConverter::ChromaLayout::NV12 ? " NV12" : " I420")
+                                      << (fullRange ? " 完整范围 " : " 有限范围 ") << size[0] << "x" << size[1]
+                                      << "，字节 " << (mismatch.first - output.data.begin()) << ": "
+                                      << static_cast<int>(*mismatch.first) << " != " << static_cast<int>(*mismatch.second) << std::endl;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int width = argc > 2 ? std::atoi(argv[1]) : 1920;
+    int height = argc > 2 ? std::atoi(argv[2]) : 1080;
+    int frames = argc > 3 ? std::atoi(argv[3]) : 200;
+    int threads = static_cast<int>(std::max(1u, std::min(4u, std::thread::hardware_concurrency() / 2)));
+
+    struct Layout {
+        const char* name;
+        ColorConverter::PixelLayout layout;
+        AVPixelFormat format;
+        int bytesPerPixel;
+    };
+    const Layout layouts[] = {
+        {"RGB24", ColorConverter::PixelLayout::RGB24, AV_PIX_FMT_RGB24, 3},
+        {"RGBA", ColorConverter::PixelLayout::RGBA, AV_PIX_FMT_RGBA, 4},
+        {"BGRA", ColorConverter::PixelLayout::BGRA, AV_PIX_FMT_BGRA, 4},
+    };
+
+    std::mt19937 random(1);
+    std::cout << width << "x" << height << ", " << frames << " 帧, CPU 最高支持 "
+              << ColorConverter::isaName(ColorConverter::detectIsa()) << std::endl;
+
+    if (checkIsaConsistency(width, height, random) > 0) {
+        return 1;
+    }
+    std::cout << "SIMD 实现与标量实现输出一致" << std::endl;
+
+    for (const Layout& layout : layouts) {
+        std::vector<std::uint8_t> source(static_cast<size_t>(width) * height * layout.bytesPerPixel);
+        for (auto& value : source) value = static_cast<std::uint8_t>(random());
+        int sourceStride = width * layout.bytesPerPixel;
+
+        // sws_scale 基准：与编码器原来的用法相同，负步幅翻转
+        SwsContext* sws = sws_getContext(width, height, layout.format, width, height, AV_PIX_FMT_YUV420P,
+                                         SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+        sws_setColorspaceDetails(sws, sws_getCoefficients(SWS_CS_DEFAULT), 1,
+                                 sws_getCoefficients(SWS_CS_ITU709), 0, 0, 1 << 16, 1 << 16);
+        Planes swsOutput(width, height);
+        const std::uint8_t* flippedSource[1] = {source.data() + static_cast<size_t>(sourceStride) * (height - 1)};
+        const int flippedStride[1] = {-sourceStride};
+        double swsMs = measure(frames, [&]() {
+            sws_scale(sws, flippedSource, flippedStride, 0, height, swsOutput.plane, swsOutput.stride);
+        });
+        sws_freeContext(sws);
+        std::cout << layout.name << "  sws_scale: " << swsMs << " ms" << std::endl;
+
+        const ColorConverter::Isa isas[] = {ColorConverter::Isa::Scalar, ColorConverter::Isa::SSE41, ColorConverter::Isa::AVX2};
+        for (ColorConverter::Isa isa : isas) {
+            if (static_cast<int>(isa) > static_cast<int>(ColorConverter::detectIsa())) continue;
+            for (int threadCount : {1, threads}) {
+                ColorConverter converter(width, height, layout.layout, false, threadCount);
+                converter.setIsa(isa);
+                Planes output(width, height);
+                double ms = measure(frames, [&]() {
+                    converter.convert(source.data(), sourceStride, output.plane, output.stride, ColorConverter::ChromaLayout::I420);
+                });
+                std::cout << layout.name << "  " << ColorConverter::isaName(isa) << " x" << threadCount << ": " << ms
+                          << " ms (" << swsMs / ms << "x)，与 sws_scale 最大差值 " << maxDifference(output, swsOutput) << std::endl;
+                if (threadCount == threads) break;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,225 @@
+// AsyncVideoResource.cpp
+
+#include "AsyncVideoResource.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+AsyncVideoResource::AsyncVideoResource(const std::string& filePath, size_t ringCapacity)
+    : VideoResource(filePath), ringCapacity(std::max<size_t>(ringCapacity, 1)) {
+    for (size_t i = 0; i < this->ringCapacity + 1; i++) {
+        freeFrames.push_back(av_frame_alloc());
+    }
+}
+
+AsyncVideoResource::~AsyncVideoResource() {
+    // 基类析构时释放解码器，解码线程必须先退出
+    stopDecoder();
+    for (Slot& slot : ring) {
+        av_frame_free(&slot.frame);
+    }
+    for (AVFrame*& frame : freeFrames) {
+        av_frame_free(&frame);
+    }
+}
+
+bool AsyncVideoResource::initialize(int rotate) {
+    // 复用时先停下解码线程，基类会把解复用器定位回开头
+    stopDecoder();
+    if (!VideoResource::initialize(rotate)) {
+        return false;
+    }
+    startDecoder();
+    return true;
+}
+
+void AsyncVideoResource::setDecodeScale(double scale) {
+    // 解码线程独占解码器和 swsContext，重新配置前先停下
+    bool running = decoderThread.joinable();
+    stopDecoder();
+    VideoResource::setDecodeScale(scale);
+    if (running) {
+        startDecoder();
+    }
+}
+
+void AsyncVideoResource::startDecoder() {
+    while (!ring.empty()) {
+        recycle(ring.front().frame);
+        ring.pop_front();
+    }
+    requestEpoch = 0;
+    seekTarget = 0.0;
+    frontier = 0.0;
+    drained = false;
+    stopping = false;
+    decoderThread = std::thread(&AsyncVideoResource::decodeLoop, this);
+}
+
+void AsyncVideoResource::stopDecoder() {
+    if (!decoderThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    decoderCV.notify_all();
+    decoderThread.join();
+}
+
+void AsyncVideoResource::requestSeek(double time) {
+    requestEpoch++;
+    seekTarget = time;
+    frontier = time;
+    drained = false;
+    while (!ring.empty()) {
+        recycle(ring.front().frame);
+        ring.pop_front();
+    }
+    decoderCV.notify_one();
+}
+
+void AsyncVideoResource::recycle(AVFrame* frame) {
+    // 释放对解码器缓冲区的引用
+    av_frame_unref(frame);
+    freeFrames.push_back(frame);
+}
+
+void AsyncVideoResource::upload(Slot& slot) {
+    uploadFrame(slot.frame);
+    preTime = slot.time;
+}
+
+void AsyncVideoResource::decodeLoop() {
+    // 解码线程独占基类的解复用器、解码器和 swsContext
+    std::uint64_t epoch = 0;
+    double target = 0.0;
+    // 本 epoch 是否已有帧放入环中；没有时到达末尾要交出最后解码的一帧
+    bool delivered = false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        decoderCV.wait(lock, [&]() {
+            return stopping || requestEpoch != epoch || (!drained && ring.size() < ringCapacity);
+        });
+        if (stopping) {
+            break;
+        }
+        if (requestEpoch != epoch) {
+            epoch = requestEpoch;
+            target = seekTarget;
+            delivered = false;
+            lock.unlock();
+            seekTo(target);
+            lock.lock();
+            continue;
+        }
+
+        // 环未满时至少还有一个空闲的帧
+        AVFrame* frame = freeFrames.back();
+        freeFrames.pop_back();
+        lock.unlock();
+
+        // 定位后从关键帧解码到目标，目标之前的帧不放入环
+        const double tolerance = frameDuration * 0.5;
+        bool decoded = decodeNextFrame();
+        double time = lastDecodedTime;
+        bool keep = false;
+        if (decoded) {
+            keep = time >= target - tolerance;
+            if (keep) {
+                keep = prepareFrame(avFrame, frame);
+                av_frame_unref(avFrame);
+            } else {
+                av_frame_unref(lastDecodedFrame);
+                av_frame_move_ref(lastDecodedFrame, avFrame);
+            }
+        } else if (!delivered && lastDecodedFrame->buf[0]) {
+            // 目标超出最后一帧：用最后解码的帧
+            time = frameTime(lastDecodedFrame);
+            keep = prepareFrame(lastDecodedFrame, frame);
+        }
+        if (keep) {
+            av_frame_unref(lastDecodedFrame);
+        }
+
+        lock.lock();
+        if (requestEpoch != epoch) {
+            // 解码期间渲染线程已经定位到别处
+            recycle(frame);
+            continue;
+        }
+        if (keep) {
+            ring.push_back(Slot{time, frame});
+            frontier = time;
+            delivered = true;
+        } else {
+            recycle(frame);
+        }
+        if (!decoded) {
+            drained = true;
+        }
+        if (keep || !decoded) {
+            readyCV.notify_all();
+        }
+    }
+}
+
+bool AsyncVideoResource::getFrameAt(double time) {
+    if (!decoderThread.joinable()) {
+        return false;
+    }
+
+    // 离纹理中的画面不到半帧：仍是同一帧
+    const double tolerance = frameDuration * 0.5;
+    if (preTime >= 0.0 && std::abs(preTime - time) <= tolerance) {
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    // 目标在环中最早的帧之前（循环播放、倒退），或远远超过解码位置：重新定位
+    double earliest = ring.empty() ? frontier : ring.front().time;
+    // 超前 kSeekAheadSeconds 且超过环能容纳的时长时定位，而不是继续向前解码
+    double seekAhead = std::max(kSeekAheadSeconds, ringCapacity * frameDuration);
+    if (time < earliest - tolerance || time - frontier > seekAhead) {
+        requestSeek(time);
+    }
+
+    // 丢掉目标之前的帧，取第一帧不早于目标（允许半帧误差）的帧
+    Slot stale;
+    bool hasStale = false;
+    while (true) {
+        while (!ring.empty()) {
+            Slot slot = ring.front();
+            ring.pop_front();
+            decoderCV.notify_one();
+            if (slot.time >= time - tolerance) {
+                if (hasStale) recycle(stale.frame);
+                lock.unlock();
+                upload(slot);
+                lock.lock();
+                recycle(slot.frame);
+                return true;
+            }
+            if (hasStale) recycle(stale.frame);
+            stale = slot;
+            hasStale = true;
+        }
+        if (drained) {
+            break;
+        }
+        readyCV.wait(lock, [this]() { return !ring.empty() || drained; });
+    }
+
+    // 解码线程已到达末尾：使用最后一帧
+    if (hasStale) {
+        lock.unlock();
+        upload(stale);
+        lock.lock();
+        recycle(stale.frame);
+    }
+    std::cerr << "[警告] 已到达视频末尾，未能找到精确的帧，但已使用最后解码的帧:" << time << " 秒。" << std::endl;
+    return true;
+}
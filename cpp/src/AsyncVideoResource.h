@@ -0,0 +1,65 @@
+// AsyncVideoResource.h
+
+#ifndef ASYNCVIDEORESOURCE_H
+#define ASYNCVIDEORESOURCE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "VideoResource.h"
+
+// 在后台线程解复用、解码的视频资源
+// 解码线程领先播放位置填充一个有界的帧环，渲染线程只从环中挑选当前时间的帧并上传纹理，
+// 解码与渲染重叠进行；定位请求带有 epoch，旧 epoch 解出的帧会被丢弃，不会混入新位置的帧
+class AsyncVideoResource : public VideoResource {
+public:
+    explicit AsyncVideoResource(const std::string& filePath, size_t ringCapacity = kDefaultRingCapacity);
+    ~AsyncVideoResource() override;
+
+    bool initialize(int rotate) override;
+    bool getFrameAt(double time) override;
+    void setDecodeScale(double scale) override;
+
+    static constexpr size_t kDefaultRingCapacity = 6;
+
+private:
+    // 环中一帧：时间和 prepareFrame 得到的帧（通常只是解码器输出的引用）
+    struct Slot {
+        double time = 0.0;
+        AVFrame* frame = nullptr;
+    };
+
+    void startDecoder();
+    void stopDecoder();
+    void decodeLoop();
+    // 需持有 mutex：清空环，让解码线程从 time 之前的关键帧重新解码
+    void requestSeek(double time);
+    void recycle(AVFrame* frame);
+    void upload(Slot& slot);
+
+    size_t ringCapacity;
+
+    std::thread decoderThread;
+    std::mutex mutex;
+    // 解码线程等待：环有空位、有新的定位请求或需要停止
+    std::condition_variable decoderCV;
+    // 渲染线程等待：环中有新帧或解码线程已到达末尾
+    std::condition_variable readyCV;
+    std::deque<Slot> ring;
+    // 空闲的帧，共 ringCapacity + 1 个，环满时渲染线程仍可持有一个
+    std::vector<AVFrame*> freeFrames;
+
+    // 渲染线程每次定位加一，解码线程处理完定位后才开始为新 epoch 出帧
+    std::uint64_t requestEpoch = 0;
+    double seekTarget = 0.0;
+    // 当前 epoch 最近放入环中的帧时间（还没有时为定位目标）
+    double frontier = 0.0;
+    // 当前 epoch 已解码到文件末尾
+    bool drained = false;
+    bool stopping = false;
+};
+
+#endif // ASYNCVIDEORESOURCE_H
@@ -0,0 +1,361 @@
+// AudioMixer.cpp
+
+#include "AudioMixer.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/audio_fifo.h>
+#include <libswresample/swresample.h>
+}
+
+// x86-64 上 SSE 是基本指令集，不需要运行时检测
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define AUDIOMIXER_SSE 1
+#include <xmmintrin.h>
+#endif
+
+bool AudioClip::fromSequence(const std::string& path, const nlohmann::json& sequence, AudioClip& clip) {
+    const auto& timer = sequence["timer"];
+    double originalDuration = timer["originalDuration"].get<double>();
+    clip.path = path;
+    clip.offset = timer["offset"].get<double>();
+    clip.rate = timer["rate"].get<double>();
+    clip.originalStart = timer["start"].get<double>() * originalDuration;
+    clip.trimmedDuration = clip.rate > 0.0 ? timer["duration"].get<double>() * (originalDuration / clip.rate) : 0.0;
+    if (sequence.contains("audio") && sequence["audio"].is_object()) {
+        const auto& audio = sequence["audio"];
+        clip.streamIndex = audio.value("index", 0);
+        clip.volume = audio.value("volume", 1.0f);
+    }
+    return clip.volume > 0.0f && clip.trimmedDuration > 0.0 && !clip.path.empty();
+}
+
+// 单个片段的解码器：从定位点开始解码，重采样到输出格式后放入 FIFO
+class AudioMixer::Source {
+public:
+    Source(const AudioClip& clip, int sampleRate, int channels)
+        : clip(clip), sampleRate(sampleRate), channels(channels) {}
+    ~Source();
+
+    // 打开文件并定位到 sourceTime（毫秒，资源自身的时间）
+    bool open(double sourceTime);
+    // 读出 count 个采样，文件结束后补静音
+    void read(float* const* planes, int count);
+
+private:
+    // 解码一帧送入 FIFO，文件结束返回 false
+    bool decodeNext();
+    void pushConverted(int converted);
+    void pushSilence(std::int64_t count);
+    float** convertPlanes(int count);
+
+    const AudioClip& clip;
+    int sampleRate;
+    int channels;
+
+    AVFormatContext* formatContext = nullptr;
+    AVCodecContext* codecContext = nullptr;
+    SwrContext* swrContext = nullptr;
+    AVAudioFifo* fifo = nullptr;
+    AVPacket* packet = nullptr;
+    AVFrame* frame = nullptr;
+    int audioStreamIndex = -1;
+
+    double targetSeconds = 0.0;
+    // 定位后第一帧用来对齐到 targetSeconds
+    bool pendingAlign = true;
+    std::int64_t dropSamples = 0;
+    bool inputFinished = false;
+    bool finished = false;
+
+    std::vector<std::vector<float>> convertBuffer;
+    std::vector<float*> convertPointers;
+};
+
+AudioMixer::Source::~Source() {
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    if (fifo) av_audio_fifo_free(fifo);
+    swr_free(&swrContext);
+    avcodec_free_context(&codecContext);
+    avformat_close_input(&formatContext);
+}
+
+bool AudioMixer::Source::open(double sourceTime) {
+    if (avformat_open_input(&formatContext, clip.path.c_str(), nullptr, nullptr) < 0) {
+        std::cerr << "无法打开音频: " << clip.path << std::endl;
+        return false;
+    }
+    if (avformat_find_stream_info(formatContext, nullptr) < 0) {
+        std::cerr << "无法读取音频流信息: " << clip.path << std::endl;
+        return false;
+    }
+
+    // audio.index 是文件中音频流的序号，不是流的下标
+    int audioCount = 0;
+    for (unsigned int i = 0; i < formatContext->nb_streams; i++) {
+        if (formatContext->streams[i]->codecpar->codec_type != AVMEDIA_TYPE_AUDIO) continue;
+        if (audioCount++ == clip.streamIndex) {
+            audioStreamIndex = static_cast<int>(i);
+            break;
+        }
+    }
+    if (audioStreamIndex < 0) {
+        // 没有音轨的视频很常见，不算错误，只是不再尝试
+        return false;
+    }
+    AVStream* stream = formatContext->streams[audioStreamIndex];
+
+    const AVCodec* decoder = avcodec_find_decoder(stream->codecpar->codec_id);
+    codecContext = decoder ? avcodec_alloc_context3(decoder) : nullptr;
+    if (!codecContext || avcodec_parameters_to_context(codecContext, stream->codecpar) < 0 ||
+        avcodec_open2(codecContext, decoder, nullptr) < 0) {
+        std::cerr << "无法打开音频解码器: " << clip.path << std::endl;
+        return false;
+    }
+
+    // 变速：把输入采样率当作 sampleRate * rate，重采样后时长按 1 / rate 缩放（音调随之变化）
+    AVChannelLayout inLayout;
+    AVChannelLayout outLayout;
+    if (codecContext->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC) {
+        av_channel_layout_default(&inLayout, codecContext->ch_layout.nb_channels);
+    } else {
+        av_channel_layout_copy(&inLayout, &codecContext->ch_layout);
+    }
+    av_channel_layout_default(&outLayout, channels);
+    int inRate = static_cast<int>(std::lround(codecContext->sample_rate * clip.rate));
+    int result = swr_alloc_set_opts2(&swrContext, &outLayout, AV_SAMPLE_FMT_FLTP, sampleRate,
+                                     &inLayout, codecContext->sample_fmt, inRate, 0, nullptr);
+    av_channel_layout_uninit(&inLayout);
+    av_channel_layout_uninit(&outLayout);
+    if (result < 0 || inRate <= 0 || swr_init(swrContext) < 0) {
+        std::cerr << "无法创建音频重采样: " << clip.path << std::endl;
+        return false;
+    }
+
+    fifo = av_audio_fifo_alloc(AV_SAMPLE_FMT_FLTP, channels, 4096);
+    packet = av_packet_alloc();
+    frame = av_frame_alloc();
+    if (!fifo || !packet || !frame) {
+        std::cerr << "无法分配音频缓冲区" << std::endl;
+        return false;
+    }
+
+    // 定位到目标之前的位置，第一帧解码后再精确对齐；定位失败时从头解码，同样能对齐
+    targetSeconds = std::max(0.0, sourceTime / 1000.0);
+    if (targetSeconds > 0.0) {
+        std::int64_t timestamp = av_rescale_q(static_cast<std::int64_t>(targetSeconds * AV_TIME_BASE), AV_TIME_BASE_Q, stream->time_base);
+        if (stream->start_time != AV_NOPTS_VALUE) {
+            timestamp += stream->start_time;
+        }
+        av_seek_frame(formatContext, audioStreamIndex, timestamp, AVSEEK_FLAG_BACKWARD);
+    }
+    return true;
+}
+
+bool AudioMixer::Source::decodeNext() {
+    while (true) {
+        int result = avcodec_receive_frame(codecContext, frame);
+        if (result == 0) {
+            int capacity = swr_get_out_samples(swrContext, frame->nb_samples);
+            int converted = swr_convert(swrContext, reinterpret_cast<uint8_t**>(convertPlanes(capacity)), capacity,
+                                        const_cast<const uint8_t**>(frame->extended_data), frame->nb_samples);
+            if (pendingAlign && frame->best_effort_timestamp != AV_NOPTS_VALUE) {
+                AVStream* stream = formatContext->streams[audioStreamIndex];
+                std::int64_t startTime = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+                double frameSeconds = (frame->best_effort_timestamp - startTime) * av_q2d(stream->time_base);
+                // 正数：帧早于目标，丢掉前面的采样；负数：帧晚于目标，先补静音
+                std::int64_t offsetSamples = std::llround((targetSeconds - frameSeconds) / clip.rate * sampleRate);
+                if (offsetSamples > 0) {
+                    dropSamples = offsetSamples;
+                } else if (offsetSamples < 0) {
+                    pushSilence(-offsetSamples);
+                }
+            }
+            pendingAlign = false;
+            av_frame_unref(frame);
+            pushConverted(converted);
+            return true;
+        }
+        if (result != AVERROR(EAGAIN)) {
+            // 解码器已刷新完，取出重采样器中剩余的采样
+            if (!finished) {
+                finished = true;
+                int remaining = swr_get_out_samples(swrContext, 0);
+                if (remaining > 0) {
+                    pushConverted(swr_convert(swrContext, reinterpret_cast<uint8_t**>(convertPlanes(remaining)), remaining, nullptr, 0));
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        if (inputFinished) {
+            return false;
+        }
+        if (av_read_frame(formatContext, packet) < 0) {
+            inputFinished = true;
+            avcodec_send_packet(codecContext, nullptr);
+            continue;
+        }
+        if (packet->stream_index == audioStreamIndex) {
+            avcodec_send_packet(codecContext, packet);
+        }
+        av_packet_unref(packet);
+    }
+}
+
+float** AudioMixer::Source::convertPlanes(int count) {
+    convertBuffer.resize(channels);
+    convertPointers.resize(channels);
+    for (int c = 0; c < channels; c++) {
+        if (convertBuffer[c].size() < static_cast<size_t>(count)) {
+            convertBuffer[c].resize(count);
+        }
+        convertPointers[c] = convertBuffer[c].data();
+    }
+    return convertPointers.data();
+}
+
+void AudioMixer::Source::pushConverted(int converted) {
+    if (converted <= 0) {
+        return;
+    }
+    int skip = static_cast<int>(std::min<std::int64_t>(dropSamples, converted));
+    dropSamples -= skip;
+    if (converted == skip) {
+        return;
+    }
+    std::vector<void*> planes(channels);
+    for (int c = 0; c < channels; c++) {
+        planes[c] = convertBuffer[c].data() + skip;
+    }
+    av_audio_fifo_write(fifo, planes.data(), converted - skip);
+}
+
+void AudioMixer::Source::pushSilence(std::int64_t count) {
+    const int chunk = 4096;
+    std::vector<float> zeros(chunk, 0.0f);
+    std::vector<void*> planes(channels, zeros.data());
+    while (count > 0) {
+        int samples = static_cast<int>(std::min<std::int64_t>(count, chunk));
+        av_audio_fifo_write(fifo, planes.data(), samples);
+        count -= samples;
+    }
+}
+
+void AudioMixer::Source::read(float* const* planes, int count) {
+    while (av_audio_fifo_size(fifo) < count && decodeNext()) {
+    }
+    int available = std::min(count, av_audio_fifo_size(fifo));
+    if (available > 0) {
+        av_audio_fifo_read(fifo, reinterpret_cast<void* const*>(planes), available);
+    }
+    for (int c = 0; c < channels; c++) {
+        std::fill(planes[c] + available, planes[c] + count, 0.0f);
+    }
+}
+
+AudioMixer::AudioMixer(std::vector<AudioClip> clips, double timelineStart, int sampleRate, int channels)
+    : clips(std::move(clips)), timelineStart(timelineStart), sampleRate(sampleRate), channels(channels) {
+    sources.resize(this->clips.size());
+    failed.assign(this->clips.size(), false);
+    scratch.resize(channels);
+}
+
+AudioMixer::~AudioMixer() = default;
+
+std::int64_t AudioMixer::clipFirstSample(const AudioClip& clip) const {
+    return static_cast<std::int64_t>(std::ceil((clip.offset - timelineStart) * sampleRate / 1000.0));
+}
+
+std::int64_t AudioMixer::clipLastSample(const AudioClip& clip) const {
+    return static_cast<std::int64_t>(std::ceil((clip.offset + clip.trimmedDuration - timelineStart) * sampleRate / 1000.0));
+}
+
+void AudioMixer::mix(float* const* planes, int sampleCount) {
+    for (int c = 0; c < channels; c++) {
+        std::fill(planes[c], planes[c] + sampleCount, 0.0f);
+    }
+
+    std::int64_t blockEnd = position + sampleCount;
+    std::vector<float*> scratchPlanes(channels);
+    for (size_t i = 0; i < clips.size(); i++) {
+        if (failed[i]) continue;
+        const AudioClip& clip = clips[i];
+        std::int64_t last = clipLastSample(clip);
+        std::int64_t from = std::max(clipFirstSample(clip), position);
+        std::int64_t to = std::min(last, blockEnd);
+        if (from >= to) {
+            if (position >= last) sources[i].reset();
+            continue;
+        }
+
+        if (!sources[i]) {
+            double globalTime = timelineStart + from * 1000.0 / sampleRate;
+            double sourceTime = (globalTime - clip.offset) * clip.rate + clip.originalStart;
+            auto source = std::make_unique<Source>(clip, sampleRate, channels);
+            if (!source->open(sourceTime)) {
+                failed[i] = true;
+                continue;
+            }
+            sources[i] = std::move(source);
+        }
+
+        int count = static_cast<int>(to - from);
+        for (int c = 0; c < channels; c++) {
+            if (scratch[c].size() < static_cast<size_t>(count)) {
+                scratch[c].resize(count);
+            }
+            scratchPlanes[c] = scratch[c].data();
+        }
+        sources[i]->read(scratchPlanes.data(), count);
+        for (int c = 0; c < channels; c++) {
+            mixInto(planes[c] + (from - position), scratchPlanes[c], clip.volume, count);
+        }
+
+        // 片段已结束，关闭解码器
+        if (to >= last) sources[i].reset();
+    }
+
+    for (int c = 0; c < channels; c++) {
+        clamp(planes[c], sampleCount);
+    }
+    position = blockEnd;
+}
+
+void AudioMixer::mixInto(float* dst, const float* src, float gain, int count) {
+    int i = 0;
+#ifdef AUDIOMIXER_SSE
+    const __m128 g = _mm_set1_ps(gain);
+    for (; i + 8 <= count; i += 8) {
+        __m128 d0 = _mm_loadu_ps(dst + i);
+        __m128 d1 = _mm_loadu_ps(dst + i + 4);
+        d0 = _mm_add_ps(d0, _mm_mul_ps(_mm_loadu_ps(src + i), g));
+        d1 = _mm_add_ps(d1, _mm_mul_ps(_mm_loadu_ps(src + i + 4), g));
+        _mm_storeu_ps(dst + i, d0);
+        _mm_storeu_ps(dst + i + 4, d1);
+    }
+#endif
+    for (; i < count; i++) {
+        dst[i] += src[i] * gain;
+    }
+}
+
+void AudioMixer::clamp(float* samples, int count) {
+    int i = 0;
+#ifdef AUDIOMIXER_SSE
+    const __m128 lower = _mm_set1_ps(-1.0f);
+    const __m128 upper = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(samples + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples + i), lower), upper));
+    }
+#endif
+    for (; i < count; i++) {
+        samples[i] = std::min(1.0f, std::max(-1.0f, samples[i]));
+    }
+}
@@ -0,0 +1,69 @@
+// AudioMixer.h
+
+#ifndef AUDIOMIXER_H
+#define AUDIOMIXER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../nlohmann/json.hpp"
+
+// 时间轴上的一段音频，时间单位与 SceneModel 一致（毫秒）
+struct AudioClip {
+    std::string path;
+    int streamIndex = 0;          // audio.index：文件中的第几条音频流
+    double offset = 0.0;          // timer.offset
+    double trimmedDuration = 0.0; // duration * (originalDuration / rate)
+    double originalStart = 0.0;   // start * originalDuration
+    double rate = 1.0;            // timer.rate，变速同时变调
+    float volume = 1.0f;          // audio.volume，线性增益
+
+    // 按片段的 timer 和 audio 设置生成，静音或时长为 0 时返回 false
+    static bool fromSequence(const std::string& path, const nlohmann::json& sequence, AudioClip& clip);
+};
+
+// 把时间轴上所有片段的音频解码、重采样到统一格式（平面 float）并按音量混合
+// 由编码线程按输出顺序调用 mix()，片段只在进入可见区间时打开解码器，离开后关闭
+class AudioMixer {
+public:
+    // timelineStart 为输出第 0 个采样对应的全局时间（毫秒）
+    AudioMixer(std::vector<AudioClip> clips, double timelineStart, int sampleRate, int channels);
+    ~AudioMixer();
+
+    AudioMixer(const AudioMixer&) = delete;
+    AudioMixer& operator=(const AudioMixer&) = delete;
+
+    // 输出接下来的 sampleCount 个采样，planes 为 channels 个平面；没有片段的部分为静音
+    void mix(float* const* planes, int sampleCount);
+
+    int getSampleRate() const { return sampleRate; }
+    int getChannels() const { return channels; }
+
+    // dst += src * gain
+    static void mixInto(float* dst, const float* src, float gain, int count);
+    // 限制到 [-1, 1]
+    static void clamp(float* samples, int count);
+
+private:
+    class Source;
+
+    // 片段在输出采样上的区间 [first, last)
+    std::int64_t clipFirstSample(const AudioClip& clip) const;
+    std::int64_t clipLastSample(const AudioClip& clip) const;
+
+    std::vector<AudioClip> clips;
+    // 与 clips 对齐，只有正在播放的片段才有解码器
+    std::vector<std::unique_ptr<Source>> sources;
+    // 打开失败的片段不再重试
+    std::vector<bool> failed;
+    double timelineStart;
+    int sampleRate;
+    int channels;
+    // 已输出的采样数
+    std::int64_t position = 0;
+    // 单个片段读出的采样，之后混合到输出
+    std::vector<std::vector<float>> scratch;
+};
+
+#endif // AUDIOMIXER_H
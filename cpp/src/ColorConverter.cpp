@@ -0,0 +1,496 @@
+// ColorConverter.cpp
+
+#include "ColorConverter.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define COLORCONVERTER_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// GCC/Clang 需要按函数打开指令集，MSVC 不需要
+#if defined(COLORCONVERTER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE41
+#define TARGET_AVX2
+#endif
+
+namespace {
+
+using Coefficients = ColorConverter::Coefficients;
+using ShuffleMasks = ColorConverter::ShuffleMasks;
+
+// 一行转换需要的参数
+struct RowContext {
+    int width;
+    int bytesPerPixel;
+    const int* channelOffset;
+    const Coefficients* coefficients;
+    const ShuffleMasks* masks;
+};
+
+constexpr int kShift = 15;
+
+// BT.709：Kr = 0.2126，Kb = 0.0722；有限范围 Y 缩放到 219/255 加 16，UV 缩放到 224/255 加 128
+Coefficients makeCoefficients(bool fullRange) {
+    const double kr = 0.2126;
+    const double kb = 0.0722;
+    const double lumaScale = fullRange ? 1.0 : 219.0 / 255.0;
+    const double chromaScale = fullRange ? 1.0 : 224.0 / 255.0;
+    const double one = 1 << kShift;
+    auto fixed = [&](double value) { return static_cast<std::int16_t>(std::lround(value * one)); };
+
+    Coefficients c;
+    // G 系数由总和反推，保证白色得到准确的最大值、灰色的色度准确为 128
+    c.yr = fixed(kr * lumaScale);
+    c.yb = fixed(kb * lumaScale);
+    c.yg = static_cast<std::int16_t>(fixed(lumaScale) - c.yr - c.yb);
+    c.yOffset = ((fullRange ? 0 : 16) << kShift) + (1 << (kShift - 1));
+
+    c.ur = fixed(-kr / (2.0 * (1.0 - kb)) * chromaScale);
+    c.ub = fixed(0.5 * chromaScale);
+    c.ug = static_cast<std::int16_t>(-c.ur - c.ub);
+    c.vr = fixed(0.5 * chromaScale);
+    c.vb = fixed(-kb / (2.0 * (1.0 - kr)) * chromaScale);
+    c.vg = static_cast<std::int16_t>(-c.vr - c.vb);
+    c.chromaOffset = (128 << kShift) + (1 << (kShift - 1));
+    return c;
+}
+
+ShuffleMasks makeMasks(int bytesPerPixel, const int channelOffset[3]) {
+    ShuffleMasks m;
+    for (int channel = 0; channel < 3; channel++) {
+        for (int i = 0; i < 16; i++) {
+            m.first[channel][i] = 0x80;
+            m.second[channel][i] = 0x80;
+        }
+        for (int pixel = 0; pixel < 8; pixel++) {
+            int index = pixel * bytesPerPixel + channelOffset[channel];
+            if (index < 16) {
+                m.first[channel][pixel * 2] = static_cast<std::uint8_t>(index);
+            } else {
+                m.second[channel][pixel * 2] = static_cast<std::uint8_t>(index - 16);
+            }
+        }
+    }
+    return m;
+}
+
+inline std::uint8_t clampByte(std::int32_t value) {
+    return static_cast<std::uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// ---------- 标量实现，也用于 SIMD 处理不完的行尾 ----------
+
+void lumaRowScalar(const RowContext& ctx, const std::uint8_t* src, std::uint8_t* dst, int start) {
+    const Coefficients& c = *ctx.coefficients;
+    for (int x = start; x < ctx.width; x++) {
+        const std::uint8_t* p = src + x * ctx.bytesPerPixel;
+        std::int32_t r = p[ctx.channelOffset[0]];
+        std::int32_t g = p[ctx.channelOffset[1]];
+        std::int32_t b = p[ctx.channelOffset[2]];
+        dst[x] = clampByte((r * c.yr + g * c.yg + b * c.yb + c.yOffset) >> kShift);
+    }
+}
+
+// 2x2 像素块取平均后转换；奇数尺寸时越界的列由调用方保证重复最后一列
+void chromaRowScalar(const RowContext& ctx, const std::uint8_t* src0, const std::uint8_t* src1,
+                     std::uint8_t* dstU, std::uint8_t* dstV, std::uint8_t* dstUV, int start) {
+    const Coefficients& c = *ctx.coefficients;
+    int chromaWidth = (ctx.width + 1) / 2;
+    for (int cx = start; cx < chromaWidth; cx++) {
+        int x0 = cx * 2;
+        int x1 = std::min(x0 + 1, ctx.width - 1);
+        std::int32_t average[3];
+        for (int channel = 0; channel < 3; channel++) {
+            int offset = ctx.channelOffset[channel];
+            std::int32_t sum = src0[x0 * ctx.bytesPerPixel + offset] + src0[x1 * ctx.bytesPerPixel + offset] +
+                               src1[x0 * ctx.bytesPerPixel + offset] + src1[x1 * ctx.bytesPerPixel + offset];
+            average[channel] = (sum + 2) >> 2;
+        }
+        std::uint8_t u = clampByte((average[0] * c.ur + average[1] * c.ug + average[2] * c.ub + c.chromaOffset) >> kShift);
+        std::uint8_t v = clampByte((average[0] * c.vr + average[1] * c.vg + average[2] * c.vb + c.chromaOffset) >> kShift);
+        if (dstUV) {
+            dstUV[cx * 2] = u;
+            dstUV[cx * 2 + 1] = v;
+        } else {
+            dstU[cx] = u;
+            dstV[cx] = v;
+        }
+    }
+}
+
+#if defined(COLORCONVERTER_X86)
+
+// ---------- SSE4.1：每次 8 个像素 ----------
+
+inline std::int32_t packPair(std::int16_t low, std::int16_t high) {
+    return static_cast<std::int32_t>(static_cast<std::uint16_t>(low) | (static_cast<std::uint32_t>(static_cast<std::uint16_t>(high)) << 16));
+}
+
+// 8 个像素的 R/G/B，各为 8 个 16 位整数
+struct Rgb128 {
+    __m128i r, g, b;
+};
+
+TARGET_SSE41 inline Rgb128 load8(const ShuffleMasks& m, const std::uint8_t* p, int bytesPerPixel) {
+    __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // RGB24 的 8 个像素只有 24 字节，只读 8 字节避免越过行尾
+    __m128i second = bytesPerPixel == 3 ? _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + 16))
+                                        : _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+    Rgb128 rgb;
+    __m128i* channels[3] = {&rgb.r, &rgb.g, &rgb.b};
+    for (int channel = 0; channel < 3; channel++) {
+        __m128i a = _mm_shuffle_epi8(first, _mm_load_si128(reinterpret_cast<const __m128i*>(m.first[channel])));
+        __m128i b = _mm_shuffle_epi8(second, _mm_load_si128(reinterpret_cast<const __m128i*>(m.second[channel])));
+        *channels[channel] = _mm_or_si128(a, b);
+    }
+    return rgb;
+}
+
+// (r*cr + g*cg + b*cb + offset) >> 15，结果为 8 个 16 位整数
+TARGET_SSE41 inline __m128i dot8(const Rgb128& rgb, std::int16_t cr, std::int16_t cg, std::int16_t cb, std::int32_t offset) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i coefficientRG = _mm_set1_epi32(packPair(cr, cg));
+    const __m128i coefficientB = _mm_set1_epi32(packPair(cb, 0));
+    const __m128i bias = _mm_set1_epi32(offset);
+    __m128i low = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(rgb.r, rgb.g), coefficientRG),
+                                _mm_madd_epi16(_mm_unpacklo_epi16(rgb.b, zero), coefficientB));
+    __m128i high = _mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(rgb.r, rgb.g), coefficientRG),
+                                 _mm_madd_epi16(_mm_unpackhi_epi16(rgb.b, zero), coefficientB));
+    low = _mm_srai_epi32(_mm_add_epi32(low, bias), kShift);
+    high = _mm_srai_epi32(_mm_add_epi32(high, bias), kShift);
+    return _mm_packs_epi32(low, high);
+}
+
+TARGET_SSE41 int lumaRowSse41(const RowContext& ctx, const std::uint8_t* src, std::uint8_t* dst) {
+    const Coefficients& c = *ctx.coefficients;
+    int x = 0;
+    for (; x + 8 <= ctx.width; x += 8) {
+        Rgb128 rgb = load8(*ctx.masks, src + x * ctx.bytesPerPixel, ctx.bytesPerPixel);
+        __m128i y = dot8(rgb, c.yr, c.yg, c.yb, c.yOffset);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(y, y));
+    }
+    return x;
+}
+
+// 16 个像素（两行）得到 8 个色度样本
+TARGET_SSE41 inline Rgb128 average16(const RowContext& ctx, const std::uint8_t* src0, const std::uint8_t* src1, int x) {
+    const int bpp = ctx.bytesPerPixel;
+    Rgb128 a0 = load8(*ctx.masks, src0 + x * bpp, bpp);
+    Rgb128 b0 = load8(*ctx.masks, src0 + (x + 8) * bpp, bpp);
+    Rgb128 a1 = load8(*ctx.masks, src1 + x * bpp, bpp);
+    Rgb128 b1 = load8(*ctx.masks, src1 + (x + 8) * bpp, bpp);
+    const __m128i two = _mm_set1_epi16(2);
+    // 先上下两行相加，再水平相邻两列相加
+    Rgb128 average;
+    average.r = _mm_srli_epi16(_mm_add_epi16(_mm_hadd_epi16(_mm_add_epi16(a0.r, a1.r), _mm_add_epi16(b0.r, b1.r)), two), 2);
+    average.g = _mm_srli_epi16(_mm_add_epi16(_mm_hadd_epi16(_mm_add_epi16(a0.g, a1.g), _mm_add_epi16(b0.g, b1.g)), two), 2);
+    average.b = _mm_srli_epi16(_mm_add_epi16(_mm_hadd_epi16(_mm_add_epi16(a0.b, a1.b), _mm_add_epi16(b0.b, b1.b)), two), 2);
+    return average;
+}
+
+TARGET_SSE41 int chromaRowSse41(const RowContext& ctx, const std::uint8_t* src0, const std::uint8_t* src1,
+                                std::uint8_t* dstU, std::uint8_t* dstV, std::uint8_t* dstUV) {
+    const Coefficients& c = *ctx.coefficients;
+    int cx = 0;
+    for (; cx * 2 + 16 <= ctx.width; cx += 8) {
+        Rgb128 average = average16(ctx, src0, src1, cx * 2);
+        __m128i u16 = dot8(average, c.ur, c.ug, c.ub, c.chromaOffset);
+        __m128i v16 = dot8(average, c.vr, c.vg, c.vb, c.chromaOffset);
+        __m128i u = _mm_packus_epi16(u16, u16);
+        __m128i v = _mm_packus_epi16(v16, v16);
+        if (dstUV) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dstUV + cx * 2), _mm_unpacklo_epi8(u, v));
+        } else {
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dstU + cx), u);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(dstV + cx), v);
+        }
+    }
+    return cx;
+}
+
+// ---------- AVX2：每次 16 个像素，低 128 位为前 8 个像素，高 128 位为后 8 个像素 ----------
+
+struct Rgb256 {
+    __m256i r, g, b;
+};
+
+TARGET_AVX2 inline Rgb256 load16(const ShuffleMasks& m, const std::uint8_t* p, int bytesPerPixel) {
+    const std::uint8_t* q = p + 8 * bytesPerPixel;
+    __m256i first = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+                                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(q)), 1);
+    __m256i second;
+    if (bytesPerPixel == 3) {
+        second = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + 16))),
+                                         _mm_loadl_epi64(reinterpret_cast<const __m128i*>(q + 16)), 1);
+    } else {
+        second = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16))),
+                                         _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + 16)), 1);
+    }
+    Rgb256 rgb;
+    __m256i* channels[3] = {&rgb.r, &rgb.g, &rgb.b};
+    for (int channel = 0; channel < 3; channel++) {
+        // pshufb 只在 128 位通道内重排，两个通道使用同一掩码
+        __m256i a = _mm256_shuffle_epi8(first, _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(m.first[channel]))));
+        __m256i b = _mm256_shuffle_epi8(second, _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(m.second[channel]))));
+        *channels[channel] = _mm256_or_si256(a, b);
+    }
+    return rgb;
+}
+
+TARGET_AVX2 inline __m256i dot16(const Rgb256& rgb, std::int16_t cr, std::int16_t cg, std::int16_t cb, std::int32_t offset) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i coefficientRG = _mm256_set1_epi32(packPair(cr, cg));
+    const __m256i coefficientB = _mm256_set1_epi32(packPair(cb, 0));
+    const __m256i bias = _mm256_set1_epi32(offset);
+    __m256i low = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpacklo_epi16(rgb.r, rgb.g), coefficientRG),
+                                   _mm256_madd_epi16(_mm256_unpacklo_epi16(rgb.b, zero), coefficientB));
+    __m256i high = _mm256_add_epi32(_mm256_madd_epi16(_mm256_unpackhi_epi16(rgb.r, rgb.g), coefficientRG),
+                                    _mm256_madd_epi16(_mm256_unpackhi_epi16(rgb.b, zero), coefficientB));
+    low = _mm256_srai_epi32(_mm256_add_epi32(low, bias), kShift);
+    high = _mm256_srai_epi32(_mm256_add_epi32(high, bias), kShift);
+    // unpack/pack 都在通道内进行，结果仍按像素顺序排列
+    return _mm256_packs_epi32(low, high);
+}
+
+TARGET_AVX2 int lumaRowAvx2(const RowContext& ctx, const std::uint8_t* src, std::uint8_t* dst) {
+    const Coefficients& c = *ctx.coefficients;
+    int x = 0;
+    for (; x + 16 <= ctx.width; x += 16) {
+        Rgb256 rgb = load16(*ctx.masks, src + x * ctx.bytesPerPixel, ctx.bytesPerPixel);
+        __m256i y = dot16(rgb, c.yr, c.yg, c.yb, c.yOffset);
+        // 每个通道的低 8 字节是结果，取 64 位块 0 和 2
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(y, y), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm256_castsi256_si128(packed));
+    }
+    return x;
+}
+
+TARGET_AVX2 int chromaRowAvx2(const RowContext& ctx, const std::uint8_t* src0, const std::uint8_t* src1,
+                              std::uint8_t* dstU, std::uint8_t* dstV, std::uint8_t* dstUV) {
+    const Coefficients& c = *ctx.coefficients;
+    const int bpp = ctx.bytesPerPixel;
+    const __m256i two = _mm256_set1_epi16(2);
+    // hadd 在通道内进行，色度样本按 0-3、8-11 | 4-7、12-15 排列，打包后按 32 位块重排
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 0, 0, 0, 0);
+    int cx = 0;
+    for (; cx * 2 + 32 <= ctx.width; cx += 16) {
+        int x = cx * 2;
+        Rgb256 a0 = load16(*ctx.masks, src0 + x * bpp, bpp);
+        Rgb256 b0 = load16(*ctx.masks, src0 + (x + 16) * bpp, bpp);
+        Rgb256 a1 = load16(*ctx.masks, src1 + x * bpp, bpp);
+        Rgb256 b1 = load16(*ctx.masks, src1 + (x + 16) * bpp, bpp);
+        Rgb256 average;
+        average.r = _mm256_srli_epi16(_mm256_add_epi16(_mm256_hadd_epi16(_mm256_add_epi16(a0.r, a1.r), _mm256_add_epi16(b0.r, b1.r)), two), 2);
+        average.g = _mm256_srli_epi16(_mm256_add_epi16(_mm256_hadd_epi16(_mm256_add_epi16(a0.g, a1.g), _mm256_add_epi16(b0.g, b1.g)), two), 2);
+        average.b = _mm256_srli_epi16(_mm256_add_epi16(_mm256_hadd_epi16(_mm256_add_epi16(a0.b, a1.b), _mm256_add_epi16(b0.b, b1.b)), two), 2);
+
+        __m256i u16 = dot16(average, c.ur, c.ug, c.ub, c.chromaOffset);
+        __m256i v16 = dot16(average, c.vr, c.vg, c.vb, c.chromaOffset);
+        __m128i u = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_packus_epi16(u16, u16), order));
+        __m128i v = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_packus_epi16(v16, v16), order));
+        if (dstUV) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dstUV + cx * 2), _mm_unpacklo_epi8(u, v));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dstUV + cx * 2 + 16), _mm_unpackhi_epi8(u, v));
+        } else {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dstU + cx), u);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dstV + cx), v);
+        }
+    }
+    return cx;
+}
+
+void cpuid(int leaf, int subleaf, unsigned int regs[4]) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int values[4];
+    __cpuidex(values, leaf, subleaf);
+    for (int i = 0; i < 4; i++) regs[i] = static_cast<unsigned int>(values[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// 操作系统是否保存 YMM 寄存器
+bool osSupportsAvx() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    return (_xgetbv(0) & 0x6) == 0x6;
+#else
+    unsigned int eax = 0, edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (eax & 0x6) == 0x6;
+#endif
+}
+
+#endif // COLORCONVERTER_X86
+
+} // namespace
+
+ColorConverter::Isa ColorConverter::detectIsa() {
+#if defined(COLORCONVERTER_X86)
+    static const Isa detected = []() {
+        unsigned int regs[4];
+        cpuid(0, 0, regs);
+        unsigned int maxLeaf = regs[0];
+        cpuid(1, 0, regs);
+        bool sse41 = (regs[2] & (1u << 19)) != 0;
+        bool ssse3 = (regs[2] & (1u << 9)) != 0;
+        bool osxsave = (regs[2] & (1u << 27)) != 0;
+        bool avx = (regs[2] & (1u << 28)) != 0;
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && avx && osSupportsAvx()) {
+            cpuid(7, 0, regs);
+            avx2 = (regs[1] & (1u << 5)) != 0;
+        }
+        if (avx2) return Isa::AVX2;
+        if (sse41 && ssse3) return Isa::SSE41;
+        return Isa::Scalar;
+    }();
+    return detected;
+#else
+    return Isa::Scalar;
+#endif
+}
+
+const char* ColorConverter::isaName(Isa isa) {
+    switch (isa) {
+    case Isa::AVX2: return "avx2";
+    case Isa::SSE41: return "sse4.1";
+    default: return "scalar";
+    }
+}
+
+void ColorConverter::setIsa(Isa isa) {
+    this->isa = static_cast<int>(isa) > static_cast<int>(detectIsa()) ? detectIsa() : isa;
+}
+
+ColorConverter::ColorConverter(int width, int height, PixelLayout layout, bool fullRange, int threads)
+    : width(width), height(height), isa(detectIsa()) {
+    bytesPerPixel = layout == PixelLayout::RGB24 ? 3 : 4;
+    channelOffset[0] = layout == PixelLayout::BGRA ? 2 : 0;
+    channelOffset[1] = 1;
+    channelOffset[2] = layout == PixelLayout::BGRA ? 0 : 2;
+    coefficients = makeCoefficients(fullRange);
+    masks = makeMasks(bytesPerPixel, channelOffset);
+
+    // 每个行带至少 16 行色度，小画面不值得分给多个线程
+    int chromaHeight = (height + 1) / 2;
+    bandCount = std::max(1, std::min(threads, chromaHeight / 16));
+    for (int band = 1; band < bandCount; band++) {
+        workers.emplace_back(&ColorConverter::workerLoop, this, band);
+    }
+}
+
+ColorConverter::~ColorConverter() {
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        stopping = true;
+    }
+    startCV.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ColorConverter::convert(const std::uint8_t* src, int srcStride, std::uint8_t* const dst[3], const int dstStride[3],
+                             ChromaLayout chroma, bool flip) {
+    jobSrc = src;
+    jobSrcStride = srcStride;
+    for (int i = 0; i < 3; i++) {
+        jobDst[i] = dst[i];
+        jobDstStride[i] = dstStride[i];
+    }
+    jobChroma = chroma;
+    jobFlip = flip;
+
+    int chromaHeight = (height + 1) / 2;
+    if (bandCount > 1) {
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            pendingBands = bandCount - 1;
+            generation++;
+        }
+        startCV.notify_all();
+    }
+
+    convertBand(0, chromaHeight / bandCount);
+
+    if (bandCount > 1) {
+        std::unique_lock<std::mutex> lock(poolMutex);
+        doneCV.wait(lock, [this]() { return pendingBands == 0; });
+    }
+}
+
+void ColorConverter::workerLoop(int band) {
+    std::uint64_t seen = 0;
+    int chromaHeight = (height + 1) / 2;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(poolMutex);
+            startCV.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+
+        convertBand(chromaHeight * band / bandCount, chromaHeight * (band + 1) / bandCount);
+
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            pendingBands--;
+        }
+        doneCV.notify_one();
+    }
+}
+
+void ColorConverter::convertBand(int firstChromaRow, int lastChromaRow) {
+    RowContext ctx{width, bytesPerPixel, channelOffset, &coefficients, &masks};
+    auto sourceRow = [&](int y) {
+        int row = jobFlip ? height - 1 - y : y;
+        return jobSrc + static_cast<std::ptrdiff_t>(row) * jobSrcStride;
+    };
+
+    for (int cy = firstChromaRow; cy < lastChromaRow; cy++) {
+        int y0 = cy * 2;
+        // 奇数高度时最后一个色度行只有一行像素
+        int y1 = std::min(y0 + 1, height - 1);
+        const std::uint8_t* src0 = sourceRow(y0);
+        const std::uint8_t* src1 = sourceRow(y1);
+
+        std::uint8_t* dstU = nullptr;
+        std::uint8_t* dstV = nullptr;
+        std::uint8_t* dstUV = nullptr;
+        if (jobChroma == ChromaLayout::NV12) {
+            dstUV = jobDst[1] + static_cast<std::ptrdiff_t>(cy) * jobDstStride[1];
+        } else {
+            dstU = jobDst[1] + static_cast<std::ptrdiff_t>(cy) * jobDstStride[1];
+            dstV = jobDst[2] + static_cast<std::ptrdiff_t>(cy) * jobDstStride[2];
+        }
+
+        int rows = y1 != y0 ? 2 : 1;
+        for (int i = 0; i < rows; i++) {
+            const std::uint8_t* src = i == 0 ? src0 : src1;
+            std::uint8_t* dst = jobDst[0] + static_cast<std::ptrdiff_t>(y0 + i) * jobDstStride[0];
+            int done = 0;
+#if defined(COLORCONVERTER_X86)
+            if (isa == Isa::AVX2) done = lumaRowAvx2(ctx, src, dst);
+            else if (isa == Isa::SSE41) done = lumaRowSse41(ctx, src, dst);
+#endif
+            lumaRowScalar(ctx, src, dst, done);
+        }
+
+        int done = 0;
+#if defined(COLORCONVERTER_X86)
+        if (isa == Isa::AVX2) done = chromaRowAvx2(ctx, src0, src1, dstU, dstV, dstUV);
+        else if (isa == Isa::SSE41) done = chromaRowSse41(ctx, src0, src1, dstU, dstV, dstUV);
+#endif
+        chromaRowScalar(ctx, src0, src1, dstU, dstV, dstUV, done);
+    }
+}
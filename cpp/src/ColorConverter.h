@@ -0,0 +1,91 @@
+// ColorConverter.h
+
+#ifndef COLORCONVERTER_H
+#define COLORCONVERTER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// GL 读回格式到 I420 / NV12 的 BT.709 颜色转换，同时完成垂直翻转
+// 逐行转换按 CPU 支持选择 AVX2、SSE4.1 或标量实现，三者结果逐字节一致；
+// 画面按行带分给内部的小线程池，调用线程也处理其中一个行带
+class ColorConverter {
+public:
+    // 源像素在内存中的排列
+    enum class PixelLayout { RGB24, RGBA, BGRA };
+    // I420：dst[1]、dst[2] 为 U、V 平面；NV12：dst[1] 为交错的 UV 平面
+    enum class ChromaLayout { I420, NV12 };
+    enum class Isa { Scalar, SSE41, AVX2 };
+
+    // threads 为参与转换的线程总数（包括调用线程），小于 1 时按 1 处理
+    ColorConverter(int width, int height, PixelLayout layout, bool fullRange, int threads);
+    ~ColorConverter();
+
+    ColorConverter(const ColorConverter&) = delete;
+    ColorConverter& operator=(const ColorConverter&) = delete;
+
+    // flip 为 true 时 src 的第 0 行是画面底部（glReadPixels 的顺序），输出的第 0 行是画面顶部
+    void convert(const std::uint8_t* src, int srcStride, std::uint8_t* const dst[3], const int dstStride[3],
+                 ChromaLayout chroma, bool flip = true);
+
+    // 当前 CPU 支持的最高指令集
+    static Isa detectIsa();
+    static const char* isaName(Isa isa);
+    // 指定实现（基准测试对比用），超过 CPU 支持的级别时取支持的最高级别
+    void setIsa(Isa isa);
+    Isa getIsa() const { return isa; }
+
+    // 15 位定点系数，偏移中已包含舍入
+    struct Coefficients {
+        std::int16_t yr, yg, yb;
+        std::int32_t yOffset;
+        std::int16_t ur, ug, ub;
+        std::int16_t vr, vg, vb;
+        std::int32_t chromaOffset;
+    };
+
+    // 按像素排列生成的 pshufb 掩码：8 个像素的 R/G/B 分量零扩展为 16 位，
+    // first 取前 16 字节中的分量，second 取之后的字节（RGB24 只读 8 字节）
+    struct ShuffleMasks {
+        alignas(16) std::uint8_t first[3][16];
+        alignas(16) std::uint8_t second[3][16];
+    };
+
+private:
+    // 转换 [firstChromaRow, lastChromaRow) 对应的行
+    void convertBand(int firstChromaRow, int lastChromaRow);
+    void workerLoop(int band);
+
+    int width;
+    int height;
+    int bytesPerPixel;
+    // R、G、B 在像素内的字节偏移
+    int channelOffset[3];
+    Coefficients coefficients;
+    ShuffleMasks masks;
+    Isa isa;
+
+    // 当前任务
+    const std::uint8_t* jobSrc = nullptr;
+    int jobSrcStride = 0;
+    std::uint8_t* jobDst[3] = {nullptr, nullptr, nullptr};
+    int jobDstStride[3] = {0, 0, 0};
+    ChromaLayout jobChroma = ChromaLayout::I420;
+    bool jobFlip = true;
+
+    // 线程池：每个工作线程固定处理一个行带，generation 变化表示有新任务
+    std::vector<std::thread> workers;
+    // 行带数 = 工作线程数 + 1，创建线程前确定
+    int bandCount = 1;
+    std::mutex poolMutex;
+    std::condition_variable startCV;
+    std::condition_variable doneCV;
+    std::uint64_t generation = 0;
+    int pendingBands = 0;
+    bool stopping = false;
+};
+
+#endif // COLORCONVERTER_H
@@ -227,6 +227,20 @@ RenderTargetInfo ExpressTool::findInputeRenderTargetInfo(const std::shared_ptr<M
 }
 
 std::unordered_map<std::string, UniformValue> ExpressTool::collectMaterialExpressValue(std::shared_ptr<RendererResource> rendererResource, std::string rendererName, std::shared_ptr<Material> rendererMaterial, const json& plugin, int pluginIndex, RenderTargetInfo defaultSequenceRenderTarget)
+{
+    std::unordered_map<std::string, UniformValue> controlValue;
+    const json& controlData = plugin["control"];
+
+    for (auto it = controlData.begin(); it != controlData.end(); ++it)
+    {
+        std::string key = "control_" + it.key();
+        controlValue[key] = convertJsonValueToUniformValue(it.value());
+    }
+
+    return collectMaterialExpressValue(rendererResource, rendererName, rendererMaterial, controlValue, pluginIndex, defaultSequenceRenderTarget);
+}
+
+std::unordered_map<std::string, UniformValue> ExpressTool::collectMaterialExpressValue(std::shared_ptr<RendererResource> rendererResource, std::string rendererName, std::shared_ptr<Material> rendererMaterial, const std::unordered_map<std::string, UniformValue>& controlValue, int pluginIndex, RenderTargetInfo defaultSequenceRenderTarget)
 {
     // ScopedProfiler profiler("ExpressTool::collectMaterialExpressValue " + rendererName);
 
@@ -302,13 +316,9 @@ std::unordered_map<std::string, UniformValue> ExpressTool::collectMaterialExpres
         uv.value = targetPass->renderTargetInfo.height;
         result["sourceHeight"] = uv;
     }
-        
-    const json& controlData = plugin["control"];
 
-    for (auto it = controlData.begin(); it != controlData.end(); ++it)
+    for (const auto& [key, uv] : controlValue)
     {
-        std::string key = "control_" + it.key();
-        UniformValue uv = convertJsonValueToUniformValue(it.value());
         result[key] = uv;
     }
 
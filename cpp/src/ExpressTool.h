@@ -70,6 +70,8 @@ public:
     /// 2. 对 plugin.control 内的数据进行转换，支持 int、float、数组（数组长度为 2 得到 Vec2f，长度为3/4 得到 Vec4f，
     ///    注意：三维数组会自动补齐 alpha 为 1.0）。
     static std::unordered_map<std::string, UniformValue> collectMaterialExpressValue(std::shared_ptr<RendererResource> rendererResource, std::string rendererName, std::shared_ptr<Material> rendererMaterial, const json& plugin, int pluginIndex, RenderTargetInfo defaultSequenceRenderTarget);
+    /// 同上，control 数据已经转换好（键为 "control_" + key），供逐帧关键帧求值使用，避免 JSON 往返。
+    static std::unordered_map<std::string, UniformValue> collectMaterialExpressValue(std::shared_ptr<RendererResource> rendererResource, std::string rendererName, std::shared_ptr<Material> rendererMaterial, const std::unordered_map<std::string, UniformValue>& controlValue, int pluginIndex, RenderTargetInfo defaultSequenceRenderTarget);
     
     /// 使用 ExprTk 根据给定的表达式字符串和变量表求值。
     ///
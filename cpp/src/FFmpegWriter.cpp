@@ -1,12 +1,40 @@
 // FFmpegWriter.cpp
 #include "FFmpegWriter.h"
 #include <iostream>
+#include <algorithm>
 #include <cstring>
 
 
+EncoderProfile EncoderProfile::fromJson(const nlohmann::json& profileJson) {
+    EncoderProfile profile;
+    if (!profileJson.is_object()) {
+        return profile;
+    }
+    profile.codec = profileJson.value("codec", profile.codec);
+    profile.preset = profileJson.value("preset", profile.preset);
+    profile.tune = profileJson.value("tune", profile.tune);
+    profile.crf = profileJson.value("crf", profile.crf);
+    profile.bitrateKbps = profileJson.value("bitrateKbps", profile.bitrateKbps);
+    profile.maxrateKbps = profileJson.value("maxrateKbps", profile.maxrateKbps);
+    profile.bufsizeKbps = profileJson.value("bufsizeKbps", profile.bufsizeKbps);
+    profile.gop = profileJson.value("gop", profile.gop);
+    profile.bFrames = profileJson.value("bFrames", profile.bFrames);
+    profile.threads = profileJson.value("threads", profile.threads);
+    profile.threadType = profileJson.value("threadType", profile.threadType);
+    profile.pixelFormat = profileJson.value("pixelFormat", profile.pixelFormat);
+    profile.audioBitrateKbps = profileJson.value("audioBitrateKbps", profile.audioBitrateKbps);
+    if (profileJson.contains("options") && profileJson["options"].is_object()) {
+        for (const auto& [key, value] : profileJson["options"].items()) {
+            // 数字、布尔值按 JSON 文本传给 AVOption 解析
+            profile.options[key] = value.is_string() ? value.get<std::string>() : value.dump();
+        }
+    }
+    return profile;
+}
+
 FFmpegWriter::FFmpegWriter(const std::string& filename, int width, int height, int fps, int mBitRate)
     : formatContext(nullptr), videoStream(nullptr), codecContext(nullptr),
-      swsContext(nullptr), frame(nullptr), packet(nullptr),
+      lastFrame(nullptr), packet(nullptr),
       frameIndex(0), width(width), height(height), fps(fps), mBitRate(mBitRate), isEncoding(false) 
 {
     // 构造函数不再调用 initialize
@@ -17,17 +45,29 @@ FFmpegWriter::~FFmpegWriter() {
 }
 
 bool FFmpegWriter::initialize(const std::string& filename) {
+    if (!openOutput(filename)) {
+        // 失败前可能已经分配了上下文、打开了输出文件，释放后同一个 writer 不再持有半初始化的状态
+        releaseResources();
+        return false;
+    }
+    return true;
+}
 
+bool FFmpegWriter::openOutput(const std::string& filename) {
     // 分配输出上下文
     if (avformat_alloc_output_context2(&formatContext, nullptr, nullptr, filename.c_str()) < 0) {
         std::cerr << "无法分配输出上下文" << std::endl;
         return false;
     }
 
-    // 查找H.264编码器
-    const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+    // 查找编码器：先按编码器名，再按编解码器名取默认编码器
+    const AVCodec* codec = avcodec_find_encoder_by_name(profile.codec.c_str());
+    if (!codec) {
+        const AVCodecDescriptor* descriptor = avcodec_descriptor_get_by_name(profile.codec.c_str());
+        codec = descriptor ? avcodec_find_encoder(descriptor->id) : nullptr;
+    }
     if (!codec) {
-        std::cerr << "找不到 H.264 编码器" << std::endl;
+        std::cerr << "找不到编码器: " << profile.codec << std::endl;
         return false;
     }
 
@@ -46,29 +86,55 @@ bool FFmpegWriter::initialize(const std::string& filename) {
         return false;
     }
 
+    // 输入格式：GPU 和 ColorConverter 都能直接输出 YUV420P 或 NV12
+    pixelFormat = profile.pixelFormat == "nv12" ? AV_PIX_FMT_NV12 : AV_PIX_FMT_YUV420P;
+    const AVPixelFormat* formats = nullptr;
+    int formatCount = 0;
+#if LIBAVCODEC_VERSION_INT >= AV_VERSION_INT(61, 13, 100)
+    const void* supportedFormats = nullptr;
+    if (avcodec_get_supported_config(nullptr, codec, AV_CODEC_CONFIG_PIX_FORMAT, 0, &supportedFormats, &formatCount) >= 0) {
+        formats = static_cast<const AVPixelFormat*>(supportedFormats);
+    }
+#else
+    // 旧版本只有以 AV_PIX_FMT_NONE 结尾的 codec->pix_fmts
+    formats = codec->pix_fmts;
+    while (formats && formats[formatCount] != AV_PIX_FMT_NONE) {
+        formatCount++;
+    }
+#endif
+    if (formats && std::find(formats, formats + formatCount, pixelFormat) == formats + formatCount) {
+        std::cerr << "编码器 " << codec->name << " 不支持 " << av_get_pix_fmt_name(pixelFormat) << std::endl;
+        return false;
+    }
+
     // 设置编码器参数
-    codecContext->codec_id = AV_CODEC_ID_H264;
-    codecContext->bit_rate = mBitRate*1000000;//码率kbpsM
+    codecContext->codec_id = codec->id;
     codecContext->width = width;
     codecContext->height = height;
     codecContext->time_base = AVRational{1, fps};
     codecContext->framerate = AVRational{fps, 1};
-    codecContext->gop_size = 10;
-    codecContext->max_b_frames = 0; // 禁用B帧
-    codecContext->pix_fmt = AV_PIX_FMT_YUV420P;
+    codecContext->pix_fmt = pixelFormat;
+    codecContext->color_range = fullRange ? AVCOL_RANGE_JPEG : AVCOL_RANGE_MPEG;
+    codecContext->colorspace = AVCOL_SPC_BT709;
+    codecContext->color_primaries = AVCOL_PRI_BT709;
+    codecContext->color_trc = AVCOL_TRC_BT709;
 
-    // 设置H.264预设
-    if (codecContext->codec_id == AV_CODEC_ID_H264) {
-        av_opt_set(codecContext->priv_data, "preset", "ultrafast", 0); // 使用ultrafast预设
-    }
+    AVDictionary* codecOptions = nullptr;
+    applyProfile(codec, &codecOptions);
 
     // 设置全局头
     if (formatContext->oformat->flags & AVFMT_GLOBALHEADER) {
         codecContext->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
     }
 
-    // 打开编码器
-    if (avcodec_open2(codecContext, codec, nullptr) < 0) {
+    // 打开编码器，剩下的是编码器不认识的选项
+    int openResult = avcodec_open2(codecContext, codec, &codecOptions);
+    const AVDictionaryEntry* unusedOption = nullptr;
+    while ((unusedOption = av_dict_get(codecOptions, "", unusedOption, AV_DICT_IGNORE_SUFFIX))) {
+        std::cerr << "编码器 " << codec->name << " 不支持选项 " << unusedOption->key << "，已忽略" << std::endl;
+    }
+    av_dict_free(&codecOptions);
+    if (openResult < 0) {
         std::cerr << "无法打开编解码器" << std::endl;
         return false;
     }
@@ -79,11 +145,20 @@ bool FFmpegWriter::initialize(const std::string& filename) {
         return false;
     }
 
+    // MP4/MOV 中的 HEVC 使用 hvc1 标记，否则部分播放器（QuickTime、Safari）无法播放
+    if (codec->id == AV_CODEC_ID_HEVC && avformat_query_codec(formatContext->oformat, AV_CODEC_ID_HEVC, MKTAG('h', 'v', 'c', '1')) == 1) {
+        videoStream->codecpar->codec_tag = MKTAG('h', 'v', 'c', '1');
+    }
+
     // 设置流的时间基
     videoStream->time_base = codecContext->time_base;
     videoStream->avg_frame_rate = codecContext->framerate;
     videoStream->r_frame_rate = codecContext->framerate;
 
+    if (audioMixer && !initializeAudio()) {
+        return false;
+    }
+
     // 打印格式信息
     av_dump_format(formatContext, 0, filename.c_str(), 1);
 
@@ -101,37 +176,25 @@ bool FFmpegWriter::initialize(const std::string& filename) {
         return false;
     }
 
-    // 初始化swsContext
-    swsContext = sws_getContext(
-        width,
-        height,
-        AV_PIX_FMT_RGB24,
-        width,
-        height,
-        AV_PIX_FMT_YUV420P,
-        SWS_FAST_BILINEAR,
-        nullptr,
-        nullptr,
-        nullptr
-    );
-
-    if (!swsContext) {
-        std::cerr << "无法初始化 swsContext" << std::endl;
-        return false;
-    }
+    // RGB24 -> YUV420P / NV12 转换（BT.709、所选范围，同时垂直翻转），按行带分给几个线程
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    int converterThreads = static_cast<int>(std::max(1u, std::min(4u, hardwareThreads / 2)));
+    colorConverter = std::make_unique<ColorConverter>(width, height, ColorConverter::PixelLayout::RGB24, fullRange, converterThreads);
+    std::clog << "RGB 转 YUV: " << ColorConverter::isaName(colorConverter->getIsa()) << ", " << converterThreads << " 线程" << std::endl;
 
-    // 分配帧
-    frame = av_frame_alloc();
-    if (!frame) {
+    // 上一次送入编码器的帧，重复帧时复用它的缓冲区
+    lastFrame = av_frame_alloc();
+    if (!lastFrame) {
         std::cerr << "无法分配 AVFrame" << std::endl;
         return false;
     }
-    frame->format = codecContext->pix_fmt;
-    frame->width  = codecContext->width;
-    frame->height = codecContext->height;
 
-    if (av_frame_get_buffer(frame, 32) < 0) {
-        std::cerr << "无法分配帧缓冲区" << std::endl;
+    // 固定大小的缓冲池：帧缓冲区在所有引用释放后回到池中复用，队列有上限，池中的缓冲区数也有上限
+    int yuvFrameSize = av_image_get_buffer_size(pixelFormat, width, height, kFrameAlign);
+    yuvPool = av_buffer_pool_init(yuvFrameSize, av_buffer_alloc);
+    rgbPool = av_buffer_pool_init(width * height * 3, av_buffer_alloc);
+    if (yuvFrameSize < 0 || !yuvPool || !rgbPool) {
+        std::cerr << "无法分配帧缓冲池" << std::endl;
         return false;
     }
 
@@ -145,66 +208,128 @@ bool FFmpegWriter::initialize(const std::string& filename) {
     return true;
 }
 
+void FFmpegWriter::applyProfile(const AVCodec* codec, AVDictionary** codecOptions) {
+    // 码率控制：恒定质量或平均码率，两者都可以再用 VBV 限制峰值
+    if (profile.crf >= 0) {
+        av_dict_set_int(codecOptions, "crf", profile.crf, 0);
+        codecContext->bit_rate = 0;
+    } else if (profile.bitrateKbps > 0) {
+        codecContext->bit_rate = static_cast<int64_t>(profile.bitrateKbps) * 1000;
+    } else {
+        codecContext->bit_rate = static_cast<int64_t>(mBitRate) * 1000000; // mBitRate 以 Mbps 为单位
+    }
+    if (profile.maxrateKbps > 0) {
+        codecContext->rc_max_rate = static_cast<int64_t>(profile.maxrateKbps) * 1000;
+    }
+    if (profile.bufsizeKbps > 0) {
+        codecContext->rc_buffer_size = profile.bufsizeKbps * 1000;
+    }
+
+    // 默认两秒一个关键帧
+    codecContext->gop_size = profile.gop > 0 ? profile.gop : 2 * fps;
+    codecContext->max_b_frames = std::max(0, profile.bFrames);
+
+    // 编码器内部线程，和本类的编码线程无关
+    codecContext->thread_count = std::max(0, profile.threads);
+    if (profile.threadType == "frame") {
+        codecContext->thread_type = FF_THREAD_FRAME;
+    } else if (profile.threadType == "slice") {
+        codecContext->thread_type = FF_THREAD_SLICE;
+    }
+
+    if (!profile.preset.empty()) {
+        av_dict_set(codecOptions, "preset", profile.preset.c_str(), 0);
+    }
+    if (!profile.tune.empty()) {
+        av_dict_set(codecOptions, "tune", profile.tune.c_str(), 0);
+    }
+    for (const auto& [key, value] : profile.options) {
+        av_dict_set(codecOptions, key.c_str(), value.c_str(), 0);
+    }
+
+    std::clog << "编码器: " << codec->name << ", preset " << (profile.preset.empty() ? "-" : profile.preset)
+              << ", " << (profile.crf >= 0 ? "crf " + std::to_string(profile.crf) : std::to_string(codecContext->bit_rate / 1000) + " kbps")
+              << ", gop " << codecContext->gop_size << ", B 帧 " << codecContext->max_b_frames
+              << ", 线程 " << (codecContext->thread_count > 0 ? std::to_string(codecContext->thread_count) : "auto") << std::endl;
+}
+
+AVFrame* FFmpegWriter::allocYuvFrame() {
+    AVBufferRef* buffer = av_buffer_pool_get(yuvPool);
+    if (!buffer) {
+        return nullptr;
+    }
+    AVFrame* yuvFrame = av_frame_alloc();
+    if (!yuvFrame) {
+        av_buffer_unref(&buffer);
+        return nullptr;
+    }
+    yuvFrame->format = pixelFormat;
+    yuvFrame->width = width;
+    yuvFrame->height = height;
+    // 三个平面连续存放在同一块缓冲区中，buf[0] 持有整块缓冲区的引用
+    yuvFrame->buf[0] = buffer;
+    av_image_fill_arrays(yuvFrame->data, yuvFrame->linesize, buffer->data, pixelFormat, width, height, kFrameAlign);
+    return yuvFrame;
+}
+
 bool FFmpegWriter::encodeFrame(const uint8_t* rgbData) {
-    if (rgbData) {
-        // frame->pts = frameIndex++;
-        // std::cerr << "Encoding frame " << frameIndex << " with PTS " << frame->pts << std::endl;
-
-        // // RGB到YUV的颜色空间转换
-        // uint8_t* srcSlices[1] = { const_cast<uint8_t*>(rgbData) };
-        // int srcStrides[1] = { 3 * width };
-        // sws_scale(
-        //     swsContext,
-        //     srcSlices,
-        //     srcStrides,
-        //     0,
-        //     height,
-        //     frame->data,
-        //     frame->linesize
-        // );
-
-        frame->pts = frameIndex++;
-        // std::cerr << "Encoding frame " << frameIndex << " with PTS " << frame->pts << std::endl;
-
-        // RGB到YUV的颜色空间转换
-        int srcStride = 3 * width;
-        uint8_t* srcSlices[1];
-        int srcStrides[1];
-
-        // 设置负的步幅，实现垂直翻转
-        srcStrides[0] = -srcStride;
-        // 指向最后一行的起始地址
-        srcSlices[0] = const_cast<uint8_t*>(rgbData) + srcStride * (height - 1);
-
-        sws_scale(
-            swsContext,
-            srcSlices,
-            srcStrides,
-            0,
-            height,
-            frame->data,
-            frame->linesize
-        );
+    AVFrame* yuvFrame = allocYuvFrame();
+    if (!yuvFrame) {
+        std::cerr << "无法分配帧缓冲区" << std::endl;
+        return false;
+    }
 
+    // RGB到YUV的颜色空间转换，读回的第 0 行是画面底部，转换时垂直翻转
+    ColorConverter::ChromaLayout chroma = pixelFormat == AV_PIX_FMT_NV12 ? ColorConverter::ChromaLayout::NV12 : ColorConverter::ChromaLayout::I420;
+    colorConverter->convert(rgbData, 3 * width, yuvFrame->data, yuvFrame->linesize, chroma);
+
+    bool sent = sendFrame(yuvFrame);
+    av_frame_free(&yuvFrame);
+    return sent;
+}
+
+bool FFmpegWriter::encodeRepeatFrame() {
+    if (!lastFrame->buf[0]) {
+        std::cerr << "没有可重复的上一帧" << std::endl;
+        return false;
+    }
+    // 新的引用指向同一块缓冲区，只有时间戳不同
+    AVFrame* repeatFrame = av_frame_clone(lastFrame);
+    if (!repeatFrame) {
+        std::cerr << "无法引用上一帧" << std::endl;
+        return false;
+    }
+    bool sent = sendFrame(repeatFrame);
+    av_frame_free(&repeatFrame);
+    return sent;
+}
+
+bool FFmpegWriter::sendFrame(AVFrame* sourceFrame) {
+    if (sourceFrame) {
+        sourceFrame->pts = frameIndex++;
+        av_frame_unref(lastFrame);
+        av_frame_ref(lastFrame, sourceFrame);
     } else {
         // 发送NULL帧以刷新编码器
         std::cerr << "Flushing encoder" << std::endl;
     }
 
     // 发送帧到编码器
-    if (avcodec_send_frame(codecContext, rgbData ? frame : nullptr) < 0) {
+    if (avcodec_send_frame(codecContext, sourceFrame) < 0) {
         std::cerr << "无法发送帧到编码器" << std::endl;
         return false;
     }
 
+    return writePackets(codecContext, videoStream);
+}
+
+bool FFmpegWriter::writePackets(AVCodecContext* context, AVStream* stream) {
     // 接收编码器输出的包
-    while (avcodec_receive_packet(codecContext, packet) == 0) {
+    while (avcodec_receive_packet(context, packet) == 0) {
         // 设置包的流索引
-        packet->stream_index = videoStream->index;
+        packet->stream_index = stream->index;
         // 缩放包的时间戳到流的时间基
-        av_packet_rescale_ts(packet, codecContext->time_base, videoStream->time_base);
-
-        // std::cerr << "Writing packet with PTS " << packet->pts << std::endl;
+        av_packet_rescale_ts(packet, context->time_base, stream->time_base);
 
         // 使用交叉写入包
         if (av_interleaved_write_frame(formatContext, packet) < 0) {
@@ -218,23 +343,146 @@ bool FFmpegWriter::encodeFrame(const uint8_t* rgbData) {
     return true;
 }
 
-bool FFmpegWriter::pushFrame(uint8_t* rgbData, int width, int height) {
+bool FFmpegWriter::initializeAudio() {
+    const AVCodec* audioCodec = avcodec_find_encoder(AV_CODEC_ID_AAC);
+    if (!audioCodec) {
+        std::cerr << "找不到 AAC 编码器" << std::endl;
+        return false;
+    }
+    audioStream = avformat_new_stream(formatContext, audioCodec);
+    audioContext = avcodec_alloc_context3(audioCodec);
+    if (!audioStream || !audioContext) {
+        std::cerr << "无法创建音频流" << std::endl;
+        return false;
+    }
+    audioStream->id = formatContext->nb_streams - 1;
+
+    // 混音输出平面 float，正是 AAC 编码器的输入格式，不需要再转换
+    audioContext->sample_fmt = AV_SAMPLE_FMT_FLTP;
+    audioContext->sample_rate = audioMixer->getSampleRate();
+    av_channel_layout_default(&audioContext->ch_layout, audioMixer->getChannels());
+    audioContext->bit_rate = static_cast<int64_t>(profile.audioBitrateKbps) * 1000;
+    audioContext->time_base = AVRational{1, audioContext->sample_rate};
+    if (formatContext->oformat->flags & AVFMT_GLOBALHEADER) {
+        audioContext->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+    }
+    if (avcodec_open2(audioContext, audioCodec, nullptr) < 0 ||
+        avcodec_parameters_from_context(audioStream->codecpar, audioContext) < 0) {
+        std::cerr << "无法打开音频编码器" << std::endl;
+        return false;
+    }
+    audioStream->time_base = audioContext->time_base;
+
+    audioFrame = av_frame_alloc();
+    if (!audioFrame) {
+        std::cerr << "无法分配音频帧" << std::endl;
+        return false;
+    }
+    audioFrame->format = audioContext->sample_fmt;
+    audioFrame->sample_rate = audioContext->sample_rate;
+    audioFrame->nb_samples = audioContext->frame_size > 0 ? audioContext->frame_size : 1024;
+    av_channel_layout_copy(&audioFrame->ch_layout, &audioContext->ch_layout);
+    if (av_frame_get_buffer(audioFrame, 0) < 0) {
+        std::cerr << "无法分配音频帧" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool FFmpegWriter::encodeAudioUntil(int64_t videoFrames) {
+    int64_t targetSamples = av_rescale(videoFrames, audioContext->sample_rate, fps);
+    while (audioSamples < targetSamples) {
+        // 编码器可能还引用着上一次的缓冲区
+        if (av_frame_make_writable(audioFrame) < 0) {
+            std::cerr << "无法写入音频帧" << std::endl;
+            return false;
+        }
+        audioMixer->mix(reinterpret_cast<float* const*>(audioFrame->data), audioFrame->nb_samples);
+        audioFrame->pts = audioSamples;
+        audioSamples += audioFrame->nb_samples;
+        if (avcodec_send_frame(audioContext, audioFrame) < 0) {
+            std::cerr << "无法发送音频帧到编码器" << std::endl;
+            return false;
+        }
+        if (!writePackets(audioContext, audioStream)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FFmpegWriter::pushFrame(const uint8_t* rgbData, int width, int height) {
     FrameData frameData;
-    frameData.width = width;
-    frameData.height = height;
-    frameData.data.assign(rgbData, rgbData + (width * height * 3)); // 拷贝RGB数据
+    frameData.rgb = av_buffer_pool_get(rgbPool);
+    if (!frameData.rgb) {
+        std::cerr << "无法分配帧缓冲区" << std::endl;
+        return false;
+    }
+    std::memcpy(frameData.rgb->data, rgbData, static_cast<size_t>(width) * height * 3); // 拷贝RGB数据
+    return enqueue(frameData);
+}
 
+bool FFmpegWriter::pushYuvFrame(const uint8_t* yuvData, int width, int height) {
+    FrameData frameData;
+    frameData.frame = allocYuvFrame();
+    if (!frameData.frame) {
+        std::cerr << "无法分配帧缓冲区" << std::endl;
+        return false;
+    }
+    // 读回的平面紧密排列，池中帧的行按 kFrameAlign 对齐
+    int chromaWidth = (width + 1) / 2;
+    int chromaHeight = (height + 1) / 2;
+    const uint8_t* u = yuvData + width * height;
+    const uint8_t* v = u + chromaWidth * chromaHeight;
+    AVFrame* yuvFrame = frameData.frame;
+    av_image_copy_plane(yuvFrame->data[0], yuvFrame->linesize[0], yuvData, width, width, height);
+    if (pixelFormat == AV_PIX_FMT_NV12) {
+        for (int y = 0; y < chromaHeight; y++) {
+            uint8_t* uv = yuvFrame->data[1] + y * yuvFrame->linesize[1];
+            const uint8_t* uRow = u + y * chromaWidth;
+            const uint8_t* vRow = v + y * chromaWidth;
+            for (int x = 0; x < chromaWidth; x++) {
+                uv[2 * x] = uRow[x];
+                uv[2 * x + 1] = vRow[x];
+            }
+        }
+    } else {
+        av_image_copy_plane(yuvFrame->data[1], yuvFrame->linesize[1], u, chromaWidth, chromaWidth, chromaHeight);
+        av_image_copy_plane(yuvFrame->data[2], yuvFrame->linesize[2], v, chromaWidth, chromaWidth, chromaHeight);
+    }
+    return enqueue(frameData);
+}
+
+bool FFmpegWriter::pushRepeatFrame() {
+    FrameData frameData;
+    frameData.repeat = true;
+    return enqueue(frameData);
+}
+
+bool FFmpegWriter::enqueue(FrameData& frameData) {
     {
-        std::lock_guard<std::mutex> lock(queueMutex);
-        if (frameQueue.size() >= 1000) { // 限制队列大小，避免内存占用过高
+        std::unique_lock<std::mutex> lock(queueMutex);
+        // 队列已满时阻塞渲染线程，等编码线程取走一帧，不丢帧
+        if (frameQueue.size() >= maxQueuedFrames) {
+            blockedCount++;
+            spaceCV.wait(lock, [this]() { return frameQueue.size() < maxQueuedFrames || !isEncoding; });
+        }
+        if (!isEncoding) {
+            lock.unlock();
+            releaseFrameData(frameData);
             return false;
         }
-        frameQueue.push(std::move(frameData)); // 使用std::move提高效率
+        frameQueue.push(frameData);
     }
     queueCV.notify_one();
     return true;
 }
 
+void FFmpegWriter::releaseFrameData(FrameData& frameData) {
+    av_frame_free(&frameData.frame);
+    av_buffer_unref(&frameData.rgb);
+}
+
 void FFmpegWriter::startEncoding() {
     if (isEncoding) return;
     isEncoding = true;
@@ -248,6 +496,7 @@ void FFmpegWriter::stopEncoding() {
         isEncoding = false;
     }
     queueCV.notify_all();
+    spaceCV.notify_all();
     if (encodingThread.joinable())
         encodingThread.join();
 }
@@ -258,38 +507,66 @@ void FFmpegWriter::encodingLoop() {
         queueCV.wait(lock, [this]() { return !frameQueue.empty() || !isEncoding; });
 
         while (!frameQueue.empty()) {
-            FrameData frameData = std::move(frameQueue.front());
+            FrameData frameData = frameQueue.front();
             frameQueue.pop();
             lock.unlock();
-
-            if (!encodeFrame(frameData.data.data())) { // 传递拷贝后的数据
+            spaceCV.notify_one();
+
+            bool encoded;
+            if (frameData.repeat) {
+                encoded = encodeRepeatFrame();
+            } else if (frameData.frame) {
+                encoded = sendFrame(frameData.frame);
+            } else {
+                encoded = encodeFrame(frameData.rgb->data);
+            }
+            if (!encoded) {
                 std::cerr << "编码帧失败" << std::endl;
             }
+            // 音频跟着视频推进，两路包由 av_interleaved_write_frame 交错写入
+            if (audioMixer && !encodeAudioUntil(frameIndex)) {
+                std::cerr << "编码音频失败" << std::endl;
+            }
+            // 缓冲区回到池中（编码器仍持有引用时，等它释放后再回到池中）
+            releaseFrameData(frameData);
 
             lock.lock();
         }
     }
 
     // 刷新编码器
-    encodeFrame(nullptr);
+    sendFrame(nullptr);
+    if (audioMixer) {
+        encodeAudioUntil(frameIndex);
+        avcodec_send_frame(audioContext, nullptr);
+        writePackets(audioContext, audioStream);
+    }
 }
 
 void FFmpegWriter::finalize() {
     stopEncoding(); // 确保编码线程已停止并处理完所有帧
 
+    if (blockedCount > 0) {
+        std::clog << "编码队列已满，渲染线程等待 " << blockedCount << " 次" << std::endl;
+    }
+
     // 写入尾部
     if (av_write_trailer(formatContext) < 0) {
         std::cerr << "无法写入文件尾部" << std::endl;
     }
 
+    releaseResources();
+}
+
+void FFmpegWriter::releaseResources() {
     // 关闭输出文件
-    if (!(formatContext->oformat->flags & AVFMT_NOFILE)) {
+    if (formatContext && !(formatContext->oformat->flags & AVFMT_NOFILE)) {
         avio_closep(&formatContext->pb);
     }
 
     // 释放资源
-    if (frame) {
-        av_frame_free(&frame);
+    if (lastFrame) {
+        av_frame_free(&lastFrame);
     }
     if (packet) {
         av_packet_free(&packet);
@@ -297,10 +574,26 @@ void FFmpegWriter::finalize() {
     if (codecContext) {
         avcodec_free_context(&codecContext);
     }
+    if (audioContext) {
+        avcodec_free_context(&audioContext);
+    }
+    if (audioFrame) {
+        av_frame_free(&audioFrame);
+    }
+    audioMixer.reset();
+    // 池在最后一个缓冲区释放后才真正销毁
+    if (yuvPool) {
+        av_buffer_pool_uninit(&yuvPool);
+    }
+    if (rgbPool) {
+        av_buffer_pool_uninit(&rgbPool);
+    }
+    // 流归 formatContext 所有
     if (formatContext) {
         avformat_free_context(formatContext);
+        formatContext = nullptr;
     }
-    if (swsContext) {
-        sws_freeContext(swsContext);
-    }
-}
\ No newline at end of file
+    videoStream = nullptr;
+    audioStream = nullptr;
+    colorConverter.reset();
+}
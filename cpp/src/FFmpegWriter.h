@@ -9,49 +9,131 @@
 #include <queue>
 #include <memory>
 #include <string>
-
-// 定义FrameData结构体
-struct FrameData {
-    std::vector<uint8_t> data;
-    int width;
-    int height;
-};
+#include <map>
+#include "AudioMixer.h"
+#include "ColorConverter.h"
+#include "../nlohmann/json.hpp"
 
 extern "C" {
     #include <libavcodec/avcodec.h>
-    #include <libswscale/swscale.h>
     #include <libavutil/opt.h>
+    #include <libavutil/imgutils.h>
     #include <libavformat/avformat.h>
 }
 
+// 编码队列中的一帧，缓冲区都来自 FFmpegWriter 的缓冲池，三者只有一个有效
+struct FrameData {
+    // GPU 转换好的 YUV 帧（编码器输入格式），可以直接送入编码器
+    AVFrame* frame = nullptr;
+    // 左下角原点的 RGB24，由编码线程转换
+    AVBufferRef* rgb = nullptr;
+    // 与上一帧画面相同，重新引用上一帧的缓冲区
+    bool repeat = false;
+};
+
+// 编码配置，对应任务 JSON 中的 "encoder" 对象，未给出的字段使用默认值
+struct EncoderProfile {
+    // libavcodec 中的编码器名（libx264、libx265、mpeg4、h264_nvenc……），也可以是编解码器名（h264、hevc）
+    std::string codec = "libx264";
+    // preset、tune 通过私有选项传给编码器，编码器不支持时忽略并给出警告
+    std::string preset = "ultrafast";
+    std::string tune;
+    // crf >= 0 时使用恒定质量，否则按码率编码；bitrateKbps 为 0 时使用任务的 mBitRate
+    int crf = -1;
+    int bitrateKbps = 0;
+    // VBV：峰值码率和缓冲区大小，0 表示不限制
+    int maxrateKbps = 0;
+    int bufsizeKbps = 0;
+    // 关键帧间隔（帧），0 表示两秒
+    int gop = 0;
+    int bFrames = 0;
+    // 编码器线程数，0 表示由编码器决定；threadType 为 "frame"、"slice" 或空（两者都允许）
+    int threads = 0;
+    std::string threadType;
+    // "yuv420p" 或 "nv12"
+    std::string pixelFormat = "yuv420p";
+    // 有音频时 AAC 的码率
+    int audioBitrateKbps = 192;
+    // 其余私有选项原样传给 avcodec_open2，例如 {"x264-params": "aq-mode=3"}
+    std::map<std::string, std::string> options;
+
+    static EncoderProfile fromJson(const nlohmann::json& profileJson);
+};
+
 class FFmpegWriter {
 public:
     FFmpegWriter(const std::string& filename, int width, int height, int fps, int kbps);
     ~FFmpegWriter();
     
+    // 输出 BT.709，fullRange 选择完整范围或有限范围；需在 initialize 之前调用
+    void setColorRange(bool fullRange) { this->fullRange = fullRange; }
+    // 编码器、码率控制、GOP、线程等配置；需在 initialize 之前调用
+    void setEncoderProfile(const EncoderProfile& profile) { this->profile = profile; }
+    // 设置后输出中增加 AAC 音轨，编码线程每编码一帧视频就从 mixer 取出等长的音频；需在 initialize 之前调用
+    void setAudioMixer(std::unique_ptr<AudioMixer> mixer) { audioMixer = std::move(mixer); }
+    // 失败时释放已经分配的上下文并关闭输出文件
     bool initialize(const std::string& filename);
-    bool pushFrame(uint8_t* rgbData, int width, int height);
+    // 队列中最多缓存的帧数，队列满时 push* 阻塞直到编码线程取走一帧；需在 startEncoding 之前调用
+    void setMaxQueuedFrames(size_t count) { maxQueuedFrames = count < 1 ? 1 : count; }
+    // push* 只在编码已停止或分配缓冲区失败时返回 false
+    bool pushFrame(const uint8_t* rgbData, int width, int height);
+    // yuvData 为 GPU 转换好的 YUV420P 平面（Y | U | V 紧密排列，已翻转），拷贝进池中的帧后直接送入编码器；
+    // 编码器输入为 NV12 时拷贝时交错 U、V
+    bool pushYuvFrame(const uint8_t* yuvData, int width, int height);
+    // 画面与上一帧相同时使用，不拷贝像素也不做颜色转换
+    bool pushRepeatFrame();
     void startEncoding();
     void stopEncoding();
     void finalize();
 
 private:
+    bool openOutput(const std::string& filename);
+    // 释放编码器、输出上下文和缓冲池，finalize 和 initialize 失败时共用
+    void releaseResources();
     void encodingLoop();
     bool encodeFrame(const uint8_t* rgbData);
+    bool encodeRepeatFrame();
+    // 设置时间戳并送入编码器，同时记为上一帧；nullptr 刷新编码器
+    bool sendFrame(AVFrame* sourceFrame);
+    // 取出编码器输出的所有包写入 stream
+    bool writePackets(AVCodecContext* context, AVStream* stream);
+    bool initializeAudio();
+    // 混音并编码，直到音频时长追上 videoFrames 帧视频
+    bool encodeAudioUntil(int64_t videoFrames);
+    // 按配置设置码率控制、GOP、线程和私有选项，未被编码器使用的选项在 avcodec_open2 之后给出警告
+    void applyProfile(const AVCodec* codec, AVDictionary** codecOptions);
+    // 从缓冲池取一帧 pixelFormat 格式的帧，行按 kFrameAlign 对齐
+    AVFrame* allocYuvFrame();
+    bool enqueue(FrameData& frameData);
+    static void releaseFrameData(FrameData& frameData);
+
+    static constexpr int kFrameAlign = 32;
 
     // FFmpeg相关成员
     AVFormatContext* formatContext;
     AVStream* videoStream;
     AVCodecContext* codecContext;
-    SwsContext* swsContext;
-    AVFrame* frame;
+    std::unique_ptr<ColorConverter> colorConverter;
+    AVFrame* lastFrame;
     AVPacket* packet;
+    AVBufferPool* yuvPool = nullptr;
+    AVBufferPool* rgbPool = nullptr;
+
+    // 音频（可选）
+    std::unique_ptr<AudioMixer> audioMixer;
+    AVStream* audioStream = nullptr;
+    AVCodecContext* audioContext = nullptr;
+    AVFrame* audioFrame = nullptr;
+    int64_t audioSamples = 0;
 
     // 多线程编码
     std::thread encodingThread;
     std::mutex queueMutex;
     std::condition_variable queueCV;
+    std::condition_variable spaceCV;
     std::queue<FrameData> frameQueue;
+    size_t maxQueuedFrames = 8;
+    int blockedCount = 0;
     bool isEncoding;
 
     // 索引和缓冲区
@@ -60,6 +142,10 @@ private:
     int height;
     int fps;
     int mBitRate;
+    bool fullRange = false;
+    EncoderProfile profile;
+    // 编码器输入格式，YUV420P 或 NV12
+    AVPixelFormat pixelFormat = AV_PIX_FMT_YUV420P;
 };
 
 #endif // 
\ No newline at end of file
@@ -0,0 +1,239 @@
+// GLContext.cpp
+
+#include "GLContext.h"
+#include <iostream>
+#include <vector>
+
+#ifdef ENGINE_HAS_EGL
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+#ifndef EGL_PLATFORM_DEVICE_EXT
+#define EGL_PLATFORM_DEVICE_EXT 0x313F
+#endif
+#endif
+
+// ---------------- GLFW 窗口 ----------------
+
+class GlfwContext : public GLContext {
+public:
+    ~GlfwContext() override { terminate(); }
+
+    bool initialize(int width, int height, bool isVisible) {
+        if (!glfwInit()) {
+            std::cerr << "无法初始化 GLFW" << std::endl;
+            return false;
+        }
+        initialized = true;
+
+        if (!isVisible)
+        {
+            glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        }
+        window = glfwCreateWindow(width, height, "Video Rendering", NULL, NULL);
+        if (!window) {
+            std::cerr << "无法创建窗口" << std::endl;
+            terminate();
+            return false;
+        }
+
+        glfwMakeContextCurrent(window);
+
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cerr << "无法加载 OpenGL 函数" << std::endl;
+            terminate();
+            return false;
+        }
+        return true;
+    }
+
+    const char* getName() const override { return "GLFW window"; }
+    void* getProcAddress(const char* name) const override { return (void*)glfwGetProcAddress(name); }
+    GLFWwindow* getWindow() const override { return window; }
+
+    void terminate() override {
+        if (initialized) {
+            glfwTerminate();
+            initialized = false;
+            window = nullptr;
+        }
+    }
+
+private:
+    GLFWwindow* window = nullptr;
+    bool initialized = false;
+};
+
+// ---------------- EGL 离屏 ----------------
+
+#ifdef ENGINE_HAS_EGL
+class EglContext : public GLContext {
+public:
+    ~EglContext() override { terminate(); }
+
+    bool initialize() {
+        if (!openDisplay()) {
+            std::cerr << "无法打开 EGL display" << std::endl;
+            return false;
+        }
+
+        const EGLint configAttributes[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_STENCIL_SIZE, 8,
+            EGL_NONE
+        };
+        EGLConfig config = nullptr;
+        EGLint configCount = 0;
+        if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || configCount == 0) {
+            std::cerr << "没有可用的 EGL config" << std::endl;
+            terminate();
+            return false;
+        }
+
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+            std::cerr << "EGL 不支持桌面 OpenGL" << std::endl;
+            terminate();
+            return false;
+        }
+
+        // 渲染器没有使用 VAO，需要兼容模式上下文；驱动不接受版本要求时退回默认上下文
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 3,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+            EGL_NONE
+        };
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttributes);
+        if (context == EGL_NO_CONTEXT) {
+            context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+        }
+        if (context == EGL_NO_CONTEXT) {
+            std::cerr << "无法创建 EGL 上下文: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+            terminate();
+            return false;
+        }
+
+        // 所有渲染都在离屏 FBO 中完成，默认帧缓冲不会被使用：
+        // 支持 surfaceless 时不创建任何 surface，否则退回 1x1 的 pbuffer
+        std::string extensions = eglQueryString(display, EGL_EXTENSIONS);
+        bool made = false;
+        if (extensions.find("EGL_KHR_surfaceless_context") != std::string::npos) {
+            made = eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context);
+        }
+        if (!made) {
+            const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+            surface = eglCreatePbufferSurface(display, config, pbufferAttributes);
+            if (surface == EGL_NO_SURFACE || !eglMakeCurrent(display, surface, surface, context)) {
+                std::cerr << "无法激活 EGL 上下文: 0x" << std::hex << eglGetError() << std::dec << std::endl;
+                terminate();
+                return false;
+            }
+        }
+
+        if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+            std::cerr << "无法加载 OpenGL 函数" << std::endl;
+            terminate();
+            return false;
+        }
+        return true;
+    }
+
+    const char* getName() const override { return surface == EGL_NO_SURFACE ? "EGL surfaceless" : "EGL pbuffer"; }
+    void* getProcAddress(const char* name) const override { return (void*)eglGetProcAddress(name); }
+
+    void terminate() override {
+        if (display == EGL_NO_DISPLAY) return;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+        if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        eglTerminate(display);
+        surface = EGL_NO_SURFACE;
+        context = EGL_NO_CONTEXT;
+        display = EGL_NO_DISPLAY;
+    }
+
+private:
+    // 依次尝试 Mesa surfaceless 平台、第一个 EGL device、默认 display
+    bool openDisplay() {
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        std::string extensions = clientExtensions ? clientExtensions : "";
+
+        if (getPlatformDisplay && extensions.find("EGL_MESA_platform_surfaceless") != std::string::npos) {
+            if (tryInitialize(getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr))) return true;
+        }
+
+        auto queryDevices = (PFNEGLQUERYDEVICESEXTPROC)eglGetProcAddress("eglQueryDevicesEXT");
+        if (getPlatformDisplay && queryDevices && extensions.find("EGL_EXT_platform_device") != std::string::npos) {
+            EGLint deviceCount = 0;
+            if (queryDevices(0, nullptr, &deviceCount) && deviceCount > 0) {
+                std::vector<EGLDeviceEXT> devices(deviceCount);
+                if (queryDevices(deviceCount, devices.data(), &deviceCount)) {
+                    for (EGLint i = 0; i < deviceCount; i++) {
+                        if (tryInitialize(getPlatformDisplay(EGL_PLATFORM_DEVICE_EXT, devices[i], nullptr))) return true;
+                    }
+                }
+            }
+        }
+
+        return tryInitialize(eglGetDisplay(EGL_DEFAULT_DISPLAY));
+    }
+
+    bool tryInitialize(EGLDisplay candidate) {
+        if (candidate == EGL_NO_DISPLAY) return false;
+        EGLint major = 0, minor = 0;
+        if (!eglInitialize(candidate, &major, &minor)) return false;
+        display = candidate;
+        return true;
+    }
+
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+};
+#endif
+
+// ---------------- 工厂 ----------------
+
+GLContextBackend GLContext::parseBackend(const std::string& name) {
+    if (name == "window" || name == "glfw") return GLContextBackend::Window;
+    if (name == "headless" || name == "egl") return GLContextBackend::Headless;
+    return GLContextBackend::Auto;
+}
+
+std::unique_ptr<GLContext> GLContext::create(GLContextBackend backend, int width, int height, bool isVisible) {
+    bool useHeadless = backend == GLContextBackend::Headless || (backend == GLContextBackend::Auto && !isVisible);
+
+    if (useHeadless) {
+#ifdef ENGINE_HAS_EGL
+        auto context = std::make_unique<EglContext>();
+        if (context->initialize()) {
+            return context;
+        }
+        std::cerr << "EGL 离屏上下文创建失败" << std::endl;
+#else
+        std::cerr << "未编译 EGL 支持" << std::endl;
+#endif
+        if (backend == GLContextBackend::Headless) {
+            return nullptr;
+        }
+        std::cerr << "退回隐藏的 GLFW 窗口" << std::endl;
+    }
+
+    auto context = std::make_unique<GlfwContext>();
+    if (!context->initialize(width, height, isVisible)) {
+        return nullptr;
+    }
+    return context;
+}
@@ -0,0 +1,43 @@
+// GLContext.h
+
+#ifndef GLCONTEXT_H
+#define GLCONTEXT_H
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include <memory>
+#include <string>
+
+// OpenGL 上下文后端
+// Window：GLFW 窗口（可见时用于调试预览，不可见时仍需要显示服务器）
+// Headless：EGL 离屏上下文（surfaceless 或 pbuffer），不依赖 X/Wayland，可在 Mesa llvmpipe 上运行
+// Auto：调试预览用窗口，其余情况优先 EGL，EGL 不可用时退回隐藏的 GLFW 窗口
+enum class GLContextBackend {
+    Auto,
+    Window,
+    Headless
+};
+
+class GLContext {
+public:
+    virtual ~GLContext() = default;
+
+    // 创建上下文并设为当前，同时完成 glad 的函数加载；失败返回 nullptr
+    static std::unique_ptr<GLContext> create(GLContextBackend backend, int width, int height, bool isVisible);
+
+    // "auto" / "window" / "headless"，无法识别时返回 Auto
+    static GLContextBackend parseBackend(const std::string& name);
+
+    virtual const char* getName() const = 0;
+
+    // 查询 GL 函数地址，用于加载 glad 之外的扩展函数
+    virtual void* getProcAddress(const char* name) const = 0;
+
+    // 只有窗口后端有窗口，离屏后端返回 nullptr
+    virtual GLFWwindow* getWindow() const { return nullptr; }
+
+    // 释放上下文，之后不能再调用 GL 函数
+    virtual void terminate() = 0;
+};
+
+#endif // GLCONTEXT_H
@@ -0,0 +1,84 @@
+// GLExtensions.cpp
+
+#include "GLExtensions.h"
+#include "GLContext.h"
+#include <cstring>
+#include <iostream>
+
+bool GLExtensions::hasProgramBinary = false;
+GLExtensions::GetProgramBinaryProc GLExtensions::getProgramBinary = nullptr;
+GLExtensions::ProgramBinaryProc GLExtensions::programBinary = nullptr;
+GLExtensions::ProgramParameteriProc GLExtensions::programParameteri = nullptr;
+
+bool GLExtensions::hasParallelShaderCompile = false;
+GLExtensions::MaxShaderCompilerThreadsProc GLExtensions::maxShaderCompilerThreads = nullptr;
+
+bool GLExtensions::hasInstancedArrays = false;
+GLExtensions::VertexAttribDivisorProc GLExtensions::vertexAttribDivisor = nullptr;
+
+bool GLExtensions::hasTextureStorage = false;
+GLExtensions::TexStorage2DProc GLExtensions::texStorage2D = nullptr;
+
+bool GLExtensions::hasExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && std::strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void GLExtensions::load(const GLContext& context) {
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    bool isGL42 = major > 4 || (major == 4 && minor >= 2);
+    bool isGL41 = major > 4 || (major == 4 && minor >= 1);
+    bool isGL33 = major > 3 || (major == 3 && minor >= 3);
+
+    // 未支持的函数 eglGetProcAddress/glXGetProcAddress 也可能返回非空，必须先确认版本或扩展
+    hasProgramBinary = false;
+    if (isGL41 || hasExtension("GL_ARB_get_program_binary")) {
+        getProgramBinary = reinterpret_cast<GetProgramBinaryProc>(context.getProcAddress("glGetProgramBinary"));
+        programBinary = reinterpret_cast<ProgramBinaryProc>(context.getProcAddress("glProgramBinary"));
+        programParameteri = reinterpret_cast<ProgramParameteriProc>(context.getProcAddress("glProgramParameteri"));
+        GLint formatCount = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+        hasProgramBinary = getProgramBinary && programBinary && programParameteri && formatCount > 0;
+    }
+
+    hasParallelShaderCompile = false;
+    if (hasExtension("GL_KHR_parallel_shader_compile")) {
+        maxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(context.getProcAddress("glMaxShaderCompilerThreadsKHR"));
+    } else if (hasExtension("GL_ARB_parallel_shader_compile")) {
+        maxShaderCompilerThreads = reinterpret_cast<MaxShaderCompilerThreadsProc>(context.getProcAddress("glMaxShaderCompilerThreadsARB"));
+    }
+    if (maxShaderCompilerThreads) {
+        // 0xFFFFFFFF 表示由驱动决定线程数
+        maxShaderCompilerThreads(0xFFFFFFFFu);
+        hasParallelShaderCompile = true;
+    }
+
+    vertexAttribDivisor = nullptr;
+    if (isGL33) {
+        vertexAttribDivisor = reinterpret_cast<VertexAttribDivisorProc>(context.getProcAddress("glVertexAttribDivisor"));
+    } else if (hasExtension("GL_ARB_instanced_arrays")) {
+        vertexAttribDivisor = reinterpret_cast<VertexAttribDivisorProc>(context.getProcAddress("glVertexAttribDivisorARB"));
+    }
+    hasInstancedArrays = vertexAttribDivisor != nullptr;
+
+    // ARB_texture_storage 的入口没有后缀
+    texStorage2D = nullptr;
+    if (isGL42 || hasExtension("GL_ARB_texture_storage")) {
+        texStorage2D = reinterpret_cast<TexStorage2DProc>(context.getProcAddress("glTexStorage2D"));
+    }
+    hasTextureStorage = texStorage2D != nullptr;
+
+    std::clog << "Program binary: " << (hasProgramBinary ? "yes" : "no")
+              << ", parallel shader compile: " << (hasParallelShaderCompile ? "yes" : "no")
+              << ", instanced arrays: " << (hasInstancedArrays ? "yes" : "no")
+              << ", texture storage: " << (hasTextureStorage ? "yes" : "no") << std::endl;
+}
@@ -0,0 +1,56 @@
+// GLExtensions.h
+
+#ifndef GLEXTENSIONS_H
+#define GLEXTENSIONS_H
+
+#include <glad/glad.h>
+
+class GLContext;
+
+// glad 只生成了 GL 3.2 的函数，3.2 之后的核心函数和扩展在这里按需加载
+// 加载失败或驱动不支持时对应的 has* 为 false，调用方需要走回退路径
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+struct GLExtensions {
+    typedef void (APIENTRY* GetProgramBinaryProc)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+    typedef void (APIENTRY* ProgramBinaryProc)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+    typedef void (APIENTRY* ProgramParameteriProc)(GLuint program, GLenum pname, GLint value);
+    typedef void (APIENTRY* MaxShaderCompilerThreadsProc)(GLuint count);
+    typedef void (APIENTRY* VertexAttribDivisorProc)(GLuint index, GLuint divisor);
+    typedef void (APIENTRY* TexStorage2DProc)(GLenum target, GLsizei levels, GLenum internalformat, GLsizei width, GLsizei height);
+
+    // 创建上下文后调用一次
+    static void load(const GLContext& context);
+    static bool hasExtension(const char* name);
+
+    // GL 4.1 / ARB_get_program_binary，且驱动至少支持一种二进制格式
+    static bool hasProgramBinary;
+    static GetProgramBinaryProc getProgramBinary;
+    static ProgramBinaryProc programBinary;
+    static ProgramParameteriProc programParameteri;
+
+    // KHR/ARB_parallel_shader_compile
+    static bool hasParallelShaderCompile;
+    static MaxShaderCompilerThreadsProc maxShaderCompilerThreads;
+
+    // GL 3.3 / ARB_instanced_arrays，逐实例顶点属性
+    static bool hasInstancedArrays;
+    static VertexAttribDivisorProc vertexAttribDivisor;
+
+    // GL 4.2 / ARB_texture_storage，不可变纹理存储
+    static bool hasTextureStorage;
+    static TexStorage2DProc texStorage2D;
+};
+
+#endif // GLEXTENSIONS_H
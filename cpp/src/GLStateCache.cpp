@@ -0,0 +1,97 @@
+// GLStateCache.cpp
+
+#include "GLStateCache.h"
+#include <iostream>
+
+GLStateCache& GLStateCache::instance()
+{
+    static GLStateCache s;
+    return s;
+}
+
+GLStateCache::GLStateCache() {
+    invalidate();
+}
+
+void GLStateCache::invalidate() {
+    programKnown = false;
+    readFramebuffer = kUnknown;
+    drawFramebuffer = kUnknown;
+    arrayBuffer = kUnknown;
+    pixelPackBuffer = kUnknown;
+    pixelUnpackBuffer = kUnknown;
+    uniformBuffer = kUnknown;
+    uniformBufferBindings.fill(kUnknown);
+    currentVertexArray = kUnknown;
+    currentTextureUnit = kUnknown;
+    textureBindings.fill(kUnknown);
+    blendEnabled = -1;
+    blendSrc = kUnknown;
+    blendDst = kUnknown;
+    blendMode = kUnknown;
+    viewportKnown = false;
+    clearColorKnown = false;
+}
+
+void GLStateCache::deleteProgram(GLuint program) {
+    // 删除当前程序时程序要等到切换后才真正释放，名字不会被复用，但仍按未知处理
+    if (programKnown && currentProgram == program) programKnown = false;
+    glDeleteProgram(program);
+}
+
+void GLStateCache::deleteFramebuffers(GLsizei count, const GLuint* framebuffers) {
+    for (GLsizei i = 0; i < count; i++) {
+        // 删除已绑定的帧缓冲后绑定回到 0
+        if (readFramebuffer == static_cast<GLint64>(framebuffers[i])) readFramebuffer = 0;
+        if (drawFramebuffer == static_cast<GLint64>(framebuffers[i])) drawFramebuffer = 0;
+    }
+    glDeleteFramebuffers(count, framebuffers);
+}
+
+void GLStateCache::deleteBuffers(GLsizei count, const GLuint* buffers) {
+    for (GLsizei i = 0; i < count; i++) {
+        for (GLint64* binding : {&arrayBuffer, &pixelPackBuffer, &pixelUnpackBuffer, &uniformBuffer}) {
+            if (*binding == static_cast<GLint64>(buffers[i])) *binding = 0;
+        }
+        for (auto& binding : uniformBufferBindings) {
+            if (binding == static_cast<GLint64>(buffers[i])) binding = 0;
+        }
+    }
+    glDeleteBuffers(count, buffers);
+}
+
+void GLStateCache::deleteVertexArrays(GLsizei count, const GLuint* vertexArrays) {
+    for (GLsizei i = 0; i < count; i++) {
+        if (currentVertexArray == static_cast<GLint64>(vertexArrays[i])) currentVertexArray = 0;
+    }
+    glDeleteVertexArrays(count, vertexArrays);
+}
+
+void GLStateCache::deleteTextures(GLsizei count, const GLuint* textures) {
+    for (GLsizei i = 0; i < count; i++) {
+        for (auto& binding : textureBindings) {
+            if (binding == static_cast<GLint64>(textures[i])) binding = 0;
+        }
+        // 名字可能被新纹理复用，版本随之失效
+        textureVersions.erase(textures[i]);
+    }
+    glDeleteTextures(count, textures);
+}
+
+void GLStateCache::logCounters() {
+    static const char* names[CounterCount] = {
+        "program", "framebuffer", "buffer", "vertexArray", "activeTexture", "texture", "blend", "viewport", "clearColor"
+    };
+    std::uint64_t totalIssued = 0;
+    std::uint64_t totalSkipped = 0;
+    std::clog << "GL 状态调用（发出/跳过）:";
+    for (int i = 0; i < CounterCount; i++) {
+        std::clog << " " << names[i] << " " << issued[i] << "/" << skipped[i];
+        totalIssued += issued[i];
+        totalSkipped += skipped[i];
+    }
+    std::clog << "，合计 " << totalIssued << "/" << totalSkipped << std::endl;
+
+    issued.fill(0);
+    skipped.fill(0);
+}
@@ -0,0 +1,208 @@
+// GLStateCache.h
+
+#ifndef GLSTATECACHE_H
+#define GLSTATECACHE_H
+
+#include <glad/glad.h>
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+// OpenGL 状态缓存
+// 记录最近一次设置的绑定和渲染状态，值未变化时跳过 GL 调用。llvmpipe 和虚拟化 GPU 上每次 GL 调用的驱动开销都很明显。
+// 约定：
+//   - 引擎内对以下状态的修改都经过这里，否则缓存会与实际状态不一致
+//   - 删除对象使用这里的 delete* 接口，被删除的对象若仍处于绑定状态会同时清除缓存（名字可能被新对象复用）
+//   - 第三方代码（NanoVG）直接修改 GL 状态后调用 invalidate()
+class GLStateCache {
+public:
+    static GLStateCache& instance();
+
+    // 统计项：每项分别记录实际发出与被跳过的调用次数
+    enum Counter {
+        Program, Framebuffer, Buffer, VertexArray, ActiveTexture, Texture, Blend, Viewport, ClearColor,
+        CounterCount
+    };
+
+    // 缓存中的状态全部标记为未知，下一次设置一定会发出 GL 调用
+    void invalidate();
+
+    void useProgram(GLuint program) {
+        if (programKnown && currentProgram == program) { skip(Program); return; }
+        glUseProgram(program);
+        currentProgram = program;
+        programKnown = true;
+        issue(Program);
+    }
+
+    // target 为 GL_FRAMEBUFFER 时同时设置读、写帧缓冲
+    void bindFramebuffer(GLenum target, GLuint framebuffer) {
+        bool setRead = target == GL_FRAMEBUFFER || target == GL_READ_FRAMEBUFFER;
+        bool setDraw = target == GL_FRAMEBUFFER || target == GL_DRAW_FRAMEBUFFER;
+        if ((!setRead || readFramebuffer == framebuffer) && (!setDraw || drawFramebuffer == framebuffer)) {
+            skip(Framebuffer);
+            return;
+        }
+        glBindFramebuffer(target, framebuffer);
+        if (setRead) readFramebuffer = framebuffer;
+        if (setDraw) drawFramebuffer = framebuffer;
+        issue(Framebuffer);
+    }
+
+    // 支持 GL_ARRAY_BUFFER、GL_PIXEL_PACK_BUFFER、GL_PIXEL_UNPACK_BUFFER、GL_UNIFORM_BUFFER，其它目标直接透传
+    void bindBuffer(GLenum target, GLuint buffer) {
+        GLint64* binding = bufferBinding(target);
+        if (binding && *binding == static_cast<GLint64>(buffer)) { skip(Buffer); return; }
+        glBindBuffer(target, buffer);
+        if (binding) *binding = buffer;
+        issue(Buffer);
+    }
+
+    // glBindBufferBase(GL_UNIFORM_BUFFER)，同时会改变 GL_UNIFORM_BUFFER 的通用绑定
+    void bindUniformBuffer(GLuint index, GLuint buffer) {
+        if (index < kMaxUniformBufferBindings && uniformBufferBindings[index] == static_cast<GLint64>(buffer)) { skip(Buffer); return; }
+        glBindBufferBase(GL_UNIFORM_BUFFER, index, buffer);
+        if (index < kMaxUniformBufferBindings) uniformBufferBindings[index] = buffer;
+        uniformBuffer = buffer;
+        issue(Buffer);
+    }
+
+    void bindVertexArray(GLuint vertexArray) {
+        if (currentVertexArray == static_cast<GLint64>(vertexArray)) { skip(VertexArray); return; }
+        glBindVertexArray(vertexArray);
+        currentVertexArray = vertexArray;
+        issue(VertexArray);
+    }
+
+    void activeTexture(GLuint unit) {
+        if (currentTextureUnit == static_cast<GLint64>(unit)) { skip(ActiveTexture); return; }
+        glActiveTexture(GL_TEXTURE0 + unit);
+        currentTextureUnit = unit;
+        issue(ActiveTexture);
+    }
+
+    // 绑定到指定纹理单元（GL_TEXTURE_2D）
+    void bindTexture(GLuint unit, GLuint texture) {
+        if (unit < kMaxTextureUnits && textureBindings[unit] == static_cast<GLint64>(texture)) { skip(Texture); return; }
+        activeTexture(unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        if (unit < kMaxTextureUnits) textureBindings[unit] = texture;
+        issue(Texture);
+    }
+
+    // 绑定到当前纹理单元，用于上传纹理数据
+    void bindTexture(GLuint texture) {
+        if (currentTextureUnit < 0) activeTexture(0);
+        bindTexture(static_cast<GLuint>(currentTextureUnit), texture);
+    }
+
+    void setBlendEnabled(bool enabled) {
+        if (blendEnabled == (enabled ? 1 : 0)) { skip(Blend); return; }
+        if (enabled) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+        blendEnabled = enabled ? 1 : 0;
+        issue(Blend);
+    }
+
+    void blendFunc(GLenum sfactor, GLenum dfactor) {
+        if (blendSrc == static_cast<GLint64>(sfactor) && blendDst == static_cast<GLint64>(dfactor)) { skip(Blend); return; }
+        glBlendFunc(sfactor, dfactor);
+        blendSrc = sfactor;
+        blendDst = dfactor;
+        issue(Blend);
+    }
+
+    void blendEquation(GLenum mode) {
+        if (blendMode == static_cast<GLint64>(mode)) { skip(Blend); return; }
+        glBlendEquation(mode);
+        blendMode = mode;
+        issue(Blend);
+    }
+
+    void viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        std::array<GLint, 4> value = {x, y, width, height};
+        if (viewportKnown && currentViewport == value) { skip(Viewport); return; }
+        glViewport(x, y, width, height);
+        currentViewport = value;
+        viewportKnown = true;
+        issue(Viewport);
+    }
+
+    void clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a) {
+        std::array<GLfloat, 4> value = {r, g, b, a};
+        if (clearColorKnown && currentClearColor == value) { skip(ClearColor); return; }
+        glClearColor(r, g, b, a);
+        currentClearColor = value;
+        clearColorKnown = true;
+        issue(ClearColor);
+    }
+
+    // 纹理内容版本：引擎上传或重新绘制纹理后调用 markTextureModified，RenderPass 据此判断 pass 的输入是否变化
+    // 从未标记过的纹理版本为 0，表示内容来源未知
+    void markTextureModified(GLuint texture) { textureVersions[texture] = ++textureVersionCounter; }
+    std::uint64_t textureVersion(GLuint texture) const {
+        auto it = textureVersions.find(texture);
+        return it != textureVersions.end() ? it->second : 0;
+    }
+
+    void deleteProgram(GLuint program);
+    void deleteFramebuffers(GLsizei count, const GLuint* framebuffers);
+    void deleteBuffers(GLsizei count, const GLuint* buffers);
+    void deleteVertexArrays(GLsizei count, const GLuint* vertexArrays);
+    void deleteTextures(GLsizei count, const GLuint* textures);
+
+    std::uint64_t issuedCount(Counter counter) const { return issued[counter]; }
+    std::uint64_t skippedCount(Counter counter) const { return skipped[counter]; }
+    // 输出各项实际发出/跳过的调用次数，之后重新统计
+    void logCounters();
+
+private:
+    GLStateCache();
+
+    static constexpr GLuint kMaxTextureUnits = 32;
+    static constexpr GLuint kMaxUniformBufferBindings = 16;
+    // 未知状态统一用 -1 表示
+    static constexpr GLint64 kUnknown = -1;
+
+    void issue(Counter counter) { issued[counter]++; }
+    void skip(Counter counter) { skipped[counter]++; }
+
+    GLint64* bufferBinding(GLenum target) {
+        switch (target) {
+        case GL_ARRAY_BUFFER:        return &arrayBuffer;
+        case GL_PIXEL_PACK_BUFFER:   return &pixelPackBuffer;
+        case GL_PIXEL_UNPACK_BUFFER: return &pixelUnpackBuffer;
+        case GL_UNIFORM_BUFFER:      return &uniformBuffer;
+        default:                     return nullptr;
+        }
+    }
+
+    bool programKnown = false;
+    GLuint currentProgram = 0;
+    GLint64 readFramebuffer = kUnknown;
+    GLint64 drawFramebuffer = kUnknown;
+    GLint64 arrayBuffer = kUnknown;
+    GLint64 pixelPackBuffer = kUnknown;
+    GLint64 pixelUnpackBuffer = kUnknown;
+    GLint64 uniformBuffer = kUnknown;
+    std::array<GLint64, kMaxUniformBufferBindings> uniformBufferBindings;
+    GLint64 currentVertexArray = kUnknown;
+    GLint64 currentTextureUnit = kUnknown;
+    std::array<GLint64, kMaxTextureUnits> textureBindings;
+    int blendEnabled = -1;
+    GLint64 blendSrc = kUnknown;
+    GLint64 blendDst = kUnknown;
+    GLint64 blendMode = kUnknown;
+    bool viewportKnown = false;
+    std::array<GLint, 4> currentViewport;
+    bool clearColorKnown = false;
+    std::array<GLfloat, 4> currentClearColor;
+
+    // 纹理内容不属于绑定状态，invalidate() 不会清除
+    std::unordered_map<GLuint, std::uint64_t> textureVersions;
+    std::uint64_t textureVersionCounter = 0;
+
+    std::array<std::uint64_t, CounterCount> issued{};
+    std::array<std::uint64_t, CounterCount> skipped{};
+};
+
+#endif // GLSTATECACHE_H
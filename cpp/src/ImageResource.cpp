@@ -1,6 +1,7 @@
 // ImageResource.cpp
 
 #include "ImageResource.h"
+#include "GLStateCache.h"
 #include <iostream>
 #include <sstream>
 #include <vector>
@@ -11,7 +12,7 @@
 ImageResource::ImageResource(const std::string& filePath)
     :filePath(filePath), width(0), height(0), textureId(0) {
     glGenTextures(1, &textureId);
-    glBindTexture(GL_TEXTURE_2D, textureId);
+    GLStateCache::instance().bindTexture(textureId);
     // 初始化纹理参数
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -26,6 +27,11 @@ ImageResource::~ImageResource() {
 }
 
 bool ImageResource::initialize(int rotate) {
+    // 已经加载过（多个片段共享同一张图片）
+    if (width > 0 && height > 0) {
+        return true;
+    }
+
     // 加载图片数据
     int nrChannels;
     // 如果图片y轴方向翻转，避免纹理显示异常
@@ -45,9 +51,10 @@ bool ImageResource::initialize(int rotate) {
             return false;
         }
 
-        glBindTexture(GL_TEXTURE_2D, textureId);
+        GLStateCache::instance().bindTexture(textureId);
         glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
         glGenerateMipmap(GL_TEXTURE_2D);
+        GLStateCache::instance().markTextureModified(textureId);
 
         std::clog << "成功加载纹理: " << filePath << " (" << width << "x" << height << ", " << nrChannels << " 通道)" << std::endl;
 
@@ -99,7 +106,7 @@ GLuint ImageResource::getSourceHeight() const {
 
 void ImageResource::cleanup() {
     if (textureId != 0) {
-        glDeleteTextures(1, &textureId);
+        GLStateCache::instance().deleteTextures(1, &textureId);
         textureId = 0;
     }
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <sstream>  // 包含字符串流的头文件
 #include "ExpressTool.h"
+#include "GLStateCache.h"
 #include "../CoreUtils.h"
 
 
@@ -136,10 +137,9 @@ std::shared_ptr<Material> Material::deserializePass(const nlohmann::json& passJs
         {
             GLuint buffer = 0;
             glGenBuffers(1, &buffer);
-            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            GLStateCache::instance().bindBuffer(GL_ARRAY_BUFFER, buffer);
             const std::vector<float>& vertices = rendererResourceMap[attributeBufferStr]->getVertices();  // 使用常量引用，避免拷贝
             glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
             material->attributeBuffer = buffer;
         }
         else 
@@ -398,8 +398,6 @@ Material Stand = {
     {
         {"u_texture", UniformValue{UniformType::Texture2D, GLuint(0)}},
         {"u_modelMatrix", UniformValue{UniformType::Mat4, glm::mat4(1.0f)}},
-        {"u_viewMatrix", UniformValue{UniformType::Mat4, glm::mat4(1.0f)}},
-        {"u_projectionMatrix", UniformValue{UniformType::Mat4, glm::mat4(1.0f)}},
         {"u_color", UniformValue{UniformType::Vec4f, glm::vec4(1.0f)}}
     }
 };
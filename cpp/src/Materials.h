@@ -60,6 +60,15 @@ struct Material {
     std::shared_ptr<float[]> clearColor = nullptr;
     GLint a_position = -1;
     GLint a_texCoord = -1;
+
+    // attributeBuffer 中以原点为中心的矩形：半宽高和左上/右下角纹理坐标，合批绘制时代替顶点缓冲
+    // 只有 VideoRenderer 上传顶点时会填写，其它材质 valid 为 false
+    struct Quad {
+        bool valid = false;
+        glm::vec2 halfSize = glm::vec2(0.0f);
+        glm::vec4 uvRect = glm::vec4(0.0f);
+    };
+    Quad quad;
 };
 
 extern Material Blit;
@@ -1,6 +1,7 @@
 #include "PluginRenderer.h"
 #include "Materials.h"
 #include "ExpressTool.h"
+#include "GLStateCache.h"
 #include "../Engine.h"
 
 PluginRenderer::PluginRenderer(Engine& engine, const std::string& name)
@@ -34,9 +35,8 @@ void PluginRenderer::updateVerticeBuffer(Engine& engine)
             x, -y, 0.0f, 1.0f, 0.0f,
         };
 
-        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        GLStateCache::instance().bindBuffer(GL_ARRAY_BUFFER, buffer);
         glBufferData(GL_ARRAY_BUFFER, sizeof(ndcVertices), ndcVertices, GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
         materialPass->attributeBuffer = buffer;
     }
@@ -189,7 +189,7 @@ void PluginRenderer::destroy()
 {
     if (buffer != 0)
     {
-        glDeleteBuffers(1, &buffer);
+        GLStateCache::instance().deleteBuffers(1, &buffer);
         buffer = 0;
     }
 }
\ No newline at end of file
@@ -0,0 +1,108 @@
+// ReadbackRing.cpp
+
+#include "ReadbackRing.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include "GLStateCache.h"
+
+ReadbackRing::ReadbackRing(int depth, size_t frameSize, Consumer consumer)
+    : slots(static_cast<size_t>((std::max)(depth, 1))), frameSize(frameSize), consumer(std::move(consumer)) {
+    GLStateCache& state = GLStateCache::instance();
+    for (auto& slot : slots) {
+        glGenBuffers(1, &slot.buffer);
+        state.bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, frameSize, nullptr, GL_STREAM_READ);
+    }
+}
+
+ReadbackRing::~ReadbackRing() {
+    // 未交付的帧直接丢弃，需要保留时先调用 drain()
+    GLStateCache& state = GLStateCache::instance();
+    for (auto& slot : slots) {
+        if (slot.fence) glDeleteSync(slot.fence);
+        state.deleteBuffers(1, &slot.buffer);
+    }
+}
+
+void ReadbackRing::acquire() {
+    if (inFlight == slots.size()) {
+        deliverOldest(true);
+    }
+    size_t tail = (head + inFlight) % slots.size();
+    GLStateCache::instance().bindBuffer(GL_PIXEL_PACK_BUFFER, slots[tail].buffer);
+}
+
+void ReadbackRing::submit() {
+    size_t tail = (head + inFlight) % slots.size();
+    slots[tail].fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    inFlight++;
+}
+
+void ReadbackRing::poll() {
+    while (inFlight > 0) {
+        GLenum status = glClientWaitSync(slots[head].fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            return;
+        }
+        deliverOldest(false);
+    }
+}
+
+void ReadbackRing::drain() {
+    while (inFlight > 0) {
+        deliverOldest(true);
+    }
+}
+
+void ReadbackRing::deliverOldest(bool wait) {
+    Slot& slot = slots[head];
+    if (wait) {
+        // 先不等待地检查一次，只有 fence 确实未完成才计为阻塞
+        GLenum status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status == GL_TIMEOUT_EXPIRED) {
+            auto start = std::chrono::steady_clock::now();
+            do {
+                status = glClientWaitSync(slot.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+            } while (status == GL_TIMEOUT_EXPIRED);
+            blockedCount++;
+            blockedMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        if (status == GL_WAIT_FAILED) {
+            std::cerr << "等待读回 fence 失败" << std::endl;
+        }
+    }
+    deliver(slot);
+    head = (head + 1) % slots.size();
+    inFlight--;
+}
+
+void ReadbackRing::deliver(Slot& slot) {
+    glDeleteSync(slot.fence);
+    slot.fence = nullptr;
+
+    GLStateCache::instance().bindBuffer(GL_PIXEL_PACK_BUFFER, slot.buffer);
+    const std::uint8_t* data = static_cast<const std::uint8_t*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, frameSize, GL_MAP_READ_BIT));
+    if (data) {
+        consumer(data);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        deliveredCount++;
+    } else {
+        std::cerr << "映射读回缓冲失败，以上一帧代替" << std::endl;
+        consumer(nullptr);
+        mapFailedCount++;
+    }
+}
+
+void ReadbackRing::logReport() {
+    std::clog << "读回环: " << slots.size() << " 块 PBO，交付 " << deliveredCount << " 帧，渲染线程阻塞 "
+              << blockedCount << " 次，共 " << blockedMs << " ms";
+    if (mapFailedCount > 0) {
+        std::clog << "，映射失败 " << mapFailedCount << " 帧";
+    }
+    std::clog << std::endl;
+    deliveredCount = 0;
+    mapFailedCount = 0;
+    blockedCount = 0;
+    blockedMs = 0.0;
+}
@@ -0,0 +1,61 @@
+// ReadbackRing.h
+
+#ifndef READBACKRING_H
+#define READBACKRING_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// N 块 PBO 组成的异步读回环
+// 每次 glReadPixels 之后插入 fence，只有 fence 已完成的 PBO 才会被映射，映射时不会等待 GPU；
+// 只有环被占满（GPU 落后 N 帧）或显式 drain() 时渲染线程才会阻塞，阻塞次数和时间会被统计
+class ReadbackRing {
+public:
+    // 映射后的一帧数据，按提交顺序交付；映射失败时 data 为 nullptr，调用方应以上一帧代替，保持帧数与音频对齐
+    using Consumer = std::function<void(const std::uint8_t* data)>;
+
+    ReadbackRing(int depth, size_t frameSize, Consumer consumer);
+    ~ReadbackRing();
+
+    ReadbackRing(const ReadbackRing&) = delete;
+    ReadbackRing& operator=(const ReadbackRing&) = delete;
+
+    // 取得下一块空闲 PBO 并绑定到 GL_PIXEL_PACK_BUFFER；环已满时先等待并交付最旧的一帧
+    void acquire();
+    // 读回命令发出之后调用，为当前 PBO 插入 fence
+    void submit();
+    // 按顺序交付所有 fence 已完成的帧，不等待
+    void poll();
+    // 等待并交付所有在途的帧，Play 结束或需要保证帧顺序时调用
+    void drain();
+
+    // 输出读回帧数和渲染线程因读回阻塞的次数、时间，之后重新统计
+    void logReport();
+
+private:
+    struct Slot {
+        GLuint buffer = 0;
+        GLsync fence = nullptr;
+    };
+
+    // 等待最旧的在途帧完成并交付
+    void deliverOldest(bool wait);
+    void deliver(Slot& slot);
+
+    std::vector<Slot> slots;
+    size_t frameSize;
+    Consumer consumer;
+    // 最旧的在途帧和在途帧数
+    size_t head = 0;
+    size_t inFlight = 0;
+
+    std::uint64_t deliveredCount = 0;
+    std::uint64_t mapFailedCount = 0;
+    std::uint64_t blockedCount = 0;
+    double blockedMs = 0.0;
+};
+
+#endif // READBACKRING_H
@@ -1,23 +1,127 @@
 // RenderPass.cpp
 
 #include "RenderPass.h"
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include "ScopedProfiler.h"
+#include "GLStateCache.h"
+
+// 内容哈希使用 64 位 FNV-1a
+static const std::uint64_t kHashSeed = 14695981039346656037ull;
+
+static void hashBytes(std::uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+}
+
+template <typename T>
+static void hashValue(std::uint64_t& hash, const T& value) {
+    hashBytes(hash, &value, sizeof(value));
+}
 
 RenderPass::RenderPass(std::shared_ptr<ShaderManager> shaderManager, GLuint width, GLuint height, RenderTargetInfo defaultRenderTargetInfo, GLuint defaultFramebuffer)
-    : shaderManager(shaderManager), width(width), height(height), renderTargetPool(RenderTargetPool::instance()) {
+    : shaderManager(shaderManager), width(width), height(height), renderTargetPool(RenderTargetPool::instance()), standBatch(shaderManager) {
     renderTargetPool.initialize(width, height, defaultRenderTargetInfo, defaultFramebuffer);
+    frameBlock = std::make_unique<UniformBlock>(static_cast<GLsizeiptr>(sizeof(UniformBlock::FrameData)));
     // renderTargetPool = RenderTargetPool::getInstance();
     // renderTargetPool = std::make_shared<RenderTargetPool>(width, height, defaultRenderTargetInfo, defaultFramebuffer);
 }
 
 RenderPass::~RenderPass() {
+    clearCompiledPasses();
+}
+
+void RenderPass::clearCompiledPasses() {
+    for (auto& [key, vertexArray] : vertexArrays) {
+        GLStateCache::instance().deleteVertexArrays(1, &vertexArray);
+    }
+    vertexArrays.clear();
+    compiledPasses.clear();
+    drawLists.clear();
+    programUniforms.clear();
+    generation++;
+}
+
+void RenderPass::setFrameData(const UniformBlock::FrameData& frameData) {
+    this->frameData = frameData;
+    frameBlock->write(0, &frameData, sizeof(frameData));
+}
+
+void RenderPass::logMemoizationReport() {
+    std::clog << "Pass 结果复用（跳过/绘制）: " << memoHits << "/" << memoDraws << std::endl;
+    if (frameDataInvalidations > 0) {
+        std::cerr << "[警告] " << frameDataInvalidations << " 次 pass 的材质输入未变，仅因 FrameUniforms 变化而失去复用，"
+                  << "检查块中是否有逐帧变化的成员" << std::endl;
+    }
+    memoHits = 0;
+    memoDraws = 0;
+    frameDataInvalidations = 0;
+}
+
+bool RenderPass::RenderTargetKey::resolve(const RenderTargetInfo& renderTargetInfo) {
+    if (renderTargetInfo.width == width && renderTargetInfo.height == height && renderTargetInfo.name == infoName) {
+        return false;
+    }
+    infoName = renderTargetInfo.name;
+    width = renderTargetInfo.width;
+    height = renderTargetInfo.height;
+    name = RenderTargetPool::makeRenderTargetName(renderTargetInfo);
+    return true;
 }
 
 void RenderPass::render(std::vector<std::shared_ptr<Material>>& videoRendererMaterials, bool isRelease) {
-    renderedSet.clear();
+    frameStamp++;
+    framePasses.clear();
     for (auto& material : videoRendererMaterials) {
-        renderPass(material, renderedSet);
+        if (!material) continue;
+        DrawList& drawList = getDrawList(material);
+        for (CompiledPass* compiled : drawList.order) {
+            // 多个根共享的 pass 每帧只渲染一次
+            if (renderedStamps[compiled->nameId] == frameStamp) continue;
+            renderedStamps[compiled->nameId] = frameStamp;
+            framePasses.push_back(compiled);
+        }
+    }
+
+    // pass 顺序或任一渲染目标变化时重新计算渲染目标的生存区间
+    bool targetsChanged = planGeneration != generation || framePasses != plannedPasses;
+    for (CompiledPass* compiled : framePasses) {
+        targetsChanged |= compiled->renderTarget.resolve(compiled->material->renderTargetInfo);
+        for (auto& slot : compiled->uniforms) {
+            if (slot.location == -1 || slot.type != UniformType::RenderTarget) continue;
+            if (auto renderTargetInfo = std::get_if<RenderTargetInfo>(&slot.value->value)) {
+                targetsChanged |= slot.renderTarget.resolve(*renderTargetInfo);
+            }
+        }
+    }
+    // 保留输出的 pass 集合变化时也要重新计划：保留目标独占物理目标
+    targetsChanged |= updateContentHashes();
+    if (targetsChanged) {
+        planRenderTargets();
+    }
+
+    // 所有 pass 共享的每帧数据只上传一次
+    frameBlock->bind(UniformBlock::kFrameBinding);
+
+    for (size_t i = 0; i < framePasses.size();) {
+        if (reuseRetainedResult(*framePasses[i])) {
+            i++;
+            continue;
+        }
+        // 保留输出的 pass 独占渲染目标，不会出现在合批中
+        size_t count = renderStandBatch(i);
+        if (count == 0) {
+            renderSinglePass(*framePasses[i]);
+            count = 1;
+        }
+        for (size_t j = i; j < i + count; j++) {
+            recordResult(*framePasses[j]);
+        }
+        i += count;
     }
 
     if (isRelease)
@@ -26,230 +130,737 @@ void RenderPass::render(std::vector<std::shared_ptr<Material>>& videoRendererMat
     }
 }
 
-void RenderPass::renderPass(std::shared_ptr<Material> pass, std::set<std::string>& renderedSet) {
-    if (renderedSet.find(pass->passName) != renderedSet.end()) {
+RenderPass::DrawList& RenderPass::getDrawList(const std::shared_ptr<Material>& material) {
+    DrawList& drawList = drawLists[material.get()];
+
+    // 列表本身和其中每个 pass 都没有变化时直接复用，只做指针和类型比较
+    bool valid = drawList.generation == generation && !drawList.root.expired();
+    if (valid) {
+        for (const CompiledPass* compiled : drawList.order) {
+            if (!isCompiledPassValid(*compiled)) {
+                valid = false;
+                break;
+            }
+        }
+    }
+    if (valid) {
+        return drawList;
+    }
+
+    drawList.root = material;
+    drawList.order.clear();
+    std::set<Material*> visited;
+    std::set<Material*> visiting;
+    buildDrawList(material, drawList.order, visited, visiting);
+    drawList.generation = generation;
+    return drawList;
+}
+
+// 后序遍历：依赖的 pass 排在前面
+void RenderPass::buildDrawList(const std::shared_ptr<Material>& material, std::vector<CompiledPass*>& order, std::set<Material*>& visited, std::set<Material*>& visiting) {
+    if (visited.count(material.get())) {
+        return;
+    }
+    if (!visiting.insert(material.get()).second) {
+        std::cerr << "Pass \"" << material->passName << "\" 存在循环依赖。" << std::endl;
         return;
     }
 
-    // 检查 Pass 的依赖关系
-    for (auto& uniformPair : pass->uniforms) {
-        std::string uniformName = uniformPair.first;
-        UniformValue& uniform = uniformPair.second;
-        if (uniform.type == UniformType::MaterialPtr) {
-            std::shared_ptr<Material> dependentPass = std::get<std::shared_ptr<Material>>(uniform.value);
-            if (dependentPass) {
-                renderPass(dependentPass, renderedSet);
-            }
+    CompiledPass& compiled = getCompiledPass(material);
+    for (auto& [uniformName, uniform] : material->uniforms) {
+        if (uniform.type != UniformType::MaterialPtr) continue;
+        auto dependentPass = std::get_if<std::shared_ptr<Material>>(&uniform.value);
+        if (dependentPass && *dependentPass) {
+            buildDrawList(*dependentPass, order, visited, visiting);
         }
     }
 
-    // 渲染当前 Pass
-    renderSinglePass(pass);
+    visiting.erase(material.get());
+    visited.insert(material.get());
+    order.push_back(&compiled);
+}
+
+RenderPass::CompiledPass& RenderPass::getCompiledPass(const std::shared_ptr<Material>& material) {
+    CompiledPass& compiled = compiledPasses[material.get()];
+    if (compiled.owner.lock() != material || !isCompiledPassValid(compiled)) {
+        compilePass(compiled, material);
+        // 依赖关系可能变化，所有包含该 pass 的绘制列表都要重新排序
+        generation++;
+    }
+    return compiled;
+}
 
-    // 标记为已渲染
-    renderedSet.insert(pass->passName);
+bool RenderPass::isCompiledPassValid(const CompiledPass& compiled) const {
+    if (compiled.owner.expired()) return false;
+    const Material& material = *compiled.material;
+    if (material.attributeBuffer != compiled.attributeBuffer) return false;
+    if (material.uniforms.size() != compiled.uniforms.size()) return false;
+    for (const auto& slot : compiled.uniforms) {
+        if (slot.value->type != slot.type) return false;
+        if (slot.type == UniformType::MaterialPtr) {
+            auto dependentPass = std::get_if<std::shared_ptr<Material>>(&slot.value->value);
+            if ((dependentPass ? dependentPass->get() : nullptr) != slot.dependency) return false;
+        }
+    }
+    return true;
 }
 
-void RenderPass::renderSinglePass(std::shared_ptr<Material> pass) {
-    // ScopedProfiler profilerVideoResource("RenderPass::renderSinglePass" + pass->passName);
+void RenderPass::compilePass(CompiledPass& compiled, const std::shared_ptr<Material>& material) {
+    Material* pass = material.get();
+    compiled.material = pass;
+    compiled.owner = material;
+    compiled.attributeBuffer = pass->attributeBuffer;
+    compiled.uniforms.clear();
+    compiled.blocks.clear();
+    compiled.renderTarget = RenderTargetKey();
+    compiled.frameRenderTarget.reset();
+    compiled.frameStamp = 0;
+    compiled.batchable = false;
+    compiled.stand = StandUniforms();
+    compiled.frameMembers.clear();
+    compiled.contentHash = 0;
+    compiled.retained = false;
+    compiled.memoHash = 0;
+    compiled.memoRetainedId = 0;
 
-    GLuint program = shaderManager->getProgram(pass->vertexShader, pass->fragmentShader);
-    if (!program) {
+    auto nameIt = passNameIds.find(pass->passName);
+    if (nameIt == passNameIds.end()) {
+        nameIt = passNameIds.emplace(pass->passName, static_cast<int>(passNameIds.size())).first;
+        renderedStamps.push_back(0);
+    }
+    compiled.nameId = nameIt->second;
+
+    compiled.program = shaderManager->getProgram(pass->vertexShader, pass->fragmentShader);
+    if (!compiled.program) {
         std::cerr << "无法渲染通道: " << pass->passName << "。Shader program 初始化失败。" << std::endl;
-        return;
     }
 
-    glUseProgram(program);
+    GLint positionLocation = -1;
+    GLint texCoordLocation = -1;
+    if (compiled.program) {
+        positionLocation = glGetAttribLocation(compiled.program, "a_position");
+        texCoordLocation = glGetAttribLocation(compiled.program, "a_texCoord");
+    }
+    compiled.vertexArray = compiled.program ? getVertexArray(pass->attributeBuffer, positionLocation, texCoordLocation) : 0;
 
-    {
-        // ScopedProfiler profilerVideoResource("acquire RenderTarget" + pass->passName);
+    std::unordered_map<std::string, std::pair<int, GLint>> blockMembers;
+    if (compiled.program) {
+        blockMembers = compileUniformBlocks(compiled);
+    }
+
+    // uniform location 和纹理单元只在编译时确定一次
+    GLint textureUnit = 0;
+    GLint maxLocation = -1;
+    for (auto& [uniformName, uniform] : pass->uniforms) {
+        CompiledUniform slot;
+        slot.value = &uniform;
+        slot.type = uniform.type;
+        if (uniform.type == UniformType::MaterialPtr) {
+            auto dependentPass = std::get_if<std::shared_ptr<Material>>(&uniform.value);
+            slot.dependency = dependentPass ? dependentPass->get() : nullptr;
+        }
+
+        if (compiled.program) {
+            slot.location = glGetUniformLocation(compiled.program, uniformName.c_str());
+            auto memberIt = blockMembers.find(uniformName);
+            if (slot.location == -1 && memberIt != blockMembers.end()) {
+                // 块成员写入该 pass 的块缓冲；FrameUniforms 成员由引擎每帧统一提供，材质中的值忽略
+                if (memberIt->second.first >= 0) {
+                    compiled.blocks[memberIt->second.first].members.push_back({&uniform, uniform.type, memberIt->second.second});
+                }
+            } else if (slot.location == -1) {
+                std::cerr << "Uniform \"" << uniformName << "\" 不存在于着色器，pass \"" << pass->passName << "\"" << std::endl;
+            }
+        }
 
-        // 渲染到纹理
-        std::shared_ptr<RenderTarget> renderTarget = renderTargetPool.acquire(pass->renderTargetInfo);
-        if (!renderTarget) {
-            std::cerr << "无法获取渲染目标用于 Pass: " << pass->passName << std::endl;
-            return;
+        if (slot.location != -1) {
+            maxLocation = std::max(maxLocation, slot.location);
+            switch (uniform.type) {
+            case UniformType::Texture2D:
+            case UniformType::MaterialPtr:
+            case UniformType::RenderTarget:
+                slot.textureUnit = textureUnit++;
+                break;
+            case UniformType::Int:
+            case UniformType::Float:
+            case UniformType::Mat4:
+            case UniformType::Vec4f:
+            case UniformType::Vec2f:
+            case UniformType::Vec2i:
+            case UniformType::Vec3i:
+            case UniformType::Vec3f:
+                break;
+            default:
+                std::cerr << "不支持的 uniform 类型 \"" << uniform.type << "\"，uniform \"" << uniformName << "\" 在 pass \"" << pass->passName << "\"" << std::endl;
+                slot.location = -1;
+                break;
+            }
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, renderTarget->framebuffer);
+        compiled.uniforms.push_back(slot);
+    }
 
-        glViewport(0, 0, pass->renderTargetInfo.width, pass->renderTargetInfo.height);
+    // Stand 图层除了 uniform 值之外完全相同，记录下来供合批绘制
+    if (compiled.program && pass->vertexShader == Stand.vertexShader && pass->fragmentShader == Stand.fragmentShader &&
+        pass->clear == std::numeric_limits<unsigned int>::max() && pass->clearColor == nullptr &&
+        pass->uniforms.size() == Stand.uniforms.size()) {
+        auto findUniform = [&](const char* name, UniformType type) -> const UniformValue* {
+            auto it = pass->uniforms.find(name);
+            return it != pass->uniforms.end() && it->second.type == type ? &it->second : nullptr;
+        };
+        StandUniforms& stand = compiled.stand;
+        stand.texture = findUniform("u_texture", UniformType::Texture2D);
+        stand.modelMatrix = findUniform("u_modelMatrix", UniformType::Mat4);
+        stand.color = findUniform("u_color", UniformType::Vec4f);
+        compiled.batchable = stand.texture && stand.modelMatrix && stand.color;
     }
-    {
-        // ScopedProfiler profilerVideoResource("glBindBuffer and  Vertex " + pass->passName);
 
+    // 同一个程序被多个 pass 共用，已上传的 uniform 值按程序记录
+    compiled.shadow = nullptr;
+    if (compiled.program) {
+        auto& shadow = programUniforms[compiled.program];
+        if (static_cast<GLint>(shadow.size()) <= maxLocation) {
+            shadow.resize(maxLocation + 1);
+        }
+        compiled.shadow = &shadow;
+    }
+}
 
-        // 绑定属性缓冲区
-        glBindBuffer(GL_ARRAY_BUFFER, pass->attributeBuffer);
+std::unordered_map<std::string, std::pair<int, GLint>> RenderPass::compileUniformBlocks(CompiledPass& compiled) {
+    std::unordered_map<std::string, std::pair<int, GLint>> members;
+    GLuint program = compiled.program;
+    GLint blockCount = 0;
+    glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+    GLint maxBindings = 0;
+    glGetIntegerv(GL_MAX_UNIFORM_BUFFER_BINDINGS, &maxBindings);
 
-        {
-            // ScopedProfiler profilerVideoResource("Vertex " + pass->passName);
+    for (GLint blockIndex = 0; blockIndex < blockCount; blockIndex++) {
+        char nameBuffer[256];
+        glGetActiveUniformBlockName(program, blockIndex, sizeof(nameBuffer), nullptr, nameBuffer);
+        std::string blockName = nameBuffer;
 
-            // 设置顶点属性
-            GLint a_position;
-            if (pass->a_position != -1)
-            {
-                a_position = pass->a_position;
-            }
-            else
-            {
-                a_position = glGetAttribLocation(program, "a_position");
-                pass->a_position = a_position;
+        int compiledIndex = -1;
+        if (blockName == UniformBlock::kFrameBlockName) {
+            glUniformBlockBinding(program, blockIndex, UniformBlock::kFrameBinding);
+        } else {
+            GLuint binding = UniformBlock::kFirstPassBinding + static_cast<GLuint>(compiled.blocks.size());
+            if (static_cast<GLint>(binding) >= maxBindings) {
+                std::cerr << "Uniform 块 \"" << blockName << "\" 超出绑定点数量，pass \"" << compiled.material->passName << "\"" << std::endl;
+                continue;
             }
-            glEnableVertexAttribArray(a_position);
-            glVertexAttribPointer(a_position, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+            GLint dataSize = 0;
+            glGetActiveUniformBlockiv(program, blockIndex, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+            glUniformBlockBinding(program, blockIndex, binding);
 
-            GLint a_texCoord;
-            if (pass->a_texCoord != -1)
-            {
-                a_texCoord = pass->a_texCoord;
+            CompiledBlock block;
+            block.block = std::make_unique<UniformBlock>(dataSize);
+            block.binding = binding;
+            compiledIndex = static_cast<int>(compiled.blocks.size());
+            compiled.blocks.push_back(std::move(block));
+        }
+
+        GLint memberCount = 0;
+        glGetActiveUniformBlockiv(program, blockIndex, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &memberCount);
+        if (memberCount <= 0) continue;
+        std::vector<GLint> indices(memberCount);
+        glGetActiveUniformBlockiv(program, blockIndex, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, indices.data());
+        std::vector<GLuint> uniformIndices(indices.begin(), indices.end());
+        std::vector<GLint> offsets(memberCount);
+        glGetActiveUniformsiv(program, memberCount, uniformIndices.data(), GL_UNIFORM_OFFSET, offsets.data());
+        if (compiledIndex < 0) {
+            // 着色器声明的 FrameUniforms 成员参与内容哈希（std140 块的成员即使没有被引用也是活动的），
+            // 因此块中只能有整个任务不变的数据，否则所有 Stand pass 每帧都会重绘
+            std::vector<GLint> types(memberCount);
+            glGetActiveUniformsiv(program, memberCount, uniformIndices.data(), GL_UNIFORM_TYPE, types.data());
+            for (GLint i = 0; i < memberCount; i++) {
+                compiled.frameMembers.push_back({offsets[i], uniformTypeSize(static_cast<GLenum>(types[i]))});
             }
-            else
-            {
-                a_texCoord = glGetAttribLocation(program, "a_texCoord");
-                pass->a_texCoord = a_texCoord;
+        }
+        for (GLint i = 0; i < memberCount; i++) {
+            glGetActiveUniformName(program, uniformIndices[i], sizeof(nameBuffer), nullptr, nameBuffer);
+            // 带实例名的块成员名为 "块名.成员名"
+            std::string memberName = nameBuffer;
+            size_t dot = memberName.rfind('.');
+            if (dot != std::string::npos) memberName = memberName.substr(dot + 1);
+            members[memberName] = {compiledIndex, offsets[i]};
+        }
+    }
+    return members;
+}
+
+const void* RenderPass::uniformData(const UniformValue& uniform, UniformType type, size_t& size) {
+    const UniformVariant& value = uniform.value;
+    switch (type) {
+    case UniformType::Int:
+        size = sizeof(int);
+        return std::get_if<int>(&value);
+    case UniformType::Float:
+        size = sizeof(float);
+        return std::get_if<float>(&value);
+    case UniformType::Mat4:
+        size = sizeof(glm::mat4);
+        return std::get_if<glm::mat4>(&value);
+    case UniformType::Vec4f:
+        size = sizeof(glm::vec4);
+        return std::get_if<glm::vec4>(&value);
+    case UniformType::Vec2f:
+        size = sizeof(glm::vec2);
+        return std::get_if<glm::vec2>(&value);
+    case UniformType::Vec2i:
+        size = sizeof(glm::ivec2);
+        return std::get_if<glm::ivec2>(&value);
+    case UniformType::Vec3i:
+        size = sizeof(glm::ivec3);
+        return std::get_if<glm::ivec3>(&value);
+    case UniformType::Vec3f:
+        size = sizeof(glm::vec3);
+        return std::get_if<glm::vec3>(&value);
+    default:
+        return nullptr;
+    }
+}
+
+GLint RenderPass::uniformTypeSize(GLenum type) {
+    switch (type) {
+    case GL_FLOAT:
+    case GL_INT:
+        return 4;
+    case GL_FLOAT_VEC2:
+    case GL_INT_VEC2:
+        return 8;
+    case GL_FLOAT_VEC3:
+    case GL_INT_VEC3:
+        return 12;
+    case GL_FLOAT_MAT4:
+        return 64;
+    default:
+        return 16;
+    }
+}
+
+GLuint RenderPass::getVertexArray(GLuint attributeBuffer, GLint positionLocation, GLint texCoordLocation) {
+    auto key = std::make_tuple(attributeBuffer, positionLocation, texCoordLocation);
+    auto it = vertexArrays.find(key);
+    if (it != vertexArrays.end()) {
+        return it->second;
+    }
+
+    GLuint vertexArray = 0;
+    glGenVertexArrays(1, &vertexArray);
+    GLStateCache& state = GLStateCache::instance();
+    state.bindVertexArray(vertexArray);
+    state.bindBuffer(GL_ARRAY_BUFFER, attributeBuffer);
+    if (positionLocation != -1) {
+        glEnableVertexAttribArray(positionLocation);
+        glVertexAttribPointer(positionLocation, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
+    }
+    if (texCoordLocation != -1) {
+        glEnableVertexAttribArray(texCoordLocation);
+        glVertexAttribPointer(texCoordLocation, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
+    }
+
+    vertexArrays[key] = vertexArray;
+    return vertexArray;
+}
+
+void RenderPass::planRenderTargets() {
+    renderTargetUses.clear();
+    std::unordered_map<std::string, size_t> useIndices;
+    auto touch = [&](const std::string& name, int targetWidth, int targetHeight, int position) {
+        auto [it, inserted] = useIndices.emplace(name, renderTargetUses.size());
+        if (inserted) {
+            renderTargetUses.push_back({name, targetWidth, targetHeight, false, position, position});
+        } else {
+            renderTargetUses[it->second].lastUse = position;
+        }
+    };
+
+    for (size_t i = 0; i < framePasses.size(); i++) {
+        CompiledPass& compiled = *framePasses[i];
+        int position = static_cast<int>(i);
+        const RenderTargetInfo& renderTargetInfo = compiled.material->renderTargetInfo;
+        touch(compiled.renderTarget.name, renderTargetInfo.width, renderTargetInfo.height, position);
+        if (compiled.retained) {
+            renderTargetUses[useIndices[compiled.renderTarget.name]].retained = true;
+        }
+
+        for (auto& slot : compiled.uniforms) {
+            if (slot.location == -1) continue;
+            if (slot.type == UniformType::MaterialPtr && slot.dependency) {
+                const RenderTargetInfo& dependentInfo = slot.dependency->renderTargetInfo;
+                auto dependentIt = compiledPasses.find(slot.dependency);
+                if (dependentIt != compiledPasses.end() && !dependentIt->second.renderTarget.name.empty()) {
+                    touch(dependentIt->second.renderTarget.name, dependentInfo.width, dependentInfo.height, position);
+                } else {
+                    touch(RenderTargetPool::makeRenderTargetName(dependentInfo), dependentInfo.width, dependentInfo.height, position);
+                }
+            } else if (slot.type == UniformType::RenderTarget && !slot.renderTarget.name.empty()) {
+                touch(slot.renderTarget.name, slot.renderTarget.width, slot.renderTarget.height, position);
             }
-            glEnableVertexAttribArray(a_texCoord);
-            glVertexAttribPointer(a_texCoord, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
         }
     }
 
-    {
-        // ScopedProfiler profilerVideoResource("update uniforms" + pass->passName);
-
-        // 设置统一变量（uniforms）
-        GLuint currentTextureUnit = 0;
-        for (auto& uniformPair : pass->uniforms) {
-            std::string uniformName = uniformPair.first;
-            UniformValue& uniform = uniformPair.second;
-            GLint location = glGetUniformLocation(program, uniformName.c_str());
-            if (location == -1) {
-                std::cerr << "Uniform \"" << uniformName << "\" 不存在于着色器，pass \"" << pass->passName << "\"" << std::endl;
-                continue;
+    renderTargetPool.planFrame(renderTargetUses);
+    plannedPasses = framePasses;
+    planGeneration = generation;
+}
+
+bool RenderPass::updateContentHashes() {
+    targetHashes.clear();
+    targetWriters.clear();
+    touchedTargets.clear();
+    for (CompiledPass* compiled : framePasses) {
+        targetWriters[compiled->renderTarget.name]++;
+    }
+
+    GLStateCache& state = GLStateCache::instance();
+    bool retainedChanged = false;
+    for (CompiledPass* compiledPass : framePasses) {
+        CompiledPass& compiled = *compiledPass;
+        const Material& pass = *compiled.material;
+
+        std::uint64_t hash = kHashSeed;
+        // 内容无法确定的输入（未登记版本的纹理、本帧没有写入的依赖）混入帧序号，哈希每帧都不同
+        bool unknownInput = compiled.program == 0;
+        hashValue(hash, compiled.program);
+        hashValue(hash, compiled.attributeBuffer);
+        hashValue(hash, pass.renderTargetInfo.width);
+        hashValue(hash, pass.renderTargetInfo.height);
+        hashValue(hash, pass.clear);
+        if (pass.clearColor) {
+            hashBytes(hash, pass.clearColor.get(), 4 * sizeof(float));
+        }
+        hashValue(hash, pass.quad.valid);
+        hashValue(hash, pass.quad.halfSize);
+        hashValue(hash, pass.quad.uvRect);
+
+        for (const auto& slot : compiled.uniforms) {
+            hashValue(hash, slot.type);
+            switch (slot.type) {
+            case UniformType::Texture2D: {
+                if (slot.location == -1) break;
+                auto texture = std::get_if<GLuint>(&slot.value->value);
+                std::uint64_t version = texture ? state.textureVersion(*texture) : 0;
+                unknownInput |= version == 0;
+                hashValue(hash, texture ? *texture : 0u);
+                hashValue(hash, version);
+                break;
+            }
+            case UniformType::MaterialPtr: {
+                if (slot.location == -1) break;
+                // 依赖 pass 已经排在前面，它的输出哈希沿 DAG 传递到这里
+                auto dependentIt = slot.dependency ? compiledPasses.find(slot.dependency) : compiledPasses.end();
+                auto targetIt = targetHashes.end();
+                if (dependentIt != compiledPasses.end()) {
+                    const std::string& dependentName = dependentIt->second.renderTarget.name;
+                    targetIt = targetHashes.find(dependentName);
+                    touchedTargets.insert(dependentName);
+                }
+                if (targetIt != targetHashes.end()) {
+                    hashValue(hash, targetIt->second);
+                } else {
+                    unknownInput = true;
+                }
+                break;
+            }
+            case UniformType::RenderTarget: {
+                if (slot.location == -1) break;
+                // 本帧还没有写入的目标在第一次获取时被清空，内容同样确定
+                const std::string& name = slot.renderTarget.name;
+                auto targetIt = targetHashes.find(name);
+                hashBytes(hash, name.data(), name.size());
+                hashValue(hash, targetIt != targetHashes.end() ? targetIt->second : kHashSeed);
+                touchedTargets.insert(name);
+                break;
+            }
+            default: {
+                size_t size = 0;
+                const void* data = uniformData(*slot.value, slot.type, size);
+                if (data) {
+                    hashBytes(hash, data, size);
+                }
+                break;
+            }
+            }
+        }
+
+        // 材质输入不变、只有 FrameUniforms 变化而导致的重绘，说明块中混入了逐帧变化的数据
+        std::uint64_t inputHash = hash;
+        bool inputStable = !unknownInput && compiled.contentHash != 0 && inputHash == compiled.inputHash;
+        compiled.inputHash = inputHash;
+
+        const unsigned char* frameBytes = reinterpret_cast<const unsigned char*>(&frameData);
+        for (const auto& [offset, size] : compiled.frameMembers) {
+            if (offset >= 0 && static_cast<size_t>(offset + size) <= sizeof(frameData)) {
+                hashBytes(hash, frameBytes + offset, size);
             }
+        }
+        if (unknownInput) {
+            hashValue(hash, frameStamp);
+        }
+
+        // 只有独占渲染目标、且本帧在它之前没有 pass 读取该目标时，输出才能跨帧保留
+        const std::string& name = compiled.renderTarget.name;
+        bool stable = hash == compiled.contentHash;
+        if (inputStable && !stable) {
+            frameDataInvalidations++;
+        }
+        bool retained = stable && targetWriters[name] == 1 && !touchedTargets.count(name);
+        retainedChanged |= retained != compiled.retained;
+        compiled.retained = retained;
+        compiled.contentHash = hash;
+
+        touchedTargets.insert(name);
+        auto [targetIt, inserted] = targetHashes.emplace(name, hash);
+        if (!inserted) {
+            hashValue(targetIt->second, hash);
+        }
+    }
+    return retainedChanged;
+}
+
+bool RenderPass::reuseRetainedResult(CompiledPass& compiled) {
+    if (!compiled.retained || compiled.memoRetainedId == 0 || compiled.memoHash != compiled.contentHash ||
+        renderTargetPool.retainedId(compiled.renderTarget.name) != compiled.memoRetainedId) {
+        return false;
+    }
+    const RenderTargetInfo& renderTargetInfo = compiled.material->renderTargetInfo;
+    std::shared_ptr<RenderTarget> renderTarget = renderTargetPool.acquire(compiled.renderTarget.name, renderTargetInfo.width, renderTargetInfo.height, false, false);
+    if (!renderTarget) {
+        return false;
+    }
+    compiled.frameRenderTarget = renderTarget;
+    compiled.frameStamp = frameStamp;
+    memoHits++;
+    return true;
+}
 
-            if (uniform.type == UniformType::Texture2D) {
-                GLuint texture = std::get<GLuint>(uniform.value);
-
-                glActiveTexture(GL_TEXTURE0 + currentTextureUnit);
-                glBindTexture(GL_TEXTURE_2D, texture);
-                glUniform1i(location, currentTextureUnit);
-                currentTextureUnit++;
-            } else if (uniform.type == UniformType::MaterialPtr) {
-                std::shared_ptr<Material> dependentPass = std::get<std::shared_ptr<Material>>(uniform.value);
-                if (dependentPass) {
-                    auto dependentRenderTarget = renderTargetPool.acquire(dependentPass->renderTargetInfo);
-                    if (!dependentRenderTarget) {
-                        std::cerr << "Pass \"" << dependentPass->passName << "\" 没有渲染目标纹理。" << std::endl;
-                        continue;
+void RenderPass::recordResult(CompiledPass& compiled) {
+    compiled.memoHash = compiled.contentHash;
+    compiled.memoRetainedId = compiled.retained ? renderTargetPool.retainedId(compiled.renderTarget.name) : 0;
+    memoDraws++;
+}
+
+std::shared_ptr<RenderTarget> RenderPass::acquireDependency(const Material* dependency) {
+    auto it = compiledPasses.find(dependency);
+    if (it != compiledPasses.end() && it->second.frameStamp == frameStamp && it->second.frameRenderTarget) {
+        return it->second.frameRenderTarget;
+    }
+    return renderTargetPool.acquire(dependency->renderTargetInfo);
+}
+
+bool RenderPass::uniformChanged(CompiledPass& compiled, GLint location, const void* data, size_t size) {
+    UniformShadow& shadow = (*compiled.shadow)[location];
+    if (shadow.valid && std::memcmp(shadow.data.data(), data, size) == 0) {
+        return false;
+    }
+    std::memcpy(shadow.data.data(), data, size);
+    shadow.valid = true;
+    return true;
+}
+
+std::shared_ptr<RenderTarget> RenderPass::bindRenderTarget(CompiledPass& compiled) {
+    const Material& pass = *compiled.material;
+    std::shared_ptr<RenderTarget> renderTarget = renderTargetPool.acquire(compiled.renderTarget.name, pass.renderTargetInfo.width, pass.renderTargetInfo.height);
+    if (!renderTarget) {
+        std::cerr << "无法获取渲染目标用于 Pass: " << pass.passName << std::endl;
+        return nullptr;
+    }
+    compiled.frameRenderTarget = renderTarget;
+    compiled.frameStamp = frameStamp;
+    GLStateCache& state = GLStateCache::instance();
+    state.bindFramebuffer(GL_FRAMEBUFFER, renderTarget->framebuffer);
+    state.viewport(0, 0, pass.renderTargetInfo.width, pass.renderTargetInfo.height);
+    return renderTarget;
+}
+
+size_t RenderPass::renderStandBatch(size_t first) {
+    const CompiledPass& head = *framePasses[first];
+    if (!head.batchable || !standBatch.isAvailable()) {
+        return 0;
+    }
+    // 同一渲染目标的连续 Stand pass，绘制顺序不变，混合结果与逐个绘制一致
+    batchInstances.clear();
+    batchTextures.clear();
+    size_t end = first;
+    for (; end < framePasses.size(); end++) {
+        const CompiledPass& compiled = *framePasses[end];
+        if (!compiled.batchable || !compiled.material->quad.valid || compiled.renderTarget.name != head.renderTarget.name) break;
+        const StandUniforms& stand = compiled.stand;
+        auto texture = std::get_if<GLuint>(&stand.texture->value);
+        auto modelMatrix = std::get_if<glm::mat4>(&stand.modelMatrix->value);
+        auto color = std::get_if<glm::vec4>(&stand.color->value);
+        if (!texture || !modelMatrix || !color) break;
+
+        // 相同纹理共用一个槽位，槽位用完时结束本批
+        auto slotIt = std::find(batchTextures.begin(), batchTextures.end(), *texture);
+        if (slotIt == batchTextures.end()) {
+            if (batchTextures.size() == StandBatchRenderer::kMaxTextures) break;
+            slotIt = batchTextures.insert(batchTextures.end(), *texture);
+        }
+        float slot = static_cast<float>(slotIt - batchTextures.begin());
+
+        const Material::Quad& quad = compiled.material->quad;
+        batchInstances.push_back({*modelMatrix, *color, quad.uvRect, glm::vec4(quad.halfSize, slot, 0.0f)});
+    }
+    size_t count = end - first;
+    if (count < 2) {
+        return 0;
+    }
+
+    std::shared_ptr<RenderTarget> renderTarget = bindRenderTarget(*framePasses[first]);
+    if (!renderTarget) {
+        return count;
+    }
+    for (size_t i = first + 1; i < end; i++) {
+        framePasses[i]->frameRenderTarget = renderTarget;
+        framePasses[i]->frameStamp = frameStamp;
+    }
+    standBatch.draw(batchInstances, batchTextures);
+    return count;
+}
+
+void RenderPass::renderSinglePass(CompiledPass& compiled) {
+    // ScopedProfiler profilerVideoResource("RenderPass::renderSinglePass" + pass->passName);
+
+    Material& pass = *compiled.material;
+    if (!compiled.program) {
+        return;
+    }
+
+    // 绑定和状态切换都经过状态缓存，相邻 pass 相同的程序、帧缓冲、视口和纹理不再重复设置
+    GLStateCache& state = GLStateCache::instance();
+    state.useProgram(compiled.program);
+
+    // 渲染到纹理
+    if (!bindRenderTarget(compiled)) {
+        return;
+    }
+
+    state.bindVertexArray(compiled.vertexArray);
+
+    // 设置统一变量（uniforms），只上传变化的值
+    for (auto& slot : compiled.uniforms) {
+        if (slot.location == -1) continue;
+        const UniformVariant& value = slot.value->value;
+
+        if (slot.textureUnit >= 0) {
+            GLuint texture = 0;
+            bool hasTexture = false;
+            if (slot.type == UniformType::Texture2D) {
+                if (auto textureValue = std::get_if<GLuint>(&value)) {
+                    texture = *textureValue;
+                    hasTexture = true;
+                }
+            } else if (slot.type == UniformType::MaterialPtr) {
+                if (slot.dependency) {
+                    auto dependentRenderTarget = acquireDependency(slot.dependency);
+                    if (dependentRenderTarget) {
+                        texture = dependentRenderTarget->texture;
+                        hasTexture = true;
+                    } else {
+                        std::cerr << "Pass \"" << slot.dependency->passName << "\" 没有渲染目标纹理。" << std::endl;
                     }
-                    GLuint texture = dependentRenderTarget->texture;
-
-                    glActiveTexture(GL_TEXTURE0 + currentTextureUnit);
-                    glBindTexture(GL_TEXTURE_2D, texture);
-                    glUniform1i(location, currentTextureUnit);
-                    currentTextureUnit++;
-                }
-            } else if (uniform.type == UniformType::RenderTarget) {
-                RenderTargetInfo renderTargetInfo = std::get<RenderTargetInfo>(uniform.value);
-                auto dependentRenderTarget = renderTargetPool.acquire(renderTargetInfo);
-                if (!dependentRenderTarget) {
-                    std::cerr << "renderTargetInfo.name \"" << renderTargetInfo.name << "\" 没有渲染目标纹理。" << std::endl;
-                    continue;
-                }
-                GLuint texture = dependentRenderTarget->texture;
-
-                glActiveTexture(GL_TEXTURE0 + currentTextureUnit);
-                glBindTexture(GL_TEXTURE_2D, texture);
-                glUniform1i(location, currentTextureUnit);
-                currentTextureUnit++;
-            } else if (uniform.type == UniformType::Mat4) {
-                if (std::holds_alternative<glm::mat4>(uniform.value)) {
-                    glm::mat4 mat = std::get<glm::mat4>(uniform.value);
-                    glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]);
-                } else {
-                    std::cerr << "mat4 类型的 uniform \"" << uniformName << "\" 的值类型不正确。" << std::endl;
                 }
-            } else if (uniform.type == UniformType::Float) {
-                if (std::holds_alternative<float>(uniform.value)) {
-                    float val = std::get<float>(uniform.value);
-                    glUniform1f(location, val);
+            } else if (auto renderTargetInfo = std::get_if<RenderTargetInfo>(&value)) {
+                slot.renderTarget.resolve(*renderTargetInfo);
+                auto dependentRenderTarget = renderTargetPool.acquire(slot.renderTarget.name, renderTargetInfo->width, renderTargetInfo->height);
+                if (dependentRenderTarget) {
+                    texture = dependentRenderTarget->texture;
+                    hasTexture = true;
                 } else {
-                    std::cerr << "float 类型的 uniform \"" << uniformName << "\" 的值类型不正确。" << std::endl;
+                    std::cerr << "renderTargetInfo.name \"" << renderTargetInfo->name << "\" 没有渲染目标纹理。" << std::endl;
                 }
-            } else if (uniform.type == UniformType::Vec4f) {
-                if (std::holds_alternative<glm::vec4>(uniform.value)) {
-                    glm::vec4 vec4f = std::get<glm::vec4>(uniform.value);
-                    glUniform4fv(location, 1, &vec4f[0]);
-                } else {
-                    std::cerr << "Vec4f 类型的 uniform \"" << uniformName << "\" 的值类型不正确。" << std::endl;
+            }
+            if (!hasTexture) continue;
+
+            state.bindTexture(slot.textureUnit, texture);
+            if (uniformChanged(compiled, slot.location, &slot.textureUnit, sizeof(GLint))) {
+                glUniform1i(slot.location, slot.textureUnit);
+            }
+            continue;
+        }
+
+        switch (slot.type) {
+        case UniformType::Mat4:
+            if (auto mat = std::get_if<glm::mat4>(&value)) {
+                if (uniformChanged(compiled, slot.location, &(*mat)[0][0], sizeof(glm::mat4))) {
+                    glUniformMatrix4fv(slot.location, 1, GL_FALSE, &(*mat)[0][0]);
                 }
-            } else if (uniform.type == UniformType::Vec2f) {
-                if (std::holds_alternative<glm::vec2>(uniform.value)) {
-                    glm::vec2 vec2f = std::get<glm::vec2>(uniform.value);
-                    glUniform2fv(location, 1, &vec2f[0]);
-                } else {
-                    std::cerr << "Vec2f 类型的 uniform \"" << uniformName << "\" 的值类型不正确。" << std::endl;
+            }
+            break;
+        case UniformType::Float:
+            if (auto val = std::get_if<float>(&value)) {
+                if (uniformChanged(compiled, slot.location, val, sizeof(float))) {
+                    glUniform1f(slot.location, *val);
                 }
-            } else if (uniform.type == UniformType::Int) {
-                if (std::holds_alternative<int>(uniform.value)) {
-                    int iv = std::get<int>(uniform.value);
-                    glUniform1i(location, iv);
-                } else {
-                    std::cerr << "Int 类型的 uniform \"" << uniformName << "\" 的值类型不正确。" << std::endl;
+            }
+            break;
+        case UniformType::Vec4f:
+            if (auto vec4f = std::get_if<glm::vec4>(&value)) {
+                if (uniformChanged(compiled, slot.location, &(*vec4f)[0], sizeof(glm::vec4))) {
+                    glUniform4fv(slot.location, 1, &(*vec4f)[0]);
                 }
             }
-            
-            else if (uniform.type == UniformType::Vec2i) {
-                if (std::holds_alternative<glm::ivec2>(uniform.value)) {
-                    glm::ivec2 vec2 = std::get<glm::ivec2>(uniform.value);
-                    glUniform2iv(location, 1, &vec2[0]);
-                } else {
-                    std::cerr << "Vec2i 类型的 uniform \"" << uniformName << "\" 的值类型不正确。" << std::endl;
+            break;
+        case UniformType::Vec2f:
+            if (auto vec2f = std::get_if<glm::vec2>(&value)) {
+                if (uniformChanged(compiled, slot.location, &(*vec2f)[0], sizeof(glm::vec2))) {
+                    glUniform2fv(slot.location, 1, &(*vec2f)[0]);
                 }
             }
-            else if (uniform.type == UniformType::Vec3i) {
-                if (std::holds_alternative<glm::ivec3>(uniform.value)) {
-                    glm::ivec3 vec3 = std::get<glm::ivec3>(uniform.value);
-                    glUniform3iv(location, 1, &vec3[0]);
-                } else {
-                    std::cerr << "Vec3i 类型的 uniform \"" << uniformName << "\" 的值类型不正确。" << std::endl;
+            break;
+        case UniformType::Int:
+            if (auto iv = std::get_if<int>(&value)) {
+                if (uniformChanged(compiled, slot.location, iv, sizeof(int))) {
+                    glUniform1i(slot.location, *iv);
                 }
             }
-            else if (uniform.type == UniformType::Vec3f) {
-                if (std::holds_alternative<glm::vec3>(uniform.value)) {
-                    glm::vec3 vec3f = std::get<glm::vec3>(uniform.value);
-                    glUniform3fv(location, 1, &vec3f[0]);
-                } else {
-                    std::cerr << "Vec3f 类型的 uniform \"" << uniformName << "\" 的值类型不正确。" << std::endl;
+            break;
+        case UniformType::Vec2i:
+            if (auto vec2 = std::get_if<glm::ivec2>(&value)) {
+                if (uniformChanged(compiled, slot.location, &(*vec2)[0], sizeof(glm::ivec2))) {
+                    glUniform2iv(slot.location, 1, &(*vec2)[0]);
                 }
             }
-            
-            else {
-                std::cerr << "不支持的 uniform 类型 \"" << uniform.type << "\"，uniform \"" << uniformName << "\" 在 pass \"" << pass->passName << "\"" << std::endl;
+            break;
+        case UniformType::Vec3i:
+            if (auto vec3 = std::get_if<glm::ivec3>(&value)) {
+                if (uniformChanged(compiled, slot.location, &(*vec3)[0], sizeof(glm::ivec3))) {
+                    glUniform3iv(slot.location, 1, &(*vec3)[0]);
+                }
+            }
+            break;
+        case UniformType::Vec3f:
+            if (auto vec3f = std::get_if<glm::vec3>(&value)) {
+                if (uniformChanged(compiled, slot.location, &(*vec3f)[0], sizeof(glm::vec3))) {
+                    glUniform3fv(slot.location, 1, &(*vec3f)[0]);
+                }
             }
+            break;
+        default:
+            break;
         }
     }
 
-    {
-            // ScopedProfiler profilerVideoResource("glDrawArrays" + pass->passName);
-
-            if (pass->clearColor != nullptr) {
-                glClearColor(pass->clearColor[0], pass->clearColor[1], pass->clearColor[2], pass->clearColor[3]);
+    // uniform 块：先比较 CPU 端数据，只有变化的块才重新上传
+    for (auto& compiledBlock : compiled.blocks) {
+        for (const auto& member : compiledBlock.members) {
+            size_t size = 0;
+            const void* data = uniformData(*member.value, member.type, size);
+            if (data) {
+                compiledBlock.block->write(member.offset, data, size);
             }
-            if (pass->clear != std::numeric_limits<unsigned int>::max())
-            {
-                glClear(pass->clear);
-            }
-            // 绘制
-            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+        compiledBlock.block->bind(compiledBlock.binding);
     }
 
+    if (pass.clearColor != nullptr) {
+        state.clearColor(pass.clearColor[0], pass.clearColor[1], pass.clearColor[2], pass.clearColor[3]);
+    }
+    if (pass.clear != std::numeric_limits<unsigned int>::max())
     {
-        // ScopedProfiler profilerVideoResource("unbind " + pass->passName);
-
-        // 解绑
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glUseProgram(0);
+        glClear(pass.clear);
     }
-}
\ No newline at end of file
+    // 绘制
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
@@ -4,15 +4,22 @@
 #define RENDERPASS_H
 
 #include <glad/glad.h>
+#include <array>
+#include <cstdint>
 #include <map>
 #include <string>
 #include <set>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <memory>
 #include "ShaderManager.h"
 #include "RenderTargetPool.h"
 #include "Materials.h"
 #include "VideoRenderer.h"
+#include "StandBatchRenderer.h"
+#include "UniformBlock.h"
 
 class RenderPass {
 public:
@@ -21,18 +28,163 @@ public:
 
     void render(std::vector<std::shared_ptr<Material>>& videoRendererMaterials, bool isRelease = true);
 
+    // 丢弃全部编译结果和 VAO；材质、顶点缓冲或着色器程序整体重建（UpdateTracks）时调用
+    void clearCompiledPasses();
+
+    // 每帧渲染前设置 FrameUniforms 块的内容，值不变时不会重新上传
+    void setFrameData(const UniformBlock::FrameData& frameData);
+
+    // 输出复用上一帧结果而跳过的 pass 数和实际绘制的 pass 数，之后重新统计
+    void logMemoizationReport();
+
     // std::shared_ptr<RenderTargetPool> getRenderTargetPool() { return renderTargetPool; };
 private:
-    void renderPass(std::shared_ptr<Material> pass, std::set<std::string>& renderedSet);
-    void renderSinglePass(std::shared_ptr<Material> pass);
+    // 缓存渲染目标在池中的键，RenderTargetInfo 不变时不再拼接字符串
+    struct RenderTargetKey {
+        std::string infoName;
+        int width = -1;
+        int height = -1;
+        std::string name;
+
+        // 返回键是否变化
+        bool resolve(const RenderTargetInfo& renderTargetInfo);
+    };
+
+    // 每个 uniform 编译后的槽位，value 指向 Material::uniforms 中的节点（uniforms 只增不删，节点地址稳定）
+    struct CompiledUniform {
+        const UniformValue* value = nullptr;
+        UniformType type = UniformType::Int;
+        GLint location = -1;
+        GLint textureUnit = -1;
+        const Material* dependency = nullptr;
+        RenderTargetKey renderTarget;
+    };
+
+    // 上一次上传到某个程序某个 location 的值，值没有变化时跳过 glUniform*
+    struct UniformShadow {
+        bool valid = false;
+        std::array<float, 16> data;
+    };
+
+    // Stand 材质用到的 uniform，合批时直接读取（相机矩阵来自 FrameUniforms 块）
+    struct StandUniforms {
+        const UniformValue* texture = nullptr;
+        const UniformValue* modelMatrix = nullptr;
+        const UniformValue* color = nullptr;
+    };
+
+    // 着色器中 FrameUniforms 以外的 uniform 块，每个 pass 各有一份缓冲，材质中同名 uniform 写入块内对应偏移
+    struct BlockMember {
+        const UniformValue* value = nullptr;
+        UniformType type = UniformType::Int;
+        GLint offset = 0;
+    };
+    struct CompiledBlock {
+        std::unique_ptr<UniformBlock> block;
+        GLuint binding = 0;
+        std::vector<BlockMember> members;
+    };
+
+    // 单个 pass 的编译结果：程序、VAO、uniform location 和纹理单元都在编译时确定
+    struct CompiledPass {
+        Material* material = nullptr;
+        std::weak_ptr<Material> owner;
+        GLuint program = 0;
+        GLuint attributeBuffer = 0;
+        GLuint vertexArray = 0;
+        int nameId = -1;
+        std::vector<CompiledUniform> uniforms;
+        std::vector<UniformShadow>* shadow = nullptr;
+        std::vector<CompiledBlock> blocks;
+        // 着色器实际用到的 FrameUniforms 成员 (偏移, 字节数)，计算内容哈希时只统计这些
+        std::vector<std::pair<GLint, GLint>> frameMembers;
+        RenderTargetKey renderTarget;
+        // 只使用 Stand 着色器、纹理来自 Texture2D 且不清屏的 pass 可以和相邻的同类 pass 合批
+        bool batchable = false;
+        StandUniforms stand;
+        // 本帧获取到的渲染目标，供依赖它的 pass 直接使用
+        std::shared_ptr<RenderTarget> frameRenderTarget;
+        std::uint64_t frameStamp = 0;
+        // 内容哈希：程序、目标尺寸、uniform 值、输入纹理版本和依赖 pass 的输出哈希
+        std::uint64_t contentHash = 0;
+        // 不含 FrameUniforms 的部分，用于检查帧数据是否破坏了复用
+        std::uint64_t inputHash = 0;
+        // 连续两帧哈希相同且独占渲染目标时保留输出，之后哈希不变就不再绘制
+        bool retained = false;
+        // 最近一次绘制时的哈希和保留目标编号
+        std::uint64_t memoHash = 0;
+        std::uint64_t memoRetainedId = 0;
+    };
+
+    // 以某个材质为根、按依赖拓扑排序的绘制列表
+    struct DrawList {
+        std::weak_ptr<Material> root;
+        std::uint64_t generation = 0;
+        std::vector<CompiledPass*> order;
+    };
+
+    DrawList& getDrawList(const std::shared_ptr<Material>& material);
+    void buildDrawList(const std::shared_ptr<Material>& material, std::vector<CompiledPass*>& order, std::set<Material*>& visited, std::set<Material*>& visiting);
+    CompiledPass& getCompiledPass(const std::shared_ptr<Material>& material);
+    bool isCompiledPassValid(const CompiledPass& compiled) const;
+    void compilePass(CompiledPass& compiled, const std::shared_ptr<Material>& material);
+    // 查询程序的 uniform 块：FrameUniforms 指定到公共绑定点，其余的为该 pass 创建缓冲；返回所有块成员名到 (块序号, 偏移) 的映射，FrameUniforms 成员的块序号为 -1
+    std::unordered_map<std::string, std::pair<int, GLint>> compileUniformBlocks(CompiledPass& compiled);
+    // uniform 值的原始数据，纹理类和不支持的类型返回 nullptr
+    static const void* uniformData(const UniformValue& uniform, UniformType type, size_t& size);
+    // std140 块成员类型的字节数
+    static GLint uniformTypeSize(GLenum type);
+    GLuint getVertexArray(GLuint attributeBuffer, GLint positionLocation, GLint texCoordLocation);
+    std::shared_ptr<RenderTarget> acquireDependency(const Material* dependency);
+    bool uniformChanged(CompiledPass& compiled, GLint location, const void* data, size_t size);
+    void renderSinglePass(CompiledPass& compiled);
+    // 从 framePasses[first] 开始收集连续可合批的 Stand pass 并一次绘制，返回绘制的 pass 数；不足两个时返回 0
+    size_t renderStandBatch(size_t first);
+    // 绑定 pass 的渲染目标并记录为本帧结果
+    std::shared_ptr<RenderTarget> bindRenderTarget(CompiledPass& compiled);
+    // 统计本帧每个逻辑渲染目标的第一次和最后一次使用，交给渲染目标池做别名分配
+    void planRenderTargets();
+    // 按本帧顺序计算每个 pass 的内容哈希并决定哪些 pass 保留输出，返回保留集合是否变化
+    bool updateContentHashes();
+    // 保留的输出仍然有效时直接作为本帧结果，返回 true 表示不必绘制
+    bool reuseRetainedResult(CompiledPass& compiled);
+    // 绘制完成后记录哈希，保留的 pass 下一帧可以复用
+    void recordResult(CompiledPass& compiled);
 
     std::shared_ptr<ShaderManager> shaderManager;
     GLuint width;
     GLuint height;
     // std::shared_ptr<RenderTargetPool> renderTargetPool;
     RenderTargetPool& renderTargetPool;
-    std::map<std::string, GLuint> programCache;
-    std::set<std::string> renderedSet; // 防止重复渲染
+    StandBatchRenderer standBatch;
+    std::unique_ptr<UniformBlock> frameBlock;
+    UniformBlock::FrameData frameData{};
+    std::vector<StandBatchRenderer::Instance> batchInstances;
+    std::vector<GLuint> batchTextures;
+
+    std::unordered_map<const Material*, CompiledPass> compiledPasses;
+    std::unordered_map<const Material*, DrawList> drawLists;
+    std::map<std::tuple<GLuint, GLint, GLint>, GLuint> vertexArrays;
+    std::unordered_map<GLuint, std::vector<UniformShadow>> programUniforms;
+    // passName 映射为整数，逐帧按名字去重时不再比较字符串（防止重复渲染）
+    std::unordered_map<std::string, int> passNameIds;
+    std::vector<std::uint64_t> renderedStamps;
+    std::uint64_t frameStamp = 0;
+    // 本帧按顺序渲染的 pass；与上一次做计划时相同且渲染目标未变化时沿用原计划
+    std::vector<CompiledPass*> framePasses;
+    std::vector<CompiledPass*> plannedPasses;
+    std::uint64_t planGeneration = 0;
+    std::vector<RenderTargetUse> renderTargetUses;
+    // 本帧计算内容哈希用：每个逻辑渲染目标当前内容的哈希、写入它的 pass 数、已经读写过的目标
+    std::unordered_map<std::string, std::uint64_t> targetHashes;
+    std::unordered_map<std::string, int> targetWriters;
+    std::unordered_set<std::string> touchedTargets;
+    std::uint64_t memoHits = 0;
+    std::uint64_t memoDraws = 0;
+    // 材质输入不变、只因 FrameUniforms 变化而哈希改变的次数，应当始终为 0
+    std::uint64_t frameDataInvalidations = 0;
+    // 任意 pass 的依赖关系变化时递增，绘制列表据此判断是否需要重新排序
+    std::uint64_t generation = 1;
 };
 
-#endif // RENDERPASS_H
\ No newline at end of file
+#endif // RENDERPASS_H
@@ -1,8 +1,10 @@
 // RenderTargetPool.cpp
 
 #include "RenderTargetPool.h"
+#include <algorithm>
 #include <iostream>
 #include "ScopedProfiler.h"
+#include "GLStateCache.h"
 
 
 
@@ -19,11 +21,22 @@ void RenderTargetPool::initialize(
     GLuint defaultFramebuffer
 )
 {
+    // 重新初始化（画布尺寸变化）时，旧的默认渲染目标指向的帧缓冲已经由 Engine 销毁，只需移除引用
+    if (!defaultRenderTargetInfoName.empty())
+    {
+        inUse.erase(defaultRenderTargetInfoName);
+    }
+
     this->width = width;
     this->height = height;
     this->defaultRenderTargetInfo = defaultRenderTargetInfo;
     this->defaultFramebuffer = defaultFramebuffer;
-    defaultRenderTargetInfoName = defaultRenderTargetInfo.name + "_" + std::to_string(defaultRenderTargetInfo.width) + "x" + std::to_string(defaultRenderTargetInfo.height);
+    defaultRenderTargetInfoName = makeRenderTargetName(defaultRenderTargetInfo);
+
+    defaultRenderTarget = std::make_shared<RenderTarget>();
+    defaultRenderTarget->framebuffer = defaultFramebuffer;
+    defaultRenderTarget->texture = -1;
+    defaultRenderTarget->depthStencilRBO = -1;
 }
 
 
@@ -31,11 +44,144 @@ RenderTargetPool::~RenderTargetPool() {
     reset();
 }
 
+std::string RenderTargetPool::makeRenderTargetName(const RenderTargetInfo& renderTargetInfo) {
+    return renderTargetInfo.name + "_" + std::to_string(renderTargetInfo.width) + "x" + std::to_string(renderTargetInfo.height);
+}
+
 std::shared_ptr<RenderTarget> RenderTargetPool::acquire(const RenderTargetInfo& renderTargetInfo, bool hasDepthStencil) {
-    int widthTarget = renderTargetInfo.width;
-    int heightTarget = renderTargetInfo.height;
-    std::string renderTargetName = renderTargetInfo.name + "_" + std::to_string(widthTarget) + "x" + std::to_string(heightTarget);
+    return acquire(makeRenderTargetName(renderTargetInfo), renderTargetInfo.width, renderTargetInfo.height, hasDepthStencil);
+}
+
+// 物理目标空闲超过这么多帧后删除，避免尺寸变化后旧目标一直占用显存
+static const std::uint64_t kIdleFramesBeforeRelease = 60;
+
+std::size_t RenderTargetPool::renderTargetBytes(int width, int height, bool hasDepthStencil) {
+    // RGBA8 颜色 + 可选的 DEPTH24_STENCIL8
+    return static_cast<std::size_t>(width) * height * (hasDepthStencil ? 8 : 4);
+}
+
+// 宽高为 0 的目标使用画布尺寸（与 generateRenderTarget 一致）
+void RenderTargetPool::resolveSize(int& widthTarget, int& heightTarget) const {
+    if (widthTarget == 0 || heightTarget == 0) {
+        widthTarget = width;
+        heightTarget = height;
+    }
+}
+
+RenderTargetPool::PhysicalRenderTarget* RenderTargetPool::allocatePhysical(int widthTarget, int heightTarget, bool hasDepthStencil) {
+    auto rt = std::make_shared<RenderTarget>();
+    std::string renderTargetName = "physical_" + std::to_string(widthTarget) + "x" + std::to_string(heightTarget);
+    if (!generateRenderTarget(rt, widthTarget, heightTarget, renderTargetName, hasDepthStencil)) {
+        return nullptr;
+    }
+    auto physical = std::make_unique<PhysicalRenderTarget>();
+    physical->renderTarget = rt;
+    physical->width = widthTarget;
+    physical->height = heightTarget;
+    physical->hasDepthStencil = hasDepthStencil;
+    physical->lastUsedFrame = frameIndex;
+    physical->plannedUntil = -1;
+    physical->acquiredUnplanned = false;
+    physicalTargets.push_back(std::move(physical));
+    return physicalTargets.back().get();
+}
+
+void RenderTargetPool::deletePhysical(PhysicalRenderTarget& physical) {
+    GLStateCache::instance().deleteFramebuffers(1, &physical.renderTarget->framebuffer);
+    GLStateCache::instance().deleteTextures(1, &physical.renderTarget->texture);
+    if (physical.hasDepthStencil) {
+        glDeleteRenderbuffers(1, &physical.renderTarget->depthStencilRBO);
+    }
+}
+
+void RenderTargetPool::planFrame(const std::vector<RenderTargetUse>& uses) {
+    plannedTargets.clear();
+    for (auto& physical : physicalTargets) {
+        physical->plannedUntil = -1;
+    }
+
+    // 保留目标先分配：尺寸不变时沿用原来的物理目标，整帧占用，其它逻辑目标不能共用
+    std::unordered_map<std::string, RetainedTarget> previousRetained;
+    previousRetained.swap(retainedTargets);
+    std::vector<const RenderTargetUse*> newlyRetained;
+    for (const auto& use : uses) {
+        if (!use.retained || use.name == defaultRenderTargetInfoName || plannedTargets.count(use.name)) continue;
+        int widthTarget = use.width;
+        int heightTarget = use.height;
+        resolveSize(widthTarget, heightTarget);
+        auto previousIt = previousRetained.find(use.name);
+        if (previousIt != previousRetained.end() && previousIt->second.physical->width == widthTarget &&
+            previousIt->second.physical->height == heightTarget && previousIt->second.physical->hasDepthStencil == use.hasDepthStencil) {
+            previousIt->second.physical->plannedUntil = std::numeric_limits<int>::max();
+            plannedTargets[use.name] = previousIt->second.physical;
+            retainedTargets[use.name] = previousIt->second;
+        } else {
+            newlyRetained.push_back(&use);
+        }
+    }
+    for (const RenderTargetUse* use : newlyRetained) {
+        int widthTarget = use->width;
+        int heightTarget = use->height;
+        resolveSize(widthTarget, heightTarget);
+        PhysicalRenderTarget* chosen = nullptr;
+        for (auto& physical : physicalTargets) {
+            if (physical->width == widthTarget && physical->height == heightTarget &&
+                physical->hasDepthStencil == use->hasDepthStencil && physical->plannedUntil < 0) {
+                chosen = physical.get();
+                break;
+            }
+        }
+        if (!chosen) {
+            chosen = allocatePhysical(widthTarget, heightTarget, use->hasDepthStencil);
+            if (!chosen) continue;
+        }
+        chosen->plannedUntil = std::numeric_limits<int>::max();
+        plannedTargets[use->name] = chosen;
+        retainedTargets[use->name] = {chosen, ++nextRetainedId};
+    }
+
+    // 其余目标按第一次使用排序，贪心地复用已经结束生存期的物理目标
+    std::vector<const RenderTargetUse*> sorted;
+    sorted.reserve(uses.size());
+    for (const auto& use : uses) {
+        if (use.name != defaultRenderTargetInfoName && !plannedTargets.count(use.name)) {
+            sorted.push_back(&use);
+        }
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const RenderTargetUse* a, const RenderTargetUse* b) {
+        return a->firstUse < b->firstUse;
+    });
+
+    for (const RenderTargetUse* use : sorted) {
+        if (plannedTargets.count(use->name)) continue;
+        int widthTarget = use->width;
+        int heightTarget = use->height;
+        resolveSize(widthTarget, heightTarget);
+
+        PhysicalRenderTarget* chosen = nullptr;
+        for (auto& physical : physicalTargets) {
+            // 同一个 pass 既读旧目标又写新目标时不能共用，所以要求严格早于
+            if (physical->width == widthTarget && physical->height == heightTarget &&
+                physical->hasDepthStencil == use->hasDepthStencil && physical->plannedUntil < use->firstUse) {
+                chosen = physical.get();
+                break;
+            }
+        }
+        if (!chosen) {
+            chosen = allocatePhysical(widthTarget, heightTarget, use->hasDepthStencil);
+            if (!chosen) continue;
+        }
+        chosen->plannedUntil = use->lastUse;
+        plannedTargets[use->name] = chosen;
+    }
+}
 
+std::uint64_t RenderTargetPool::retainedId(const std::string& renderTargetName) const {
+    auto it = retainedTargets.find(renderTargetName);
+    return it != retainedTargets.end() ? it->second.id : 0;
+}
+
+std::shared_ptr<RenderTarget> RenderTargetPool::acquire(const std::string& renderTargetName, int widthTarget, int heightTarget, bool hasDepthStencil, bool clear) {
     // std::cerr << "RenderTargetPool::acquire renderTargetName: " << renderTargetName << std::endl;
 
     auto it = inUse.find(renderTargetName);
@@ -43,30 +189,52 @@ std::shared_ptr<RenderTarget> RenderTargetPool::acquire(const RenderTargetInfo&
         return it->second;
     }
 
-    auto poolIt = pool.find(renderTargetName);
-    if (poolIt != pool.end()) {
-        glBindFramebuffer(GL_FRAMEBUFFER, poolIt->second->framebuffer);
-        // 清除
-        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        
-        inUse[renderTargetName] = poolIt->second;
-        return poolIt->second;
-    }
-
-    auto rt = std::make_shared<RenderTarget>();
+    std::shared_ptr<RenderTarget> rt;
     if (renderTargetName == defaultRenderTargetInfoName)
     {
-        rt->framebuffer = defaultFramebuffer;
-        rt->texture = -1;
-        rt->depthStencilRBO = -1;
+        rt = defaultRenderTarget;
     }
-    else 
+    else
     {
-        if (!generateRenderTarget(rt, widthTarget, heightTarget, renderTargetName, hasDepthStencil)) {
-            // std::cerr << "创建渲染目标失败: " << renderTargetName << std::endl;
-            return nullptr;
+        resolveSize(widthTarget, heightTarget);
+
+        PhysicalRenderTarget* physical = nullptr;
+        auto plannedIt = plannedTargets.find(renderTargetName);
+        if (plannedIt != plannedTargets.end() && plannedIt->second->width == widthTarget &&
+            plannedIt->second->height == heightTarget && plannedIt->second->hasDepthStencil == hasDepthStencil) {
+            physical = plannedIt->second;
+        }
+        else
+        {
+            // 计划之外的目标只使用本帧计划和其它计划外获取都没有用到的物理目标
+            for (auto& candidate : physicalTargets) {
+                if (candidate->width == widthTarget && candidate->height == heightTarget && candidate->hasDepthStencil == hasDepthStencil &&
+                    candidate->plannedUntil < 0 && !candidate->acquiredUnplanned) {
+                    physical = candidate.get();
+                    break;
+                }
+            }
+            if (!physical) {
+                physical = allocatePhysical(widthTarget, heightTarget, hasDepthStencil);
+                if (!physical) {
+                    // std::cerr << "创建渲染目标失败: " << renderTargetName << std::endl;
+                    return nullptr;
+                }
+            }
+            physical->acquiredUnplanned = true;
         }
+
+        physical->lastUsedFrame = frameIndex;
+        frameLogicalBytes += renderTargetBytes(widthTarget, heightTarget, hasDepthStencil);
+        rt = physical->renderTarget;
+    }
+
+    // 物理目标可能刚被其它逻辑目标用过，逻辑目标第一次获取时清空
+    if (clear) {
+        GLStateCache& state = GLStateCache::instance();
+        state.bindFramebuffer(GL_FRAMEBUFFER, rt->framebuffer);
+        state.clearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     }
 
     inUse[renderTargetName] = rt;
@@ -106,7 +274,8 @@ bool RenderTargetPool::generateRenderTarget(std::shared_ptr<RenderTarget> rt, in
         // ScopedProfiler profiler("RenderTargetPool::generateRenderTarget glGenFramebuffers");
         glGenFramebuffers(1, &rt->framebuffer);
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, rt->framebuffer);
+    GLStateCache& state = GLStateCache::instance();
+    state.bindFramebuffer(GL_FRAMEBUFFER, rt->framebuffer);
 
     {
         // ScopedProfiler profiler("RenderTargetPool::generateRenderTarget glGenTextures");
@@ -115,7 +284,7 @@ bool RenderTargetPool::generateRenderTarget(std::shared_ptr<RenderTarget> rt, in
 
     // std::cerr << "glGenTexture id: " << rt->texture << std::endl;
 
-    glBindTexture(GL_TEXTURE_2D, rt->texture);
+    state.bindTexture(rt->texture);
     if (widthTarget == 0 || heightTarget == 0)
     {
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
@@ -157,20 +326,18 @@ bool RenderTargetPool::generateRenderTarget(std::shared_ptr<RenderTarget> rt, in
 
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
         std::cerr << "Framebuffer 不完整，无法创建用于 renderTargetName: " << renderTargetName << std::endl;
-        glDeleteFramebuffers(1, &rt->framebuffer);
-        glDeleteTextures(1, &rt->texture);
+        GLStateCache::instance().deleteFramebuffers(1, &rt->framebuffer);
+        GLStateCache::instance().deleteTextures(1, &rt->texture);
 
         if (hasDepthStencil)
         {
             glDeleteRenderbuffers(1, &rt->depthStencilRBO);
         }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
         return false;
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
+    // 不再解绑：调用方随后总会绑定自己需要的帧缓冲
     return true;
 }
 
@@ -187,41 +354,69 @@ std::shared_ptr<RenderTarget> RenderTargetPool::getInUseRenderTarget(const Rende
     return nullptr;
 }
 
-void RenderTargetPool::release(const std::string& renderTargetName) {
-    auto it = inUse.find(renderTargetName);
-    if (it != inUse.end()) {
-        pool[renderTargetName] = it->second;
-        inUse.erase(it);
+void RenderTargetPool::releaseUnused() {
+    inUse.clear();
+
+    std::size_t physicalBytes = 0;
+    for (auto it = physicalTargets.begin(); it != physicalTargets.end();) {
+        PhysicalRenderTarget& physical = **it;
+        physical.acquiredUnplanned = false;
+        if (physical.plannedUntil < 0 && frameIndex - physical.lastUsedFrame > kIdleFramesBeforeRelease) {
+            deletePhysical(physical);
+            it = physicalTargets.erase(it);
+            continue;
+        }
+        physicalBytes += renderTargetBytes(physical.width, physical.height, physical.hasDepthStencil);
+        ++it;
     }
+
+    peakLogicalBytes = std::max(peakLogicalBytes, frameLogicalBytes);
+    peakPhysicalBytes = std::max(peakPhysicalBytes, physicalBytes);
+    frameLogicalBytes = 0;
+    frameIndex++;
 }
 
-void RenderTargetPool::releaseUnused() {
-    for (auto it = inUse.begin(); it != inUse.end();) {
-        release(it->first);
-        it = inUse.begin();
+void RenderTargetPool::logMemoryReport() {
+    std::size_t cachedBytes = 0;
+    for (const auto& [key, rt] : renderTargetPool) {
+        int cachedWidth = static_cast<int>(key >> 32);
+        int cachedHeight = static_cast<int>((key >> 1) & 0x7FFFFFFF);
+        cachedBytes += renderTargetBytes(cachedWidth, cachedHeight, (key & 1) != 0);
     }
+
+    auto toMB = [](std::size_t bytes) { return bytes / (1024.0 * 1024.0); };
+    std::clog << "渲染目标显存峰值: 不共用 " << toMB(peakLogicalBytes) << " MB, 共用后 " << toMB(peakPhysicalBytes)
+              << " MB (" << physicalTargets.size() << " 个物理目标), 文本缓存 " << toMB(cachedBytes) << " MB" << std::endl;
+
+    peakLogicalBytes = 0;
+    peakPhysicalBytes = 0;
 }
 
-void RenderTargetPool::reset() {
+void RenderTargetPool::releaseCachedRenderTargets() {
     auto max = std::numeric_limits<GLuint>::max();
-
-    // 清空池
-    for (auto& pair : pool) {
-        glDeleteFramebuffers(1, &pair.second->framebuffer);
-        glDeleteTextures(1, &pair.second->texture);
-        if (pair.second->depthStencilRBO != max) {
-            glDeleteRenderbuffers(1, &pair.second->depthStencilRBO);
+    for (auto it = renderTargetPool.begin(); it != renderTargetPool.end();) {
+        // 只有缓存自身持有的渲染目标才没有文本资源在使用
+        if (it->second.use_count() == 1) {
+            GLStateCache::instance().deleteFramebuffers(1, &it->second->framebuffer);
+            GLStateCache::instance().deleteTextures(1, &it->second->texture);
+            if (it->second->depthStencilRBO != max) {
+                glDeleteRenderbuffers(1, &it->second->depthStencilRBO);
+            }
+            it = renderTargetPool.erase(it);
+        } else {
+            ++it;
         }
     }
-    pool.clear();
+}
 
-    // 清空正在使用的渲染目标
-    for (auto& pair : inUse) {
-        glDeleteFramebuffers(1, &pair.second->framebuffer);
-        glDeleteTextures(1, &pair.second->texture);
-        if (pair.second->depthStencilRBO != max) {
-            glDeleteRenderbuffers(1, &pair.second->depthStencilRBO);
-        }
+void RenderTargetPool::reset() {
+    // 默认渲染目标的帧缓冲属于 Engine，不在这里删除
+    for (auto& physical : physicalTargets) {
+        deletePhysical(*physical);
     }
+    physicalTargets.clear();
+    plannedTargets.clear();
+    retainedTargets.clear();
     inUse.clear();
+    frameLogicalBytes = 0;
 }
@@ -5,6 +5,7 @@
 
 #include <glad/glad.h>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <string>
 #include <memory>
@@ -46,6 +47,18 @@ struct hash<RenderTarget>
 }
 
 
+// 一帧内对某个逻辑渲染目标的使用区间（按本帧 pass 顺序编号），用于别名分配
+struct RenderTargetUse {
+    std::string name;
+    int width;
+    int height;
+    bool hasDepthStencil;
+    int firstUse;
+    int lastUse;
+    // 内容跨帧保留：分配独占的物理目标，不参与别名
+    bool retained = false;
+};
+
 class RenderTargetPool {
 public:
     static RenderTargetPool& instance();    // 引用，不再是 shared_ptr
@@ -64,11 +77,25 @@ public:
     // RenderTargetPool(const RenderTargetPool&) = delete;
     RenderTargetPool& operator=(const RenderTargetPool&) = delete;
 
+    // 按本帧各逻辑渲染目标的生存区间分配物理目标：尺寸、格式、深度相同且区间不重叠的逻辑目标共用同一个 FBO 和纹理
+    // pass 顺序不变时计划可以跨帧沿用，不必每帧调用
+    void planFrame(const std::vector<RenderTargetUse>& uses);
 
+    // 逻辑目标在一帧内第一次获取时会被清空（clear 为 false 时保留原内容）；计划之外的目标分配一个本帧计划没有用到的物理目标
     std::shared_ptr<RenderTarget> acquire(const RenderTargetInfo& renderTargetInfo, bool hasDepthStencil = false);
-    void release(const std::string& renderTargetName);
+    // renderTargetName 为 makeRenderTargetName 的结果，逐帧调用时可以缓存下来避免重复拼接字符串
+    std::shared_ptr<RenderTarget> acquire(const std::string& renderTargetName, int widthTarget, int heightTarget, bool hasDepthStencil = false, bool clear = true);
+    // 保留目标当前绑定的物理目标编号，每次重新分配都会换一个新编号；不是保留目标时返回 0
+    // 编号不变说明上一帧写入的内容仍在
+    std::uint64_t retainedId(const std::string& renderTargetName) const;
+    static std::string makeRenderTargetName(const RenderTargetInfo& renderTargetInfo);
+    // 帧结束：归还本帧获取的全部目标，并删除长时间没有用到的物理目标
     void releaseUnused();
     void reset();
+    // 删除 renderTargetPool 中已经没有文本资源引用的渲染目标
+    void releaseCachedRenderTargets();
+    // 输出别名前后的渲染目标显存峰值，之后重新统计
+    void logMemoryReport();
 
     std::shared_ptr<RenderTarget> getInUseRenderTarget(const RenderTargetInfo& renderTargetInfo); // 添加访问器
 
@@ -87,13 +114,48 @@ private:
 
     // 构造函数和析构函数设为私有
 
+    // 实际占用显存的渲染目标
+    struct PhysicalRenderTarget {
+        std::shared_ptr<RenderTarget> renderTarget;
+        int width;
+        int height;
+        bool hasDepthStencil;
+        std::uint64_t lastUsedFrame;
+        // 本帧计划中分配到它的逻辑目标最后一次使用的位置，-1 表示计划没有用到
+        int plannedUntil;
+        // 已被计划外的获取占用
+        bool acquiredUnplanned;
+    };
+
+    PhysicalRenderTarget* allocatePhysical(int width, int height, bool hasDepthStencil);
+    void deletePhysical(PhysicalRenderTarget& physical);
+    void resolveSize(int& widthTarget, int& heightTarget) const;
+    static std::size_t renderTargetBytes(int width, int height, bool hasDepthStencil);
+
     GLuint width;
     GLuint height;
     RenderTargetInfo defaultRenderTargetInfo;
     std::string defaultRenderTargetInfoName;
     GLuint defaultFramebuffer;
-    std::map<std::string, std::shared_ptr<RenderTarget>> pool;
+    std::shared_ptr<RenderTarget> defaultRenderTarget;
+
+    // 物理目标用 unique_ptr 保存，计划中的指针在增删时保持有效
+    std::vector<std::unique_ptr<PhysicalRenderTarget>> physicalTargets;
+    std::unordered_map<std::string, PhysicalRenderTarget*> plannedTargets;
+    // 保留目标跨计划沿用同一个物理目标
+    struct RetainedTarget {
+        PhysicalRenderTarget* physical;
+        std::uint64_t id;
+    };
+    std::unordered_map<std::string, RetainedTarget> retainedTargets;
+    std::uint64_t nextRetainedId = 0;
     std::map<std::string, std::shared_ptr<RenderTarget>> inUse;
+    std::uint64_t frameIndex = 0;
+
+    // 显存统计（字节）：不做别名时各逻辑目标的总和与实际物理目标的总和
+    std::size_t frameLogicalBytes = 0;
+    std::size_t peakLogicalBytes = 0;
+    std::size_t peakPhysicalBytes = 0;
     // 静态成员变量存储实例
     // static std::shared_ptr<RenderTargetPool> instance;
     // static std::once_flag initFlag;
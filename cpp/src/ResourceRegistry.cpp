@@ -0,0 +1,102 @@
+// ResourceRegistry.cpp
+
+#include "ResourceRegistry.h"
+#include <algorithm>
+#include <iostream>
+
+bool ResourceRegistry::VideoUsage::sameTimeline(const VideoUsage& other) const {
+    return offset == other.offset && rate == other.rate &&
+           originalStart == other.originalStart && originalDuration == other.originalDuration;
+}
+
+bool ResourceRegistry::VideoUsage::overlaps(const VideoUsage& other) const {
+    return start <= other.end && other.start <= end;
+}
+
+ResourceRegistry::VideoUsage ResourceRegistry::VideoUsage::fromSequence(const nlohmann::json& sequence, double leadIn, double tail) {
+    VideoUsage usage;
+    const auto& timer = sequence["timer"];
+    usage.offset = timer.value("offset", 0.0);
+    usage.rate = timer.value("rate", 1.0);
+    usage.originalDuration = timer.value("originalDuration", 0.0);
+    usage.originalStart = timer.value("start", 0.0) * usage.originalDuration;
+    double trimmedDuration = timer.value("duration", 0.0) * (usage.originalDuration / (usage.rate > 0.0 ? usage.rate : 1.0));
+    usage.start = usage.offset - leadIn;
+    usage.end = usage.offset + trimmedDuration + tail;
+    return usage;
+}
+
+ResourceRegistry::ResourceRegistry(VideoFactory videoFactory)
+    : videoFactory(std::move(videoFactory)) {
+}
+
+void ResourceRegistry::addReusable(std::shared_ptr<VideoResource> resource) {
+    reusableVideos.emplace(resource->getFilePath(), std::move(resource));
+}
+
+std::shared_ptr<VideoResource> ResourceRegistry::acquireVideo(const std::string& path, int rotate, const VideoUsage& usage) {
+    videoRequests++;
+    auto range = videos.equal_range(path);
+    for (auto it = range.first; it != range.second; ++it) {
+        VideoEntry& entry = it->second;
+        if (entry.rotate != rotate) {
+            continue;
+        }
+        // 与已有的每个片段要么请求相同的源时间，要么不会同时需要画面
+        bool compatible = std::all_of(entry.usages.begin(), entry.usages.end(), [&](const VideoUsage& other) {
+            return usage.sameTimeline(other) || !usage.overlaps(other);
+        });
+        if (compatible) {
+            entry.usages.push_back(usage);
+            return entry.resource;
+        }
+    }
+
+    VideoEntry entry;
+    entry.rotate = rotate;
+    auto reusable = reusableVideos.find(path);
+    if (reusable != reusableVideos.end()) {
+        entry.resource = reusable->second;
+        reusableVideos.erase(reusable);
+    } else {
+        entry.resource = videoFactory(path);
+    }
+    entry.usages.push_back(usage);
+    std::shared_ptr<VideoResource> resource = entry.resource;
+    videos.emplace(path, std::move(entry));
+    return resource;
+}
+
+std::shared_ptr<ImageResource> ResourceRegistry::acquireImage(const std::string& path) {
+    imageRequests++;
+    auto it = images.find(path);
+    if (it != images.end()) {
+        return it->second;
+    }
+    auto resource = std::make_shared<ImageResource>(path);
+    images.emplace(path, resource);
+    return resource;
+}
+
+void ResourceRegistry::discard(const std::shared_ptr<RendererResource>& resource) {
+    for (auto it = videos.begin(); it != videos.end(); ++it) {
+        if (it->second.resource == resource) {
+            videos.erase(it);
+            return;
+        }
+    }
+    for (auto it = images.begin(); it != images.end(); ++it) {
+        if (it->second == resource) {
+            images.erase(it);
+            return;
+        }
+    }
+}
+
+void ResourceRegistry::logStats() const {
+    if (videoRequests == 0 && imageRequests == 0) {
+        return;
+    }
+    std::clog << "共享资源: 视频片段 " << videoRequests << " 个使用 " << videos.size() << " 个解码器, 图片片段 "
+              << imageRequests << " 个使用 " << images.size() << " 个纹理" << std::endl;
+}
@@ -0,0 +1,67 @@
+// ResourceRegistry.h
+
+#ifndef RESOURCEREGISTRY_H
+#define RESOURCEREGISTRY_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../nlohmann/json.hpp"
+#include "ImageResource.h"
+#include "VideoResource.h"
+
+// 一次 UpdateTracks 内按内容共享图片和视频资源，模板里重复使用的背景视频、Logo 不再各自打开解码器、各自持有纹理
+// 图片按路径共享一个纹理；视频按（路径, 旋转）分组，组内的片段在每个时刻请求的源时间都相同，
+// 或者需要画面的时间区间互不重叠时共用一个解码器，只有同时可见且请求不同源时间的片段才分到新的解码器
+class ResourceRegistry {
+public:
+    // 片段对视频的使用方式，时间单位为毫秒，与 TrackModel 一致
+    struct VideoUsage {
+        double offset = 0.0;            // timer.offset
+        double rate = 1.0;              // timer.rate
+        double originalStart = 0.0;     // start * originalDuration
+        double originalDuration = 0.0;  // timer.originalDuration
+        // 需要画面的全局时间区间：可见区间向两端扩展相邻转场的时长
+        double start = 0.0;
+        double end = 0.0;
+
+        // 两个片段在同一时刻请求的源时间相同（TrackModel::getOriginalTime 的参数一致）
+        bool sameTimeline(const VideoUsage& other) const;
+        bool overlaps(const VideoUsage& other) const;
+
+        // leadIn、tail 为片段前后转场的时长
+        static VideoUsage fromSequence(const nlohmann::json& sequence, double leadIn, double tail);
+    };
+
+    using VideoFactory = std::function<std::shared_ptr<VideoResource>(const std::string& path)>;
+
+    explicit ResourceRegistry(VideoFactory videoFactory);
+
+    // 上一个任务留下的视频资源（常驻服务模式），新建解码器前先按路径取用
+    void addReusable(std::shared_ptr<VideoResource> resource);
+
+    std::shared_ptr<VideoResource> acquireVideo(const std::string& path, int rotate, const VideoUsage& usage);
+    std::shared_ptr<ImageResource> acquireImage(const std::string& path);
+    // 初始化失败的资源不再分给后面的片段
+    void discard(const std::shared_ptr<RendererResource>& resource);
+
+    void logStats() const;
+
+private:
+    struct VideoEntry {
+        int rotate = 0;
+        std::shared_ptr<VideoResource> resource;
+        std::vector<VideoUsage> usages;
+    };
+
+    VideoFactory videoFactory;
+    std::multimap<std::string, VideoEntry> videos;
+    std::map<std::string, std::shared_ptr<ImageResource>> images;
+    std::multimap<std::string, std::shared_ptr<VideoResource>> reusableVideos;
+    size_t videoRequests = 0;
+    size_t imageRequests = 0;
+};
+
+#endif // RESOURCEREGISTRY_H
@@ -3,7 +3,7 @@
 thread_local int currentIndent = 0;
 
 ScopedProfiler::ScopedProfiler(const string &funcName): funcName(funcName), indent(currentIndent), start(steady_clock::now()) {
-    cout << string(indent * 2, ' ') << "进入 " << funcName << endl;
+    clog << string(indent * 2, ' ') << "进入 " << funcName << endl;
     // 进入方法后增加缩进级别
     ++currentIndent;
 }
@@ -12,5 +12,5 @@ ScopedProfiler::~ScopedProfiler() {
     --currentIndent;
     auto end = steady_clock::now();
     auto duration = duration_cast<microseconds>(end - start).count();
-    cout << string(indent * 2, ' ') << "退出 " << funcName << ", 耗时: " << duration/1000.0f << " 毫秒" << endl;
+    clog << string(indent * 2, ' ') << "退出 " << funcName << ", 耗时: " << duration/1000.0f << " 毫秒" << endl;
 }
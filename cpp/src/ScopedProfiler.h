@@ -12,6 +12,7 @@ using namespace std::chrono;
 // 使用 thread_local 变量记录当前的调用缩进级别（多线程环境下不会冲突）
 extern thread_local int currentIndent;
 
+// 耗时信息写到 std::clog：--server 模式下 std::cout 只承载每行一个任务结果的 JSON
 class ScopedProfiler {
 public:
     // 构造函数中记录进入方法的时间，同时输出进入信息
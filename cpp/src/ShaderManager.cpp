@@ -1,7 +1,15 @@
 // ShaderManager.cpp
 
 #include "ShaderManager.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <set>
+#include <thread>
 
 // 声明嵌入数据
 extern std::map<std::string, struct EmbeddedFile> embedded_files;
@@ -16,12 +24,18 @@ ShaderManager::ShaderManager() {
 
 ShaderManager::~ShaderManager() {
     for (auto& pair : programCache) {
-        glDeleteProgram(pair.second);
+        if (pair.second) {
+            GLStateCache::instance().deleteProgram(pair.second);
+        }
     }
 }
 
 std::string ShaderManager::loadShaderFile(const std::string& path) {
     if (path.find(".glsl") == std::string::npos) {
+        if (!extendShaders.is_object() || !extendShaders.contains(path) || !extendShaders[path].is_string()) {
+            std::cerr << "没找到对应插件着色器：" << path << std::endl;
+            return "";
+        }
         return std::string("#version 330 core\n") + extendShaders[path].get<std::string>();
     }
 
@@ -36,78 +50,358 @@ std::string ShaderManager::loadShaderFile(const std::string& path) {
     return "";
 }
 
+// 只提交编译，不查询结果；查询 GL_COMPILE_STATUS 会阻塞到编译完成，放到 checkShader 中统一进行
 GLuint ShaderManager::compileShader(GLenum type, const std::string& source) {
     GLuint shader = glCreateShader(type);
     const GLchar* src = source.c_str();
     glShaderSource(shader, 1, &src, NULL);
     glCompileShader(shader);
+    return shader;
+}
 
+bool ShaderManager::checkShader(GLuint shader) {
     GLint compileStatus;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
     if (!compileStatus) {
         GLchar infoLog[512];
         glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
         std::cerr << "着色器编译失败：" << infoLog << std::endl;
-        glDeleteShader(shader);
-        return 0;
+        return false;
     }
-
-    return shader;
+    return true;
 }
 
+// 只提交链接，结果由 checkProgram 查询
 GLuint ShaderManager::createProgram(GLuint vertexShader, GLuint fragmentShader) {
     GLuint program = glCreateProgram();
     glAttachShader(program, vertexShader);
     glAttachShader(program, fragmentShader);
 
+    if (GLExtensions::hasProgramBinary && !binaryCacheDirectory.empty()) {
+        GLExtensions::programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
     glLinkProgram(program);
+    return program;
+}
 
+bool ShaderManager::checkProgram(GLuint program) {
     GLint linkStatus;
     glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
     if (!linkStatus) {
         GLchar infoLog[512];
         glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
         std::cerr << "程序链接失败：" << infoLog << std::endl;
-        glDeleteProgram(program);
-        return 0;
+        return false;
     }
-
-    return program;
+    return true;
 }
 
 GLuint ShaderManager::getProgram(const std::string& vertexShaderPath, const std::string& fragmentShaderPath) {
     std::string key = vertexShaderPath + "|" + fragmentShaderPath;
-    if (programCache.find(key) != programCache.end()) {
-        return programCache[key];
+    auto it = programCache.find(key);
+    if (it != programCache.end()) {
+        return it->second;
     }
 
-    std::string vertexSource = loadShaderFile(vertexShaderPath);
-    std::string fragmentSource = loadShaderFile(fragmentShaderPath);
+    // 没有预热到的程序在首次使用时单独准备；失败时缓存为 0，之后不再重试和重复报错
+    warmUp({{vertexShaderPath, fragmentShaderPath}});
+    it = programCache.find(key);
+    return it != programCache.end() ? it->second : 0;
+}
 
-    if (vertexSource.empty() || fragmentSource.empty()) {
-        return 0;
+void ShaderManager::warmUp(const std::vector<std::pair<std::string, std::string>>& programs) {
+    std::vector<PendingProgram> pending;
+    std::set<std::string> seen;
+    for (const auto& [vertexShaderPath, fragmentShaderPath] : programs) {
+        std::string key = vertexShaderPath + "|" + fragmentShaderPath;
+        if (programCache.count(key) || !seen.insert(key).second) {
+            continue;
+        }
+
+        PendingProgram item;
+        item.key = key;
+        item.vertexSource = loadShaderFile(vertexShaderPath);
+        item.fragmentSource = loadShaderFile(fragmentShaderPath);
+        if (item.vertexSource.empty() || item.fragmentSource.empty()) {
+            programCache[key] = 0;
+            continue;
+        }
+
+        item.hash = hashProgram(item.vertexSource, item.fragmentSource);
+        GLuint program = loadProgramBinary(item.hash);
+        if (program) {
+            programCache[key] = program;
+            continue;
+        }
+        pending.push_back(std::move(item));
+    }
+    if (pending.empty()) {
+        return;
+    }
+
+    // 先提交全部编译和链接，驱动可以在后台线程中同时处理
+    for (auto& item : pending) {
+        item.vertexShader = compileShader(GL_VERTEX_SHADER, item.vertexSource);
+        item.fragmentShader = compileShader(GL_FRAGMENT_SHADER, item.fragmentSource);
+        item.program = createProgram(item.vertexShader, item.fragmentShader);
+    }
+
+    // 再收集结果：驱动支持 parallel_shader_compile 时轮询 GL_COMPLETION_STATUS_KHR，先处理已经链接完的程序
+    // （写二进制缓存的磁盘 I/O 与其余程序的编译重叠），只在没有任何程序完成时让出线程；
+    // 不支持时按顺序查询，GL_LINK_STATUS 会阻塞到对应程序链接完成
+    std::vector<bool> finished(pending.size(), false);
+    size_t remaining = pending.size();
+    while (remaining > 0) {
+        bool progressed = false;
+        for (size_t i = 0; i < pending.size(); i++) {
+            if (finished[i]) {
+                continue;
+            }
+            if (GLExtensions::hasParallelShaderCompile) {
+                GLint completed = GL_FALSE;
+                glGetProgramiv(pending[i].program, GL_COMPLETION_STATUS_KHR, &completed);
+                if (!completed) {
+                    continue;
+                }
+            }
+            finishProgram(pending[i]);
+            finished[i] = true;
+            remaining--;
+            progressed = true;
+        }
+        if (!progressed) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// 链接成功时着色器状态不必再查；失败时再查着色器以输出编译日志
+void ShaderManager::finishProgram(PendingProgram& item) {
+    bool linked = checkProgram(item.program);
+    if (!linked) {
+        checkShader(item.vertexShader);
+        checkShader(item.fragmentShader);
     }
 
-    GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
-    GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+    glDeleteShader(item.vertexShader);
+    glDeleteShader(item.fragmentShader);
 
-    if (vertexShader == 0 || fragmentShader == 0) {
+    if (!linked) {
+        std::cerr << "无法创建着色器程序：" << item.key << std::endl;
+        glDeleteProgram(item.program);
+        programCache[item.key] = 0;
+        return;
+    }
+
+    programCache[item.key] = item.program;
+    saveProgramBinary(item.program, item.hash);
+}
+
+// ---------------- 程序二进制缓存 ----------------
+
+// 缓存文件格式：magic | version | hash | binaryFormat | length | binary
+static const char kBinaryCacheMagic[4] = {'E', 'S', 'P', 'B'};
+static const std::uint32_t kBinaryCacheVersion = 1;
+
+std::string ShaderManager::defaultBinaryCacheDirectory() {
+    std::error_code error;
+    std::filesystem::path tempDirectory = std::filesystem::temp_directory_path(error);
+    if (error) {
+        return "";
+    }
+    return (tempDirectory / "EngineCpp" / "shader-cache").string();
+}
+
+void ShaderManager::setBinaryCacheDirectory(const std::string& directory) {
+    binaryCacheDirectory = directory;
+    if (binaryCacheDirectory.empty()) {
+        return;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(binaryCacheDirectory, error);
+    if (error) {
+        std::cerr << "无法创建着色器缓存目录 " << binaryCacheDirectory << ": " << error.message() << std::endl;
+        binaryCacheDirectory.clear();
+    }
+}
+
+// 源码和驱动信息一起参与哈希，驱动升级或换卡后旧的二进制自然失效
+std::uint64_t ShaderManager::hashProgram(const std::string& vertexSource, const std::string& fragmentSource) {
+    if (driverString.empty()) {
+        auto glString = [](GLenum name) {
+            const GLubyte* value = glGetString(name);
+            return value ? std::string(reinterpret_cast<const char*>(value)) : std::string();
+        };
+        driverString = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+    }
+
+    // FNV-1a 64
+    std::uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const std::string& text) {
+        for (unsigned char c : text) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        hash ^= 0xFF;
+        hash *= 1099511628211ull;
+    };
+    mix(driverString);
+    mix(vertexSource);
+    mix(fragmentSource);
+    return hash;
+}
+
+std::string ShaderManager::binaryCachePath(std::uint64_t hash) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(hash));
+    return (std::filesystem::path(binaryCacheDirectory) / name).string();
+}
+
+GLuint ShaderManager::loadProgramBinary(std::uint64_t hash) {
+    if (!GLExtensions::hasProgramBinary || binaryCacheDirectory.empty()) {
         return 0;
     }
 
-    GLuint program = createProgram(vertexShader, fragmentShader);
+    std::string path = binaryCachePath(hash);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return 0;
+    }
 
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    char magic[4];
+    std::uint32_t version = 0;
+    std::uint64_t storedHash = 0;
+    std::uint32_t format = 0;
+    std::uint32_t length = 0;
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+    file.read(reinterpret_cast<char*>(&storedHash), sizeof(storedHash));
+    file.read(reinterpret_cast<char*>(&format), sizeof(format));
+    file.read(reinterpret_cast<char*>(&length), sizeof(length));
+    std::vector<char> binary;
+    bool valid = file && std::memcmp(magic, kBinaryCacheMagic, sizeof(magic)) == 0 &&
+                 version == kBinaryCacheVersion && storedHash == hash && length > 0;
+    if (valid) {
+        binary.resize(length);
+        valid = static_cast<bool>(file.read(binary.data(), length));
+    }
+    file.close();
 
-    if (program != 0) {
-        programCache[key] = program;
+    GLuint program = 0;
+    if (valid) {
+        program = glCreateProgram();
+        GLExtensions::programBinary(program, format, binary.data(), static_cast<GLsizei>(length));
+        GLint linkStatus = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+        if (!linkStatus) {
+            glDeleteProgram(program);
+            program = 0;
+        }
     }
 
+    // 文件损坏或驱动拒绝（格式不匹配）时删除缓存，回退到重新编译
+    if (!program) {
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
     return program;
 }
 
+void ShaderManager::saveProgramBinary(GLuint program, std::uint64_t hash) {
+    if (!GLExtensions::hasProgramBinary || binaryCacheDirectory.empty()) {
+        return;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    GLExtensions::getProgramBinary(program, length, &written, &format, binary.data());
+    if (written <= 0) {
+        return;
+    }
+
+    // 先写临时文件再改名，多个进程同时写同一个缓存也不会读到半个文件
+    std::string path = binaryCachePath(hash);
+    std::string tempPath = path + ".tmp" + std::to_string(reinterpret_cast<std::uintptr_t>(this));
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return;
+        }
+        std::uint32_t version = kBinaryCacheVersion;
+        std::uint32_t storedFormat = format;
+        std::uint32_t storedLength = static_cast<std::uint32_t>(written);
+        file.write(kBinaryCacheMagic, sizeof(kBinaryCacheMagic));
+        file.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        file.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+        file.write(reinterpret_cast<const char*>(&storedFormat), sizeof(storedFormat));
+        file.write(reinterpret_cast<const char*>(&storedLength), sizeof(storedLength));
+        file.write(binary.data(), written);
+        if (!file) {
+            file.close();
+            std::error_code error;
+            std::filesystem::remove(tempPath, error);
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+    }
+}
+
 void ShaderManager::setExtendShader(const nlohmann::json& shaders)
 {
+    // 找出源码有变化（或被删除）的插件着色器，已编译的程序不能再用；
+    // 新增的着色器也算变化，之前因为缺少它而缓存的失败要重新尝试
+    std::set<std::string> changed;
+    if (extendShaders.is_object())
+    {
+        for (auto it = extendShaders.begin(); it != extendShaders.end(); ++it)
+        {
+            if (!shaders.is_object() || !shaders.contains(it.key()) || shaders[it.key()] != it.value())
+            {
+                changed.insert(it.key());
+            }
+        }
+    }
+    if (shaders.is_object())
+    {
+        for (auto it = shaders.begin(); it != shaders.end(); ++it)
+        {
+            if (!extendShaders.is_object() || !extendShaders.contains(it.key()))
+            {
+                changed.insert(it.key());
+            }
+        }
+    }
+
+    for (auto it = programCache.begin(); it != programCache.end();)
+    {
+        const std::string& key = it->first;
+        size_t separator = key.find('|');
+        if (changed.count(key.substr(0, separator)) || changed.count(key.substr(separator + 1)))
+        {
+            if (it->second)
+            {
+                GLStateCache::instance().deleteProgram(it->second);
+            }
+            it = programCache.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
     extendShaders = shaders;
 }
\ No newline at end of file
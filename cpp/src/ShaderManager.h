@@ -4,8 +4,11 @@
 #define SHADERMANAGER_H
 
 #include <glad/glad.h>
+#include <cstdint>
 #include <string>
 #include <map>
+#include <utility>
+#include <vector>
 #include "../nlohmann/json.hpp"
 
 class ShaderManager {
@@ -13,15 +16,49 @@ public:
     ShaderManager();
     ~ShaderManager();
 
+    // 创建失败（着色器缺失、编译或链接失败）时返回 0，错误只在第一次输出
     GLuint getProgram(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);
+    // 设置插件着色器源码；常驻服务模式下跨任务调用时，源码变化的着色器对应的程序会被丢弃重新编译
     void setExtendShader(const nlohmann::json& shaders);
+
+    // 一次性准备一批程序：先从二进制缓存加载，其余的全部提交编译链接后再统一查询结果，
+    // 驱动支持 parallel_shader_compile 时这些编译在驱动线程中并行完成，结果按完成顺序轮询收集
+    void warmUp(const std::vector<std::pair<std::string, std::string>>& programs);
+
+    // 程序二进制缓存目录，空字符串表示不使用磁盘缓存
+    void setBinaryCacheDirectory(const std::string& directory);
+    static std::string defaultBinaryCacheDirectory();
+
 private:
+    struct PendingProgram {
+        std::string key;
+        std::string vertexSource;
+        std::string fragmentSource;
+        std::uint64_t hash = 0;
+        GLuint vertexShader = 0;
+        GLuint fragmentShader = 0;
+        GLuint program = 0;
+    };
+
     std::string loadShaderFile(const std::string& path);
     GLuint compileShader(GLenum type, const std::string& source);
     GLuint createProgram(GLuint vertexShader, GLuint fragmentShader);
+    bool checkShader(GLuint shader);
+    bool checkProgram(GLuint program);
+    // 查询已提交程序的链接结果，写入 programCache 并保存二进制缓存
+    void finishProgram(PendingProgram& item);
+
+    std::uint64_t hashProgram(const std::string& vertexSource, const std::string& fragmentSource);
+    std::string binaryCachePath(std::uint64_t hash) const;
+    GLuint loadProgramBinary(std::uint64_t hash);
+    void saveProgramBinary(GLuint program, std::uint64_t hash);
 
+    // 值为 0 表示创建失败
     std::map<std::string, GLuint> programCache;
     nlohmann::json extendShaders;
+
+    std::string binaryCacheDirectory;
+    std::string driverString;
 };
 
-#endif // SHADERMANAGER_H
\ No newline at end of file
+#endif // SHADERMANAGER_H
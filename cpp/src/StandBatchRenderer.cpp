@@ -0,0 +1,106 @@
+// StandBatchRenderer.cpp
+
+#include "StandBatchRenderer.h"
+#include <cstddef>
+#include <iostream>
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "UniformBlock.h"
+
+const char* const StandBatchRenderer::kVertexShader = "standBatchVertex.glsl";
+const char* const StandBatchRenderer::kFragmentShader = "standBatchFragment.glsl";
+
+StandBatchRenderer::StandBatchRenderer(std::shared_ptr<ShaderManager> shaderManager)
+    : shaderManager(shaderManager) {
+}
+
+StandBatchRenderer::~StandBatchRenderer() {
+    // 程序归 ShaderManager 所有，这里只释放顶点对象
+    GLStateCache& state = GLStateCache::instance();
+    if (vertexArray) state.deleteVertexArrays(1, &vertexArray);
+    if (quadBuffer) state.deleteBuffers(1, &quadBuffer);
+    if (instanceBuffer) state.deleteBuffers(1, &instanceBuffer);
+}
+
+bool StandBatchRenderer::isAvailable() {
+    if (!initialized) {
+        initialized = true;
+        available = initialize();
+    }
+    return available;
+}
+
+bool StandBatchRenderer::initialize() {
+    if (!GLExtensions::hasInstancedArrays) {
+        std::clog << "驱动不支持逐实例顶点属性，Stand 图层不合批" << std::endl;
+        return false;
+    }
+
+    program = shaderManager->getProgram(kVertexShader, kFragmentShader);
+    if (!program) {
+        std::cerr << "Stand 合批着色器初始化失败，Stand 图层不合批" << std::endl;
+        return false;
+    }
+    GLuint frameBlockIndex = glGetUniformBlockIndex(program, UniformBlock::kFrameBlockName);
+    if (frameBlockIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, frameBlockIndex, UniformBlock::kFrameBinding);
+    }
+
+    GLStateCache& state = GLStateCache::instance();
+    state.useProgram(program);
+    GLint units[kMaxTextures];
+    for (int i = 0; i < kMaxTextures; i++) units[i] = i;
+    glUniform1iv(glGetUniformLocation(program, "u_textures"), kMaxTextures, units);
+
+    // 三角形带顺序与 RendererResource 的顶点一致：左上、右上、左下、右下
+    const float corners[] = {
+        -1.0f,  1.0f,
+         1.0f,  1.0f,
+        -1.0f, -1.0f,
+         1.0f, -1.0f,
+    };
+    glGenBuffers(1, &quadBuffer);
+    glGenBuffers(1, &instanceBuffer);
+    glGenVertexArrays(1, &vertexArray);
+
+    state.bindVertexArray(vertexArray);
+    state.bindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+
+    state.bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    auto instanceAttribute = [](GLuint location, size_t offset) {
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, 4, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)offset);
+        GLExtensions::vertexAttribDivisor(location, 1);
+    };
+    // mat4 占用 location 1~4，每列一个 vec4
+    for (GLuint column = 0; column < 4; column++) {
+        instanceAttribute(1 + column, offsetof(Instance, modelMatrix) + column * sizeof(glm::vec4));
+    }
+    instanceAttribute(5, offsetof(Instance, color));
+    instanceAttribute(6, offsetof(Instance, uvRect));
+    instanceAttribute(7, offsetof(Instance, sizeSlot));
+    return true;
+}
+
+void StandBatchRenderer::draw(const std::vector<Instance>& instances, const std::vector<GLuint>& textures) {
+    if (instances.empty() || !isAvailable()) {
+        return;
+    }
+
+    GLStateCache& state = GLStateCache::instance();
+    state.useProgram(program);
+
+    for (size_t slot = 0; slot < textures.size() && slot < static_cast<size_t>(kMaxTextures); slot++) {
+        state.bindTexture(static_cast<GLuint>(slot), textures[slot]);
+    }
+
+    // 同一帧内多次合批共用实例缓冲，glBufferData 重新分配存储，不等待上一次绘制读取完成
+    state.bindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(Instance), instances.data(), GL_STREAM_DRAW);
+
+    state.bindVertexArray(vertexArray);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(instances.size()));
+}
@@ -0,0 +1,53 @@
+// StandBatchRenderer.h
+
+#ifndef STANDBATCHRENDERER_H
+#define STANDBATCHRENDERER_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+#include "ShaderManager.h"
+
+// 把连续的 Stand 图层合成一次实例化绘制
+// 所有实例共用一个单位矩形，模型矩阵、颜色、纹理坐标和半宽高放在逐实例缓冲中；
+// 纹理绑定到 kMaxTextures 个纹理单元上，实例通过槽位选择
+class StandBatchRenderer {
+public:
+    static const char* const kVertexShader;
+    static const char* const kFragmentShader;
+    // 与 standBatchFragment.glsl 中 u_textures 的长度一致
+    static constexpr int kMaxTextures = 8;
+
+    // 逐实例数据，布局与 standBatchVertex.glsl 的实例属性一致
+    struct Instance {
+        glm::mat4 modelMatrix;
+        glm::vec4 color;
+        glm::vec4 uvRect;
+        // xy 为半宽高，z 为纹理槽位
+        glm::vec4 sizeSlot;
+    };
+
+    explicit StandBatchRenderer(std::shared_ptr<ShaderManager> shaderManager);
+    ~StandBatchRenderer();
+
+    // 驱动不支持逐实例属性或着色器编译失败时返回 false，调用方逐个 pass 绘制
+    bool isAvailable();
+
+    // 调用前需绑定好目标帧缓冲、视口和 FrameUniforms 块；textures[i] 对应槽位 i
+    void draw(const std::vector<Instance>& instances, const std::vector<GLuint>& textures);
+
+private:
+    bool initialize();
+
+    std::shared_ptr<ShaderManager> shaderManager;
+    bool initialized = false;
+    bool available = false;
+
+    GLuint program = 0;
+    GLuint vertexArray = 0;
+    GLuint quadBuffer = 0;
+    GLuint instanceBuffer = 0;
+};
+
+#endif // STANDBATCHRENDERER_H
@@ -6,9 +6,10 @@
 #include <vector>
 #include <algorithm>
 #include <limits>
+#include <map>
 #include <glad/glad.h>
-#include <GLFW/glfw3.h>
 #include "ScopedProfiler.h"
+#include "GLStateCache.h"
 
 #define NANOVG_GL3_IMPLEMENTATION 
 #include "../nanovg/nanovg_gl.h"
@@ -22,6 +23,66 @@ TextResource::~TextResource() {
     cleanup();
 }
 
+// 进程内共享的 FreeType 库、字体和 NanoVG 上下文
+namespace {
+struct SharedTextResources {
+    FT_Library library = nullptr;
+    std::map<std::string, FT_Face> faces;
+    NVGcontext* vg = nullptr;
+};
+
+SharedTextResources& sharedTextResources() {
+    static SharedTextResources shared;
+    return shared;
+}
+}
+
+FT_Face TextResource::getFontFace(const std::string& fontFilePath) {
+    auto& shared = sharedTextResources();
+    if (!shared.library && FT_Init_FreeType(&shared.library)) {
+        std::cerr << "Could not initialize FreeType library." << std::endl;
+        shared.library = nullptr;
+        return nullptr;
+    }
+
+    auto it = shared.faces.find(fontFilePath);
+    if (it != shared.faces.end()) {
+        return it->second;
+    }
+
+    FT_Face face = nullptr;
+    if (FT_New_Face(shared.library, fontFilePath.c_str(), 0, &face)) {
+        std::cerr << "Failed to load font: " << fontFilePath << std::endl;
+        return nullptr;
+    }
+    shared.faces[fontFilePath] = face;
+    return face;
+}
+
+NVGcontext* TextResource::getNanoVGContext() {
+    auto& shared = sharedTextResources();
+    if (!shared.vg) {
+        shared.vg = nvgCreateGL3(NVG_ANTIALIAS | NVG_STENCIL_STROKES);// | NVG_DEBUG
+    }
+    return shared.vg;
+}
+
+void TextResource::releaseSharedResources() {
+    auto& shared = sharedTextResources();
+    if (shared.vg) {
+        nvgDeleteGL3(shared.vg);
+        shared.vg = nullptr;
+    }
+    for (auto& pair : shared.faces) {
+        FT_Done_Face(pair.second);
+    }
+    shared.faces.clear();
+    if (shared.library) {
+        FT_Done_FreeType(shared.library);
+        shared.library = nullptr;
+    }
+}
+
 std::u32string TextResource::utf8_to_u32string(const std::string& str) {
     std::u32string result;
     size_t i = 0;
@@ -78,20 +139,12 @@ std::u32string TextResource::utf8_to_u32string(const std::string& str) {
 bool TextResource::initialize(int rotate) {
     // ScopedProfiler profiler("TextResource::initialize");
 
-// Initialize FreeType
-    FT_Library ft;
-    if (FT_Init_FreeType(&ft)) {
-        std::cerr << "Could not initialize FreeType library." << std::endl;
-    }
-
-    // Load font face
-    FT_Face face;
-    if (FT_New_Face(ft, fontFilePath.c_str(), 0, &face)) {
-        std::cerr << "Failed to load font: " << fontFilePath << std::endl;
-        FT_Done_FreeType(ft);
+    // 字体与 FreeType 库跨文本资源共享（常驻服务模式下跨任务共享）
+    FT_Face face = getFontFace(fontFilePath);
+    if (!face) {
+        return false;
     }
 
-
     // 设置字符大小
     FT_Set_Char_Size(face, 0, static_cast<FT_F26Dot6>(fontSize * 64), 0, 0);
 
@@ -149,7 +202,7 @@ bool TextResource::initialize(int rotate) {
     this->height = targetHeight;
 
 
-    glViewport(0, 0, targetWidth, targetHeight);
+    GLStateCache::instance().viewport(0, 0, targetWidth, targetHeight);
 
 
     // std::cerr << "renderTargetInfo.name:" << renderTargetInfo.name << std::endl;
@@ -167,18 +220,17 @@ bool TextResource::initialize(int rotate) {
             }
         }
     }
-    glBindFramebuffer(GL_FRAMEBUFFER, renderTarget->framebuffer);
+    GLStateCache::instance().bindFramebuffer(GL_FRAMEBUFFER, renderTarget->framebuffer);
 
 
-    NVGcontext* vg = nvgCreateGL3(NVG_ANTIALIAS | NVG_STENCIL_STROKES);// | NVG_DEBUG
+    NVGcontext* vg = getNanoVGContext();
     if (vg == nullptr) {
         std::cerr << "无法初始化 NanoVG" << std::endl;
-        // 处理错误
+        return false;
     }
 
-    glfwPollEvents();
     // 清除屏幕
-    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    GLStateCache::instance().clearColor(0.0f, 0.0f, 0.0f, 0.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
     // Begin NanoVG frame
@@ -238,9 +290,11 @@ bool TextResource::initialize(int rotate) {
 
     nvgEndFrame(vg);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0); 
+    // NanoVG 直接修改了程序、纹理、混合等 GL 状态，缓存全部作废
+    GLStateCache::instance().invalidate();
 
     textureId = renderTarget->texture;
+    GLStateCache::instance().markTextureModified(textureId);
 
     generateVertices();
 
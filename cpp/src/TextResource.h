@@ -61,7 +61,13 @@ public:
     virtual GLuint getTexture() override {return textureId;};
 
     std::shared_ptr<RenderTarget> getRenderTarget() { return renderTarget; }
+
+    // 释放共享的字体与 NanoVG 上下文，必须在 OpenGL 上下文销毁之前调用
+    static void releaseSharedResources();
 private:
+    static FT_Face getFontFace(const std::string& fontFilePath);
+    static NVGcontext* getNanoVGContext();
+
     std::u32string utf8_to_u32string(const std::string& str);
 
     bool isContourClockwise(const FT_Outline* outline, int contourIndex);
@@ -0,0 +1,59 @@
+// UniformBlock.cpp
+
+#include "UniformBlock.h"
+#include <cstring>
+#include <iostream>
+#include "GLStateCache.h"
+
+const char* const UniformBlock::kFrameBlockName = "FrameUniforms";
+
+std::uint64_t UniformBlock::uploadCount = 0;
+std::uint64_t UniformBlock::skipCount = 0;
+
+UniformBlock::UniformBlock(GLsizeiptr size)
+    : data(static_cast<size_t>(size), 0) {
+    glGenBuffers(1, &buffer);
+    GLStateCache::instance().bindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, size, data.data(), GL_DYNAMIC_DRAW);
+}
+
+UniformBlock::~UniformBlock() {
+    if (buffer) {
+        GLStateCache::instance().deleteBuffers(1, &buffer);
+    }
+}
+
+bool UniformBlock::write(GLint offset, const void* value, size_t size) {
+    if (offset < 0 || offset + size > data.size()) {
+        return false;
+    }
+    unsigned char* target = data.data() + offset;
+    if (std::memcmp(target, value, size) == 0) {
+        return false;
+    }
+    std::memcpy(target, value, size);
+    dirty = true;
+    return true;
+}
+
+void UniformBlock::upload() {
+    if (!dirty) {
+        skipCount++;
+        return;
+    }
+    GLStateCache::instance().bindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(data.size()), data.data());
+    dirty = false;
+    uploadCount++;
+}
+
+void UniformBlock::bind(GLuint binding) {
+    upload();
+    GLStateCache::instance().bindUniformBuffer(binding, buffer);
+}
+
+void UniformBlock::logCounters() {
+    std::clog << "Uniform 块（上传/未变化跳过）: " << uploadCount << "/" << skipCount << std::endl;
+    uploadCount = 0;
+    skipCount = 0;
+}
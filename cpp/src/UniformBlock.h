@@ -0,0 +1,58 @@
+// UniformBlock.h
+
+#ifndef UNIFORMBLOCK_H
+#define UNIFORMBLOCK_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// std140 uniform 块对应的缓冲对象
+// CPU 端保存一份块数据，写入的值与已有数据不同时才标记为脏，upload() 只上传脏块
+class UniformBlock {
+public:
+    // 着色器中所有 pass 共享的每帧数据块，成员布局与 FrameData 一致：
+    //   layout(std140) uniform FrameUniforms {
+    //       mat4 u_viewMatrix; mat4 u_projectionMatrix; vec2 u_canvasSize;
+    //   };
+    // std140 块的所有成员都算作活动成员，会参与每个 pass 的内容哈希，所以这里只放整个任务不变的数据；
+    // 随时间变化的值（如插件的 u_time）放在各自着色器的默认 uniform 中
+    static const char* const kFrameBlockName;
+    // NanoVG 的 uniform 块固定使用绑定点 0，引擎从 1 开始
+    static constexpr GLuint kFrameBinding = 1;
+    static constexpr GLuint kFirstPassBinding = 2;
+
+    struct FrameData {
+        glm::mat4 viewMatrix;
+        glm::mat4 projectionMatrix;
+        glm::vec2 canvasSize;
+        glm::vec2 padding;
+    };
+
+    explicit UniformBlock(GLsizeiptr size);
+    ~UniformBlock();
+    UniformBlock(const UniformBlock&) = delete;
+    UniformBlock& operator=(const UniformBlock&) = delete;
+
+    // 写入块内 offset 处的数据，返回值是否变化
+    bool write(GLint offset, const void* value, size_t size);
+    // 脏块上传到缓冲对象
+    void upload();
+    // 上传后绑定到 binding 绑定点
+    void bind(GLuint binding);
+
+    // 统计上传和因未变化跳过的次数，输出后重新统计
+    static void logCounters();
+
+private:
+    GLuint buffer = 0;
+    std::vector<unsigned char> data;
+    bool dirty = true;
+
+    static std::uint64_t uploadCount;
+    static std::uint64_t skipCount;
+};
+
+#endif // UNIFORMBLOCK_H
@@ -11,6 +11,7 @@
 #include "VideoResource.h"
 #include "ScopedProfiler.h"
 #include "TextResource.h" 
+#include "GLStateCache.h"
 
 VideoRenderer::VideoRenderer(std::shared_ptr<Camera> camera, std::shared_ptr<Camera> screenCamera, GLuint screenBuffer, const std::string& name)
     : camera(camera), screenCamera(screenCamera), screenBuffer(screenBuffer), name(name) {
@@ -23,6 +24,10 @@ VideoRenderer::VideoRenderer(std::shared_ptr<Camera> camera, std::shared_ptr<Cam
     buffer = 0;
 }
 
+VideoRenderer::~VideoRenderer() {
+    destroy();
+}
+
 void VideoRenderer::setRendererResource(std::shared_ptr<RendererResource> rendererResource)
 {
     this->rendererResource = rendererResource;
@@ -97,10 +102,7 @@ void VideoRenderer::updateMaterialUniforms() {
     // vec4f = std::get<glm::mat4>(materialPass->uniforms["u_modelMatrix"].value);
     // std::cerr << "new:" << glm::to_string(vec4f) << std::endl;
 
-    glm::mat4 screenViewMatrix = camera->getViewMatrix();
-    materialPass->uniforms["u_viewMatrix"].value = screenViewMatrix;
-    glm::mat4 screenProjectionMatrix = camera->getProjectionMatrix();
-    materialPass->uniforms["u_projectionMatrix"].value = screenProjectionMatrix;
+    // 相机矩阵通过 FrameUniforms 块每帧统一提供
     materialPass->uniforms["u_color"].value = color;
 }
 
@@ -119,10 +121,10 @@ void VideoRenderer::updateVerticeBuffer()
         renderTargetInfo = std::get<RenderTargetInfo>(materialPass->uniforms["u_texture"].value);
     }
     else{
-        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        GLStateCache::instance().bindBuffer(GL_ARRAY_BUFFER, buffer);
         const std::vector<float>& vertices = rendererResource->getVertices();  // 使用常量引用，避免拷贝
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        updateQuad(vertices);
         return;
     }
 
@@ -132,7 +134,7 @@ void VideoRenderer::updateVerticeBuffer()
         float w = renderTargetInfo.width / 2.0f;
         float h = renderTargetInfo.height / 2.0f;
 
-        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        GLStateCache::instance().bindBuffer(GL_ARRAY_BUFFER, buffer);
 
         std::vector<float> vertices = rendererResource->getVertices();
         vertices[0]  = (vertices[0]  / std::fabs(vertices[0]))  * w;
@@ -147,16 +149,26 @@ void VideoRenderer::updateVerticeBuffer()
         vertices[16] = (vertices[16] / std::fabs(vertices[16])) * h;
 
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        updateQuad(vertices);
     }
     else{
-        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        GLStateCache::instance().bindBuffer(GL_ARRAY_BUFFER, buffer);
         const std::vector<float>& vertices = rendererResource->getVertices();  // 使用常量引用，避免拷贝
         glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        updateQuad(vertices);
     }
 }
 
+// 顶点顺序：左上、右上、左下、右下，每个顶点 x, y, z, u, v
+void VideoRenderer::updateQuad(const std::vector<float>& vertices)
+{
+    Material::Quad& quad = materialPass->quad;
+    quad.valid = vertices.size() >= 20;
+    if (!quad.valid) return;
+    quad.halfSize = glm::vec2(std::fabs(vertices[5]), std::fabs(vertices[1]));
+    quad.uvRect = glm::vec4(vertices[3], vertices[4], vertices[18], vertices[19]);
+}
+
 glm::mat4 VideoRenderer::getModelMatrix() {
     glm::mat4 modelMatrix(1.0f);
 
@@ -215,7 +227,7 @@ int VideoRenderer::getHeight() const {
 
 void VideoRenderer::destroy() {
     if (buffer != 0) {
-        glDeleteBuffers(1, &buffer);
+        GLStateCache::instance().deleteBuffers(1, &buffer);
         buffer = 0;
     }
 }
\ No newline at end of file
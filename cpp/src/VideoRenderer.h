@@ -17,6 +17,7 @@
 class VideoRenderer {
 public:
     VideoRenderer(std::shared_ptr<Camera> camera, std::shared_ptr<Camera> screenCamera, GLuint screenBuffer, const std::string& name);
+    ~VideoRenderer();
 
     bool initialize(int rotate, RenderTargetInfo renderTargetInfo);
     void updateMaterialUniforms();
@@ -52,6 +53,9 @@ public:
     glm::vec3 rotation;
 
 private:
+    // 记录上传的矩形，供 RenderPass 合批绘制
+    void updateQuad(const std::vector<float>& vertices);
+
     std::shared_ptr<RendererResource> rendererResource;
     std::shared_ptr<Material> materialPass; // 使用智能指针
     std::shared_ptr<Camera> camera;
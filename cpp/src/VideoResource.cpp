@@ -3,37 +3,45 @@
 // VideoResource.cpp
 
 #include "VideoResource.h"
+#include "GLStateCache.h"
 #include <iostream>
 #include <chrono>
 #include <thread>
+#include <algorithm>
 #include <cmath>
 
 extern "C" {
 #include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
 #include <libavutil/version.h>
 }
 
 VideoResource::VideoResource(const std::string& filePath)
     : filePath(filePath), formatContext(nullptr), codecContext(nullptr),
       videoStreamIndex(-1), avFrame(nullptr), avPacket(nullptr), swsContext(nullptr),
-      width(0), height(0), duration(0.0), rgbBuffer(nullptr), rgbBufferSize(0) {
+      width(0), height(0), duration(0.0) {
 
     preTime = -1.0;
 
-    glGenTextures(1, &texture);
-    glBindTexture(GL_TEXTURE_2D, texture);
-    // 初始化纹理参数
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    createTexture();
 }
 
 VideoResource::~VideoResource() {
     destroy();
+    if (texture) {
+        GLStateCache::instance().deleteTextures(1, &texture);
+        texture = 0;
+    }
 }
 
 bool VideoResource::initialize(int rotate) {
+    // 已经打开过（常驻服务模式下跨任务复用）：解复用器和解码器保持打开，只需回到开头
+    if (formatContext && codecContext) {
+        rewind();
+        generateVertices(rotate);
+        return true;
+    }
+
     // 打开输入文件
     if (avformat_open_input(&formatContext, filePath.c_str(), nullptr, nullptr) != 0) {
         std::cerr << "无法打开输入文件：" << filePath << std::endl;
@@ -59,6 +67,60 @@ bool VideoResource::initialize(int rotate) {
         return false;
     }
 
+    if (!openDecoder(0)) {
+        return false;
+    }
+
+    // 分配帧和包
+    avFrame = av_frame_alloc();
+    avPacket = av_packet_alloc();
+    lastDecodedFrame = av_frame_alloc();
+    preparedFrame = av_frame_alloc();
+
+    if (!avFrame || !avPacket || !lastDecodedFrame || !preparedFrame) {
+        std::cerr << "无法分配帧或包：" << filePath << std::endl;
+        return false;
+    }
+
+    // 获取视频宽高（lowres 时解码器的宽高会缩小，这里取流的原始尺寸）
+    width = formatContext->streams[videoStreamIndex]->codecpar->width;
+    height = formatContext->streams[videoStreamIndex]->codecpar->height;
+    decodeWidth = width;
+    decodeHeight = height;
+
+    // 帧率未知时按 30 帧估算
+    AVRational frameRate = av_guess_frame_rate(formatContext, formatContext->streams[videoStreamIndex], nullptr);
+    frameDuration = frameRate.num > 0 && frameRate.den > 0 ? av_q2d(av_inv_q(frameRate)) : 1.0 / 30.0;
+
+    // 获取视频时长（秒）
+    if (formatContext->duration != AV_NOPTS_VALUE)
+        duration = formatContext->duration / (double)AV_TIME_BASE;
+    else
+        duration = 0.0;
+
+    if (width == 0 || height == 0) {
+        std::cerr << "无效的视频尺寸：" << filePath << std::endl;
+        return false;
+    }
+    if (!YuvTexture::isSupportedFormat(codecContext->pix_fmt)) {
+        // 解码后先用 sws_scale 转换为 YUV420P，再走同样的平面上传
+        std::clog << "像素格式 " << (codecContext->pix_fmt == AV_PIX_FMT_NONE ? "none" : av_get_pix_fmt_name(codecContext->pix_fmt))
+                  << " 不能直接上传，解码后转换为 yuv420p：" << filePath << std::endl;
+    }
+
+    allocateTexture();
+
+    // 你的原始initialize()函数代码不变，后面增加一次seek到开头即可：
+    rewind();
+
+    // 生成顶点数据
+    generateVertices(rotate);
+
+    return true;
+}
+
+
+bool VideoResource::openDecoder(int lowres) {
     // 获取视频流的编解码器参数
     AVCodecParameters* codecParameters = formatContext->streams[videoStreamIndex]->codecpar;
 
@@ -100,135 +162,277 @@ bool VideoResource::initialize(int rotate) {
     codecContext->flags |= AV_CODEC_FLAG_OUTPUT_CORRUPT; // 允许输出损坏帧
     codecContext->flags2 |= AV_CODEC_FLAG2_SHOW_ALL;     // 尽可能多地输出有效帧
 
+    // 按 lowres 缩小输出（只有 MJPEG 等少数解码器支持）
+    codecContext->lowres = std::min(lowres, static_cast<int>(codec->max_lowres));
+
     // 打开解码器
     if (avcodec_open2(codecContext, codec, nullptr) < 0) {
         std::cerr << "无法打开解码器：" << filePath << std::endl;
         return false;
     }
+    return true;
+}
 
-    // 分配帧和包
-    avFrame = av_frame_alloc();
-    avPacket = av_packet_alloc();
+void VideoResource::createTexture() {
+    glGenTextures(1, &texture);
+    GLStateCache::instance().bindTexture(texture);
+    // 初始化纹理参数
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    textureWidth = 0;
+    textureHeight = 0;
+}
 
-    if (!avFrame || !avPacket) {
-        std::cerr << "无法分配帧或包：" << filePath << std::endl;
-        return false;
+void VideoResource::allocateTexture() {
+    if (textureWidth == decodeWidth && textureHeight == decodeHeight) {
+        return;
     }
+    // 不可变存储不能改尺寸，换一个新纹理
+    if (textureWidth != 0) {
+        GLStateCache::instance().deleteTextures(1, &texture);
+        // 驱动可能把刚删除的名字分给新纹理，名字相同也要重新挂到帧缓冲上
+        yuvTexture.resetTarget();
+        createTexture();
+    }
+    YuvTexture::allocateStorage(texture, GL_RGBA8, decodeWidth, decodeHeight);
+    textureWidth = decodeWidth;
+    textureHeight = decodeHeight;
+}
 
-    // 获取视频宽高
-    width = codecContext->width;
-    height = codecContext->height;
-
-    // 获取视频时长（秒）
-    if (formatContext->duration != AV_NOPTS_VALUE)
-        duration = formatContext->duration / (double)AV_TIME_BASE;
-    else
-        duration = 0.0;
-
-    // 初始化阶段
-    swsContext = sws_getContext(
-        codecContext->width,
-        codecContext->height,
-        codecContext->pix_fmt,
-        codecContext->width,
-        codecContext->height,
-        AV_PIX_FMT_RGB24,
-        SWS_FAST_BILINEAR, // 高效选项
-        nullptr,
-        nullptr,
-        nullptr
-    );
-    if (!swsContext) {
-        // std::cerr << "无法初始化 swsContext" << std::endl;
-        // return false;
+void VideoResource::setDecodeScale(double scale) {
+    if (!formatContext || !codecContext) {
+        return;
+    }
 
-        std::cerr << "sws_getContext 失败:" << std::endl;
-        std::cerr << "输入尺寸: " << codecContext->width << "x" << codecContext->height << std::endl;
-        std::cerr << "输入格式: " << av_get_pix_fmt_name(codecContext->pix_fmt) << std::endl;
+    // 不放大；缩小时宽高取偶数，YUV420P 的色度平面正好是一半
+    GLuint targetWidth = width;
+    GLuint targetHeight = height;
+    if (scale < 1.0) {
+        targetWidth = std::min(width, std::max(2u, (static_cast<GLuint>(std::ceil(width * scale)) + 1) & ~1u));
+        targetHeight = std::min(height, std::max(2u, (static_cast<GLuint>(std::ceil(height * scale)) + 1) & ~1u));
+    }
 
-        // 检查输入参数是否有效
-        if (codecContext->width <= 0 || codecContext->height <= 0) {
-            std::cerr << "无效的视频尺寸" << std::endl;
-        }
-        if (codecContext->pix_fmt == AV_PIX_FMT_NONE) {
-            std::cerr << "无效的像素格式" << std::endl;
+    // 解码器支持 lowres 时取输出仍不小于目标的最大级别，解码本身就按 1/2^lowres 进行
+    int lowres = 0;
+    int maxLowres = codecContext->codec ? codecContext->codec->max_lowres : 0;
+    while (lowres < maxLowres &&
+           static_cast<GLuint>(AV_CEIL_RSHIFT(static_cast<int>(width), lowres + 1)) >= targetWidth &&
+           static_cast<GLuint>(AV_CEIL_RSHIFT(static_cast<int>(height), lowres + 1)) >= targetHeight) {
+        lowres++;
+    }
+    if (lowres != codecContext->lowres) {
+        avcodec_free_context(&codecContext);
+        if (!openDecoder(lowres)) {
+            // 以 lowres 打开失败时退回全尺寸解码
+            avcodec_free_context(&codecContext);
+            if (!openDecoder(0)) {
+                avcodec_free_context(&codecContext);
+                return;
+            }
         }
-        return false;
-
+        rewind();
     }
-
-    // 你的原始initialize()函数代码不变，后面增加一次seek到开头即可：
-    int64_t timestamp = av_rescale_q(0, AV_TIME_BASE_Q, formatContext->streams[videoStreamIndex]->time_base);
-    av_seek_frame(formatContext, videoStreamIndex, timestamp, AVSEEK_FLAG_BACKWARD);
-    avcodec_flush_buffers(codecContext);
-    preTime = -1.0; // 初始化标记为还未解码任何帧
-    
-    // 分配 RGB 图像数据缓冲区
-    rgbBufferSize = av_image_get_buffer_size(AV_PIX_FMT_RGB24, width, height, 1);
-    rgbBuffer = (uint8_t*)av_malloc(rgbBufferSize * sizeof(uint8_t));
-    if (!rgbBuffer) {
-        std::cerr << "无法分配 RGB 图像数据缓冲区" << std::endl;
-        return false;
+    if (codecContext->lowres > 0) {
+        // lowres 的输出已接近目标尺寸，直接上传，不再缩放
+        targetWidth = codecContext->width;
+        targetHeight = codecContext->height;
     }
 
-    // 生成顶点数据
-    generateVertices(rotate);
-
-    return true;
+    if (targetWidth != decodeWidth || targetHeight != decodeHeight) {
+        decodeWidth = targetWidth;
+        decodeHeight = targetHeight;
+        allocateTexture();
+        // 纹理换了，下一次 getFrameAt 必须重新上传
+        preTime = -1.0;
+        if (decodeWidth != width || decodeHeight != height) {
+            std::clog << "视频按 " << decodeWidth << "x" << decodeHeight << " 解码（源 " << width << "x" << height
+                      << (codecContext->lowres > 0 ? "，lowres " + std::to_string(codecContext->lowres) : std::string())
+                      << "）：" << filePath << std::endl;
+        }
+    }
 }
 
-
 bool VideoResource::getFrameAt(double time) {
-    const double tolerance = 0.033;
-
     if (!formatContext || !codecContext)
         return false;
-    if (std::abs(preTime - time) <= tolerance)
+
+    // 离纹理中的画面不到半帧：仍是同一帧
+    const double tolerance = frameDuration * 0.5;
+    if (preTime >= 0.0 && std::abs(preTime - time) <= tolerance)
     {
         return true;
     }
 
-    preTime = time;
+    // 已经解码到文件末尾且目标不早于最后一帧（容器或音频比视频流长）：保持纹理中的最后一帧，不再定位重解
+    if (decoderDrained && preTime >= 0.0 && time >= lastDecodedTime - tolerance) {
+        return true;
+    }
+
+    // 目标在解码位置之前（循环播放、片段从文件中间开始），或远远超前且中间隔着关键帧：定位后只解码目标所在的 GOP
+    bool needSeek;
+    if (decoderDrained || (lastDecodedTime >= 0.0 && time < lastDecodedTime - tolerance)) {
+        needSeek = true;
+    } else {
+        double from = std::max(lastDecodedTime, 0.0);
+        needSeek = time - from > kSeekAheadSeconds && hasKeyframeBetween(from, time);
+    }
+    if (needSeek) {
+        seekTo(time);
+    }
+
+    while (decodeNextFrame()) {
+        // 只转换要显示的那一帧，跳过的帧不做颜色转换
+        if (lastDecodedTime >= time - tolerance) {
+            presentFrame(avFrame);
+            av_frame_unref(lastDecodedFrame);
+            av_frame_unref(avFrame);
+            return true;
+        }
+        av_frame_unref(lastDecodedFrame);
+        av_frame_move_ref(lastDecodedFrame, avFrame);
+    }
 
-    bool frameFound = false;
-    bool eof_reached = false;
+    decoderDrained = true;
+    if (lastDecodedFrame->buf[0]) {
+        presentFrame(lastDecodedFrame);
+        av_frame_unref(lastDecodedFrame);
+    }
+    std::cerr << "[警告] 已到达视频末尾，未能找到精确的帧，但已使用最后解码的帧:" << time << " 秒。" << std::endl;
+    return true;
+}
 
+bool VideoResource::decodeNextFrame() {
     while (true) {
-        int ret = av_read_frame(formatContext, avPacket);
+        int ret = avcodec_receive_frame(codecContext, avFrame);
+        if (ret == 0) {
+            lastDecodedTime = frameTime(avFrame);
+            return true;
+        }
+        if (ret != AVERROR(EAGAIN)) {
+            // 空包之后解码器中的帧已全部取出
+            return false;
+        }
+
+        ret = av_read_frame(formatContext, avPacket);
         if (ret < 0) {
             // 文件读取结束，发送空包到解码器，取出剩余的缓存帧
             avcodec_send_packet(codecContext, nullptr);
-            eof_reached = true;
-        } else if (avPacket->stream_index == videoStreamIndex) {
-            avcodec_send_packet(codecContext, avPacket);
-            av_packet_unref(avPacket);
         } else {
+            if (avPacket->stream_index == videoStreamIndex) {
+                avcodec_send_packet(codecContext, avPacket);
+            }
             av_packet_unref(avPacket);
-            continue;
         }
+    }
+}
 
-        while (avcodec_receive_frame(codecContext, avFrame) == 0) {
-            double frameTime = avFrame->best_effort_timestamp * av_q2d(formatContext->streams[videoStreamIndex]->time_base);
-            uint8_t* dest[4] = { rgbBuffer, nullptr, nullptr, nullptr };
-            int destLinesize[4] = { static_cast<int>(width) * 3, 0, 0, 0 };
-            sws_scale(swsContext, avFrame->data, avFrame->linesize, 0, height, dest, destLinesize);
+bool VideoResource::prepareFrame(const AVFrame* frame, AVFrame* dst) {
+    av_frame_unref(dst);
+    if (YuvTexture::isSupportedFormat(frame->format) && frame->linesize[0] > 0 &&
+        frame->width == static_cast<int>(decodeWidth) && frame->height == static_cast<int>(decodeHeight)) {
+        return av_frame_ref(dst, frame) == 0;
+    }
 
-            if (frameTime >= time - tolerance) {
-                updateTexture(rgbBuffer, width, height);
-                av_frame_unref(avFrame);
-                return true;
-            }
-            av_frame_unref(avFrame);
-        }
+    // 缩小时用区域平均避免混叠，只转换格式时用最快的双线性
+    bool downscale = frame->width > static_cast<int>(decodeWidth) || frame->height > static_cast<int>(decodeHeight);
+
+    swsContext = sws_getCachedContext(
+        swsContext,
+        frame->width,
+        frame->height,
+        static_cast<AVPixelFormat>(frame->format),
+        decodeWidth,
+        decodeHeight,
+        AV_PIX_FMT_YUV420P,
+        downscale ? SWS_AREA : SWS_FAST_BILINEAR,
+        nullptr,
+        nullptr,
+        nullptr
+    );
+    if (!swsContext) {
+        std::cerr << "sws_getContext 失败，输入格式: " << av_get_pix_fmt_name(static_cast<AVPixelFormat>(frame->format)) << std::endl;
+        return false;
+    }
+    dst->format = AV_PIX_FMT_YUV420P;
+    dst->width = decodeWidth;
+    dst->height = decodeHeight;
+    if (av_frame_get_buffer(dst, 0) < 0) {
+        return false;
+    }
+    sws_scale(swsContext, frame->data, frame->linesize, 0, frame->height, dst->data, dst->linesize);
+    av_frame_copy_props(dst, frame);
+    // swscale 默认输出有限范围；RGB 输入按 BT.601 矩阵转换，YUV 输入保持原来的矩阵
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+    if (desc && (desc->flags & AV_PIX_FMT_FLAG_RGB)) {
+        dst->colorspace = AVCOL_SPC_SMPTE170M;
+    }
+    dst->color_range = AVCOL_RANGE_MPEG;
+    return true;
+}
 
-        if (eof_reached) break; // EOF后解码器缓存帧全部取出，结束循环
+void VideoResource::uploadFrame(const AVFrame* frame) {
+    if (yuvTexture.convert(frame, texture, decodeWidth, decodeHeight)) {
+        GLStateCache::instance().markTextureModified(texture);
     }
+}
 
-    std::cerr << "[警告] 已到达视频末尾，未能找到精确的帧，但已使用最后解码的帧:" << time << " 秒。" << std::endl;
-    return true;
+void VideoResource::presentFrame(AVFrame* frame) {
+    if (prepareFrame(frame, preparedFrame)) {
+        uploadFrame(preparedFrame);
+        av_frame_unref(preparedFrame);
+    }
+    preTime = frameTime(frame);
+}
+
+int64_t VideoResource::toStreamTimestamp(double time) const {
+    AVStream* stream = formatContext->streams[videoStreamIndex];
+    int64_t timestamp = av_rescale_q(static_cast<int64_t>(time * AV_TIME_BASE), AV_TIME_BASE_Q, stream->time_base);
+    if (stream->start_time != AV_NOPTS_VALUE) {
+        timestamp += stream->start_time;
+    }
+    return timestamp;
+}
+
+double VideoResource::frameTime(const AVFrame* frame) const {
+    AVStream* stream = formatContext->streams[videoStreamIndex];
+    int64_t timestamp = frame->best_effort_timestamp;
+    if (timestamp == AV_NOPTS_VALUE) {
+        // 没有时间戳时按上一帧加一帧估算
+        return lastDecodedTime < 0.0 ? 0.0 : lastDecodedTime + frameDuration;
+    }
+    if (stream->start_time != AV_NOPTS_VALUE) {
+        timestamp -= stream->start_time;
+    }
+    return timestamp * av_q2d(stream->time_base);
+}
+
+bool VideoResource::hasKeyframeBetween(double from, double time) const {
+    AVStream* stream = formatContext->streams[videoStreamIndex];
+    int index = av_index_search_timestamp(stream, toStreamTimestamp(time), AVSEEK_FLAG_BACKWARD);
+    const AVIndexEntry* entry = index >= 0 ? avformat_index_get_entry(stream, index) : nullptr;
+    if (!entry) {
+        // 没有索引无法判断关键帧位置，按有处理
+        return true;
+    }
+    return entry->timestamp > toStreamTimestamp(from);
 }
 
+void VideoResource::seekTo(double time) {
+    if (av_seek_frame(formatContext, videoStreamIndex, toStreamTimestamp(time), AVSEEK_FLAG_BACKWARD) < 0) {
+        av_seek_frame(formatContext, videoStreamIndex, toStreamTimestamp(0.0), AVSEEK_FLAG_BACKWARD);
+    }
+    avcodec_flush_buffers(codecContext);
+    av_frame_unref(lastDecodedFrame);
+    lastDecodedTime = -1.0;
+    decoderDrained = false;
+}
 
+void VideoResource::rewind() {
+    seekTo(0.0);
+    preTime = -1.0; // 初始化标记为还未解码任何帧
+}
 
 int VideoResource::normalizeRotation(int degrees) {
     return ((degrees % 360) + 360) % 360;
@@ -249,26 +453,6 @@ void VideoResource::generateVertices(int rotation) {
     };
 }
 
-void VideoResource::updateTexture(uint8_t* data, int width, int height) {
-    if (!data)
-        return;
-
-    // 将 RGB 数据上传到 OpenGL 纹理
-    glBindTexture(GL_TEXTURE_2D, texture);
-    glTexImage2D(
-        GL_TEXTURE_2D,
-        0,
-        GL_RGB,
-        width,
-        height,
-        0,
-        GL_RGB,
-        GL_UNSIGNED_BYTE,
-        data
-    );
-}
-
-
 void VideoResource::destroy() {
     if (avFrame) {
         av_frame_free(&avFrame);
@@ -278,6 +462,12 @@ void VideoResource::destroy() {
         av_packet_free(&avPacket);
         avPacket = nullptr;
     }
+    if (lastDecodedFrame) {
+        av_frame_free(&lastDecodedFrame);
+    }
+    if (preparedFrame) {
+        av_frame_free(&preparedFrame);
+    }
     if (codecContext) {
         avcodec_free_context(&codecContext);
         codecContext = nullptr;
@@ -290,11 +480,6 @@ void VideoResource::destroy() {
         sws_freeContext(swsContext);
         swsContext = nullptr;
     }
-    if (rgbBuffer) {
-        av_free(rgbBuffer);
-        rgbBuffer = nullptr;
-        rgbBufferSize = 0;
-    }
 }
 
 GLuint VideoResource::getWidth() const {
@@ -9,6 +9,7 @@
 #include <string>
 #include <vector>
 #include "RendererResource.h"
+#include "YuvTexture.h"
 
 // 添加 FFmpeg 头文件
 extern "C" {
@@ -34,17 +35,49 @@ public:
     virtual GLuint getTexture() override {return texture;};
 
 
+    // 按屏幕上的最大缩放（屏幕像素 / 源像素）降低解码和纹理分辨率，scale >= 1 时为源分辨率
+    // 支持 lowres 的解码器直接以 1/2^n 解码，否则由 sws_scale 缩小；顶点仍按源尺寸生成，画面的布局不变
+    // 纹理可能因此换成新的对象，调用方需要更新引用了旧 getTexture() 的材质
+    virtual void setDecodeScale(double scale);
+    GLuint getDecodeWidth() const { return decodeWidth; }
+    GLuint getDecodeHeight() const { return decodeHeight; }
+
     int getRotation() const { return rotation; }
+    const std::string& getFilePath() const { return filePath; }
 
 
     double getDuration() const;
-    bool getFrameAt(double time);
+    // 把 time（秒）处的画面上传到纹理：目标在解码位置之前，或与解码位置之间隔着关键帧时，
+    // 先定位到目标之前最近的关键帧，只解码到目标所在的 GOP
+    virtual bool getFrameAt(double time);
     void destroy();
 
-private:
+protected:
+    // 目标超前解码位置这么多秒以上才考虑向前定位，顺序播放（每次前进一帧）始终连续解码；同步、异步解码共用
+    static constexpr double kSeekAheadSeconds = 2.0;
+
+    // 按 lowres 创建并打开解码器
+    bool openDecoder(int lowres);
+    void createTexture();
+    // 按 decodeWidth * decodeHeight 分配纹理存储，尺寸不变时什么也不做
+    void allocateTexture();
+    void rewind();
+    // 定位到 time 之前最近的关键帧，失败时回到开头
+    void seekTo(double time);
+    // time 之前最近的关键帧是否在 from 之后（即定位比继续向前解码更快）
+    bool hasKeyframeBetween(double from, double time) const;
+    // 秒与视频流时间戳之间的换算，时间从流的 start_time 算起
+    int64_t toStreamTimestamp(double time) const;
+    double frameTime(const AVFrame* frame) const;
+    // 解码下一帧到 avFrame 并更新 lastDecodedTime，文件结束且解码器已取空时返回 false
+    bool decodeNextFrame();
+    // 让 dst 引用可以直接上传的帧：支持的 YUV 格式只增加引用，其它格式（高位深、RGB 等）用 swsContext 转换为 YUV420P
+    bool prepareFrame(const AVFrame* frame, AVFrame* dst);
+    // 上传 prepareFrame 得到的帧的平面，并在 GPU 上转换到 texture
+    void uploadFrame(const AVFrame* frame);
+    void presentFrame(AVFrame* frame);
     int normalizeRotation(int degrees);
     void generateVertices(int rotate);
-    void updateTexture(uint8_t* data, int width, int height);
     std::string filePath;
     int videoStreamIndex;
 
@@ -53,11 +86,20 @@ private:
     AVCodecContext* codecContext;
     AVFrame* avFrame;
     AVPacket* avPacket;
+    // 只有解码器输出不能直接上传的格式时才创建
     struct SwsContext* swsContext;
+    // RGBA8，按解码尺寸分配一次不可变存储，由 yuvTexture 每帧绘制
     GLuint texture;
+    GLuint textureWidth = 0;
+    GLuint textureHeight = 0;
+    YuvTexture yuvTexture;
 
+    // 源尺寸，决定顶点和布局
     GLuint width;
     GLuint height;
+    // 上传到纹理的尺寸，不大于源尺寸
+    GLuint decodeWidth = 0;
+    GLuint decodeHeight = 0;
     double duration;
 
     // int sourceWidth;
@@ -66,10 +108,18 @@ private:
     int rotation;
     std::vector<float> vertices; // 存储顶点数据的成员变量
 
-    // 缓存 RGB 数据的缓冲区
-    uint8_t* rgbBuffer;
-    int rgbBufferSize;
+    // presentFrame 中 prepareFrame 的输出
+    AVFrame* preparedFrame = nullptr;
+    // 纹理中画面的时间
     double preTime;
+    // 一帧的时长（秒），由流的帧率得出，判断是否命中某一帧时允许半帧误差
+    double frameDuration = 1.0 / 30.0;
+    // 解码器最近输出的一帧的时间，-1 表示定位之后还没有输出
+    double lastDecodedTime = -1.0;
+    // 已读到文件末尾并取完解码器中的帧，继续取帧前必须先定位
+    bool decoderDrained = false;
+    // 最近解码但没有使用的一帧，到达末尾时用它作为最后一帧
+    AVFrame* lastDecodedFrame = nullptr;
 };
 
 #endif // VIDEORESOURCE_H
\ No newline at end of file
@@ -0,0 +1,134 @@
+// YuvConverter.cpp
+
+#include "YuvConverter.h"
+#include <iostream>
+#include "GLStateCache.h"
+
+const char* const YuvConverter::kVertexShader = "yuvVertex.glsl";
+const char* const YuvConverter::kLumaFragmentShader = "yuvLumaFragment.glsl";
+const char* const YuvConverter::kChromaFragmentShader = "yuvChromaFragment.glsl";
+
+YuvConverter::YuvConverter(std::shared_ptr<ShaderManager> shaderManager, int width, int height)
+    : shaderManager(shaderManager), width(width), height(height) {
+}
+
+YuvConverter::~YuvConverter() {
+    // 程序归 ShaderManager 所有
+    GLStateCache& state = GLStateCache::instance();
+    if (vertexArray) state.deleteVertexArrays(1, &vertexArray);
+    if (lumaFbo) state.deleteFramebuffers(1, &lumaFbo);
+    if (chromaFbo) state.deleteFramebuffers(1, &chromaFbo);
+    if (lumaTexture) state.deleteTextures(1, &lumaTexture);
+    if (chromaTextures[0]) state.deleteTextures(2, chromaTextures);
+}
+
+bool YuvConverter::isAvailable() {
+    if (!initialized) {
+        initialized = true;
+        available = initialize();
+    }
+    return available;
+}
+
+size_t YuvConverter::getFrameSize() const {
+    return static_cast<size_t>(width) * height + 2 * static_cast<size_t>(getChromaWidth()) * getChromaHeight();
+}
+
+static GLuint createPlaneTexture(int width, int height) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    GLStateCache::instance().bindTexture(texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return texture;
+}
+
+bool YuvConverter::initialize() {
+    lumaProgram = shaderManager->getProgram(kVertexShader, kLumaFragmentShader);
+    chromaProgram = shaderManager->getProgram(kVertexShader, kChromaFragmentShader);
+    if (!lumaProgram || !chromaProgram) {
+        std::cerr << "YUV 转换着色器初始化失败，改为读回 RGB" << std::endl;
+        return false;
+    }
+    GLStateCache& state = GLStateCache::instance();
+    state.useProgram(lumaProgram);
+    glUniform1i(glGetUniformLocation(lumaProgram, "u_texture"), 0);
+    lumaRangeLocation = glGetUniformLocation(lumaProgram, "u_lumaRange");
+    state.useProgram(chromaProgram);
+    glUniform1i(glGetUniformLocation(chromaProgram, "u_texture"), 0);
+    chromaScaleLocation = glGetUniformLocation(chromaProgram, "u_chromaScale");
+
+    glGenVertexArrays(1, &vertexArray);
+
+    lumaTexture = createPlaneTexture(width, height);
+    glGenFramebuffers(1, &lumaFbo);
+    state.bindFramebuffer(GL_FRAMEBUFFER, lumaFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, lumaTexture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Y 平面帧缓冲创建失败，改为读回 RGB" << std::endl;
+        return false;
+    }
+
+    chromaTextures[0] = createPlaneTexture(getChromaWidth(), getChromaHeight());
+    chromaTextures[1] = createPlaneTexture(getChromaWidth(), getChromaHeight());
+    glGenFramebuffers(1, &chromaFbo);
+    state.bindFramebuffer(GL_FRAMEBUFFER, chromaFbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, chromaTextures[0], 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, chromaTextures[1], 0);
+    const GLenum drawBuffers[2] = {GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1};
+    glDrawBuffers(2, drawBuffers);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "UV 平面帧缓冲创建失败，改为读回 RGB" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void YuvConverter::convert(GLuint sourceTexture) {
+    if (!isAvailable()) {
+        return;
+    }
+
+    GLStateCache& state = GLStateCache::instance();
+    state.setBlendEnabled(false);
+    state.bindVertexArray(vertexArray);
+    state.bindTexture(0, sourceTexture);
+
+    state.useProgram(lumaProgram);
+    if (fullRange) {
+        glUniform2f(lumaRangeLocation, 1.0f, 0.0f);
+    } else {
+        glUniform2f(lumaRangeLocation, 219.0f / 255.0f, 16.0f / 255.0f);
+    }
+    state.bindFramebuffer(GL_FRAMEBUFFER, lumaFbo);
+    state.viewport(0, 0, width, height);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    state.useProgram(chromaProgram);
+    glUniform1f(chromaScaleLocation, fullRange ? 1.0f : 224.0f / 255.0f);
+    state.bindFramebuffer(GL_FRAMEBUFFER, chromaFbo);
+    state.viewport(0, 0, getChromaWidth(), getChromaHeight());
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
+
+void YuvConverter::readPlanes() {
+    if (!isAvailable()) {
+        return;
+    }
+
+    GLStateCache& state = GLStateCache::instance();
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    size_t lumaSize = static_cast<size_t>(width) * height;
+    size_t chromaSize = static_cast<size_t>(getChromaWidth()) * getChromaHeight();
+
+    state.bindFramebuffer(GL_READ_FRAMEBUFFER, lumaFbo);
+    glReadPixels(0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE, (void*)0);
+
+    // 读缓冲属于帧缓冲对象的状态，只影响 chromaFbo
+    state.bindFramebuffer(GL_READ_FRAMEBUFFER, chromaFbo);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    glReadPixels(0, 0, getChromaWidth(), getChromaHeight(), GL_RED, GL_UNSIGNED_BYTE, (void*)lumaSize);
+    glReadBuffer(GL_COLOR_ATTACHMENT1);
+    glReadPixels(0, 0, getChromaWidth(), getChromaHeight(), GL_RED, GL_UNSIGNED_BYTE, (void*)(lumaSize + chromaSize));
+}
@@ -0,0 +1,62 @@
+// YuvConverter.h
+
+#ifndef YUVCONVERTER_H
+#define YUVCONVERTER_H
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <memory>
+#include "ShaderManager.h"
+
+// 读回前在 GPU 上把画布转换为 YUV420P（BT.709），同时完成垂直翻转
+// Y 平面写入全尺寸 R8 纹理，U、V 平面由一个 pass 写入两个半尺寸 R8 纹理；
+// 三个平面依次读回到同一块连续内存（Y | U | V），布局与 FFmpegWriter::pushYuvFrame 一致
+class YuvConverter {
+public:
+    static const char* const kVertexShader;
+    static const char* const kLumaFragmentShader;
+    static const char* const kChromaFragmentShader;
+
+    YuvConverter(std::shared_ptr<ShaderManager> shaderManager, int width, int height);
+    ~YuvConverter();
+
+    // 着色器编译失败或帧缓冲不完整时返回 false，调用方读回 RGB 由编码线程转换
+    bool isAvailable();
+
+    // fullRange 为 true 时输出完整范围（0-255），否则为有限范围（Y 16-235，UV 16-240）
+    void setFullRange(bool fullRange) { this->fullRange = fullRange; }
+
+    // 把 sourceTexture（画布尺寸）转换到 Y/U/V 平面
+    void convert(GLuint sourceTexture);
+    // 在绑定的 GL_PIXEL_PACK_BUFFER 上发起三个平面的异步读回，每个平面紧密排列
+    void readPlanes();
+
+    int getChromaWidth() const { return (width + 1) / 2; }
+    int getChromaHeight() const { return (height + 1) / 2; }
+    // Y、U、V 三个平面的总字节数
+    size_t getFrameSize() const;
+
+private:
+    bool initialize();
+
+    std::shared_ptr<ShaderManager> shaderManager;
+    int width;
+    int height;
+    bool fullRange = false;
+    bool initialized = false;
+    bool available = false;
+
+    GLuint lumaProgram = 0;
+    GLuint chromaProgram = 0;
+    GLint lumaRangeLocation = -1;
+    GLint chromaScaleLocation = -1;
+    // 核心模式下绘制必须绑定 VAO，顶点位置由 gl_VertexID 生成，VAO 为空
+    GLuint vertexArray = 0;
+
+    GLuint lumaFbo = 0;
+    GLuint lumaTexture = 0;
+    GLuint chromaFbo = 0;
+    GLuint chromaTextures[2] = {0, 0};
+};
+
+#endif // YUVCONVERTER_H
@@ -0,0 +1,268 @@
+// YuvTexture.cpp
+
+#include "YuvTexture.h"
+#include <iostream>
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+
+extern "C" {
+#include <libavutil/pixdesc.h>
+}
+
+const char* const YuvTexture::kVertexShader = "yuvVertex.glsl";
+const char* const YuvTexture::kFragmentShader = "videoYuvFragment.glsl";
+
+// 平面的排列方式，与 videoYuvFragment.glsl 的 u_layout 一致
+enum PlaneLayout {
+    kLayoutPlanar = 0,
+    kLayoutNV12 = 1,
+    kLayoutNV21 = 2,
+};
+
+// 所有视频共享的转换程序
+namespace {
+struct SharedYuvResources {
+    std::shared_ptr<ShaderManager> shaderManager;
+    bool failed = false;
+    GLuint program = 0;
+    GLint layoutLocation = -1;
+    GLint targetSizeLocation = -1;
+    GLint matrixLocation = -1;
+    GLint offsetLocation = -1;
+    // 核心模式下绘制必须绑定 VAO，顶点位置由 gl_VertexID 生成，VAO 为空
+    GLuint vertexArray = 0;
+};
+
+SharedYuvResources& sharedYuvResources() {
+    static SharedYuvResources shared;
+    return shared;
+}
+
+SharedYuvResources* acquireSharedYuvResources() {
+    auto& shared = sharedYuvResources();
+    if (shared.program) {
+        return &shared;
+    }
+    if (shared.failed || !shared.shaderManager) {
+        return nullptr;
+    }
+    shared.program = shared.shaderManager->getProgram(YuvTexture::kVertexShader, YuvTexture::kFragmentShader);
+    if (!shared.program) {
+        std::cerr << "视频 YUV 转换着色器初始化失败" << std::endl;
+        shared.failed = true;
+        return nullptr;
+    }
+    GLStateCache& state = GLStateCache::instance();
+    state.useProgram(shared.program);
+    glUniform1i(glGetUniformLocation(shared.program, "u_textureY"), 0);
+    glUniform1i(glGetUniformLocation(shared.program, "u_textureU"), 1);
+    glUniform1i(glGetUniformLocation(shared.program, "u_textureV"), 2);
+    shared.layoutLocation = glGetUniformLocation(shared.program, "u_layout");
+    shared.targetSizeLocation = glGetUniformLocation(shared.program, "u_targetSize");
+    shared.matrixLocation = glGetUniformLocation(shared.program, "u_yuvMatrix");
+    shared.offsetLocation = glGetUniformLocation(shared.program, "u_yuvOffset");
+    glGenVertexArrays(1, &shared.vertexArray);
+    return &shared;
+}
+
+int planeLayout(int format) {
+    if (format == AV_PIX_FMT_NV12) return kLayoutNV12;
+    if (format == AV_PIX_FMT_NV21) return kLayoutNV21;
+    return kLayoutPlanar;
+}
+}
+
+void YuvTexture::setShaderManager(std::shared_ptr<ShaderManager> shaderManager) {
+    auto& shared = sharedYuvResources();
+    shared.shaderManager = shaderManager;
+    shared.failed = false;
+}
+
+void YuvTexture::releaseSharedResources() {
+    // 程序归 ShaderManager 所有
+    auto& shared = sharedYuvResources();
+    if (shared.vertexArray) {
+        GLStateCache::instance().deleteVertexArrays(1, &shared.vertexArray);
+    }
+    shared = SharedYuvResources();
+}
+
+YuvTexture::~YuvTexture() {
+    deletePlanes();
+    if (framebuffer) {
+        GLStateCache::instance().deleteFramebuffers(1, &framebuffer);
+        framebuffer = 0;
+    }
+}
+
+bool YuvTexture::isSupportedFormat(int format) {
+    switch (format) {
+    case AV_PIX_FMT_YUV420P:
+    case AV_PIX_FMT_YUVJ420P:
+    case AV_PIX_FMT_YUV422P:
+    case AV_PIX_FMT_YUVJ422P:
+    case AV_PIX_FMT_YUV444P:
+    case AV_PIX_FMT_YUVJ444P:
+    case AV_PIX_FMT_YUV440P:
+    case AV_PIX_FMT_YUVJ440P:
+    case AV_PIX_FMT_YUV411P:
+    case AV_PIX_FMT_YUV410P:
+    case AV_PIX_FMT_NV12:
+    case AV_PIX_FMT_NV21:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void YuvTexture::allocateStorage(GLuint texture, GLenum internalFormat, int width, int height) {
+    GLStateCache::instance().bindTexture(texture);
+    if (GLExtensions::hasTextureStorage) {
+        GLExtensions::texStorage2D(GL_TEXTURE_2D, 1, internalFormat, width, height);
+    } else {
+        GLenum format = internalFormat == GL_R8 ? GL_RED : internalFormat == GL_RG8 ? GL_RG : GL_RGBA;
+        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, nullptr);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    }
+}
+
+void YuvTexture::colorMatrix(const AVFrame* frame, glm::mat3& matrix, glm::vec3& offset) {
+    // 亮度系数 Kr、Kb
+    float kr = 0.299f, kb = 0.114f;
+    switch (frame->colorspace) {
+    case AVCOL_SPC_BT709:
+        kr = 0.2126f; kb = 0.0722f;
+        break;
+    case AVCOL_SPC_BT2020_NCL:
+    case AVCOL_SPC_BT2020_CL:
+        kr = 0.2627f; kb = 0.0593f;
+        break;
+    case AVCOL_SPC_SMPTE240M:
+        kr = 0.212f; kb = 0.087f;
+        break;
+    case AVCOL_SPC_FCC:
+        kr = 0.30f; kb = 0.11f;
+        break;
+    case AVCOL_SPC_BT470BG:
+    case AVCOL_SPC_SMPTE170M:
+        break;
+    default:
+        if (frame->height >= 720) {
+            kr = 0.2126f; kb = 0.0722f;
+        }
+        break;
+    }
+    float kg = 1.0f - kr - kb;
+
+    bool fullRange = frame->color_range == AVCOL_RANGE_JPEG ||
+                     frame->format == AV_PIX_FMT_YUVJ420P || frame->format == AV_PIX_FMT_YUVJ422P ||
+                     frame->format == AV_PIX_FMT_YUVJ444P || frame->format == AV_PIX_FMT_YUVJ440P;
+    // 有限范围：Y 16-235，UV 16-240
+    float lumaScale = fullRange ? 1.0f : 255.0f / 219.0f;
+    float chromaScale = fullRange ? 1.0f : 255.0f / 224.0f;
+    offset = glm::vec3(fullRange ? 0.0f : 16.0f / 255.0f, 128.0f / 255.0f, 128.0f / 255.0f);
+
+    // glm 按列存储：第 0 列乘 Y，第 1 列乘 U，第 2 列乘 V
+    matrix[0] = glm::vec3(lumaScale);
+    matrix[1] = glm::vec3(0.0f, -2.0f * kb * (1.0f - kb) / kg, 2.0f * (1.0f - kb)) * chromaScale;
+    matrix[2] = glm::vec3(2.0f * (1.0f - kr), -2.0f * kr * (1.0f - kr) / kg, 0.0f) * chromaScale;
+}
+
+void YuvTexture::deletePlanes() {
+    if (planeCount > 0) {
+        GLStateCache::instance().deleteTextures(planeCount, planes);
+    }
+    planes[0] = planes[1] = planes[2] = 0;
+    planeCount = 0;
+    planeFormat = -1;
+}
+
+void YuvTexture::ensurePlanes(const AVFrame* frame) {
+    if (planeCount > 0 && planeFormat == frame->format && planeWidth == frame->width && planeHeight == frame->height) {
+        return;
+    }
+    deletePlanes();
+
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+    int chromaWidth = AV_CEIL_RSHIFT(frame->width, desc->log2_chroma_w);
+    int chromaHeight = AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h);
+    bool interleaved = planeLayout(frame->format) != kLayoutPlanar;
+
+    planeCount = interleaved ? 2 : 3;
+    glGenTextures(planeCount, planes);
+    for (int i = 0; i < planeCount; i++) {
+        if (i == 0) {
+            allocateStorage(planes[i], GL_R8, frame->width, frame->height);
+        } else {
+            allocateStorage(planes[i], interleaved ? GL_RG8 : GL_R8, chromaWidth, chromaHeight);
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    planeFormat = frame->format;
+    planeWidth = frame->width;
+    planeHeight = frame->height;
+}
+
+bool YuvTexture::convert(const AVFrame* frame, GLuint target, int width, int height) {
+    if (!isSupportedFormat(frame->format)) {
+        return false;
+    }
+    for (int i = 0; i < 3 && frame->data[i]; i++) {
+        // 自下而上存储的帧（负 linesize）无法用 GL_UNPACK_ROW_LENGTH 表示
+        if (frame->linesize[i] <= 0) {
+            return false;
+        }
+    }
+    SharedYuvResources* shared = acquireSharedYuvResources();
+    if (!shared) {
+        return false;
+    }
+
+    GLStateCache& state = GLStateCache::instance();
+    if (!framebuffer) {
+        glGenFramebuffers(1, &framebuffer);
+    }
+    if (attachedTarget != target) {
+        state.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            std::cerr << "视频纹理帧缓冲不完整" << std::endl;
+            return false;
+        }
+        attachedTarget = target;
+    }
+
+    // 上传平面：行长度取 linesize，解码器的行对齐填充不需要先拷贝掉
+    ensurePlanes(frame);
+    const AVPixFmtDescriptor* desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(frame->format));
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int i = 0; i < planeCount; i++) {
+        int planeWidth = i == 0 ? frame->width : AV_CEIL_RSHIFT(frame->width, desc->log2_chroma_w);
+        int planeHeight = i == 0 ? frame->height : AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h);
+        bool rg = i > 0 && planeCount == 2;
+        state.bindTexture(i, planes[i]);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, frame->linesize[i] / (rg ? 2 : 1));
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, planeWidth, planeHeight, rg ? GL_RG : GL_RED, GL_UNSIGNED_BYTE, frame->data[i]);
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    glm::mat3 matrix;
+    glm::vec3 offset;
+    colorMatrix(frame, matrix, offset);
+
+    state.setBlendEnabled(false);
+    state.useProgram(shared->program);
+    glUniform1i(shared->layoutLocation, planeLayout(frame->format));
+    glUniform2f(shared->targetSizeLocation, static_cast<float>(width), static_cast<float>(height));
+    glUniformMatrix3fv(shared->matrixLocation, 1, GL_FALSE, &matrix[0][0]);
+    glUniform3f(shared->offsetLocation, offset.x, offset.y, offset.z);
+    state.bindVertexArray(shared->vertexArray);
+    state.bindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    state.viewport(0, 0, width, height);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    return true;
+}
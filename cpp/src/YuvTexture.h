@@ -0,0 +1,63 @@
+// YuvTexture.h
+
+#ifndef YUVTEXTURE_H
+#define YUVTEXTURE_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include "ShaderManager.h"
+
+extern "C" {
+#include <libavutil/frame.h>
+}
+
+// 解码帧的 Y/U/V（或 NV12 的 Y/UV）平面纹理，以及把平面转换到视频资源 RGBA 纹理的一次全屏绘制
+// 平面纹理按帧的格式和尺寸分配一次（支持时为 glTexStorage2D 不可变存储），之后每帧只用 glTexSubImage2D
+// 按 linesize 直接上传解码器的平面；颜色矩阵由帧的 colorspace、color_range 得出
+// 转换结果仍是普通的 RGBA 纹理，Stand 的批量绘制和插件材质按 textureResourceId 采样都不需要区分视频
+class YuvTexture {
+public:
+    static const char* const kVertexShader;
+    static const char* const kFragmentShader;
+
+    YuvTexture() = default;
+    ~YuvTexture();
+
+    YuvTexture(const YuvTexture&) = delete;
+    YuvTexture& operator=(const YuvTexture&) = delete;
+
+    // 可以直接上传的像素格式：8 位平面 YUV（含 yuvj）、NV12、NV21
+    static bool isSupportedFormat(int format);
+    // 为 texture 分配 width * height 的单层存储，之后只能用 glTexSubImage2D 更新
+    static void allocateStorage(GLuint texture, GLenum internalFormat, int width, int height);
+    // rgb = matrix * (yuv - offset)，yuv 为 0-1 的归一化码值
+    // BT.709 / BT.601 / BT.2020，未标注时 720 行及以上按 709，否则按 601；yuvj 格式或 JPEG 范围为完整范围
+    static void colorMatrix(const AVFrame* frame, glm::mat3& matrix, glm::vec3& offset);
+
+    // 上传 frame 的平面并转换到 target（已分配 GL_RGBA8 存储，尺寸为 width * height）
+    // 格式不支持、着色器或帧缓冲不可用时返回 false
+    bool convert(const AVFrame* frame, GLuint target, int width, int height);
+    // target 被删除后调用，下次 convert 时重新挂接（新纹理可能复用同一个名字）
+    void resetTarget() { attachedTarget = 0; }
+
+    // 转换程序和空 VAO 由所有视频共享，Engine 创建上下文后设置，销毁上下文前释放
+    static void setShaderManager(std::shared_ptr<ShaderManager> shaderManager);
+    static void releaseSharedResources();
+
+private:
+    // 格式或尺寸变化时重新创建平面纹理（不可变存储不能重新分配）
+    void ensurePlanes(const AVFrame* frame);
+    void deletePlanes();
+
+    GLuint planes[3] = {0, 0, 0};
+    int planeCount = 0;
+    int planeFormat = -1;
+    int planeWidth = 0;
+    int planeHeight = 0;
+
+    GLuint framebuffer = 0;
+    GLuint attachedTarget = 0;
+};
+
+#endif // YUVTEXTURE_H
@@ -9,11 +9,14 @@ out vec4 FragColor;
 
 // 原纹理，Alpha 通道需要包含文字形状
 uniform sampler2D u_texture;
-uniform vec2 u_texResolution;  
-uniform int u_steps;
-uniform vec4 u_outlineColor;
 
-uniform vec4 u_uvTransform;
+// 描边参数，整块上传，值不变的帧不再上传
+layout(std140) uniform OutlineParams {
+    vec4 u_uvTransform;
+    vec4 u_outlineColor;
+    vec2 u_texResolution;
+    int u_steps;
+};
 // uniform vec2 u_outlineOffset;
 
 // 采样方向（48个方向，间隔7.5°）
@@ -0,0 +1,28 @@
+precision mediump float;
+
+in vec2 v_texCoord;
+in vec4 v_color;
+flat in int v_slot;
+
+out vec4 FragColor;
+
+// GLSL 3.30 的采样器数组只能用常量下标，按槽位分支采样
+uniform sampler2D u_textures[8];
+
+vec4 sampleSlot(int slot, vec2 uv) {
+    switch (slot) {
+    case 0: return texture(u_textures[0], uv);
+    case 1: return texture(u_textures[1], uv);
+    case 2: return texture(u_textures[2], uv);
+    case 3: return texture(u_textures[3], uv);
+    case 4: return texture(u_textures[4], uv);
+    case 5: return texture(u_textures[5], uv);
+    case 6: return texture(u_textures[6], uv);
+    default: return texture(u_textures[7], uv);
+    }
+}
+
+void main() {
+    vec4 texColor = sampleSlot(v_slot, v_texCoord);
+    FragColor = vec4(texColor.r * v_color.r, texColor.g * v_color.g, texColor.b * v_color.b, texColor.a) * v_color.a;
+}
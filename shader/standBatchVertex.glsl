@@ -0,0 +1,31 @@
+precision mediump float;
+
+// 单位矩形的角点（-1..1），每个实例按自己的半宽高缩放
+layout(location = 0) in vec2 a_corner;
+// 逐实例属性
+layout(location = 1) in mat4 i_modelMatrix;
+layout(location = 5) in vec4 i_color;
+// 左上角与右下角的纹理坐标
+layout(location = 6) in vec4 i_uvRect;
+// xy 为半宽高，z 为纹理槽位
+layout(location = 7) in vec4 i_sizeSlot;
+
+// 每帧共享的相机矩阵
+layout(std140) uniform FrameUniforms {
+    mat4 u_viewMatrix;
+    mat4 u_projectionMatrix;
+    vec2 u_canvasSize;
+};
+
+out vec2 v_texCoord;
+out vec4 v_color;
+flat out int v_slot;
+
+void main() {
+    vec3 position = vec3(a_corner * i_sizeSlot.xy, 0.0);
+    gl_Position = u_projectionMatrix * u_viewMatrix * i_modelMatrix * vec4(position, 1.0);
+    vec2 t = a_corner * vec2(0.5, -0.5) + 0.5;
+    v_texCoord = mix(i_uvRect.xy, i_uvRect.zw, t);
+    v_color = i_color;
+    v_slot = int(i_sizeSlot.z + 0.5);
+}
@@ -4,8 +4,12 @@ in vec3 a_position;
 in vec2 a_texCoord;
 
 uniform mat4 u_modelMatrix;
-uniform mat4 u_viewMatrix;
-uniform mat4 u_projectionMatrix;
+// 每帧共享的相机矩阵
+layout(std140) uniform FrameUniforms {
+    mat4 u_viewMatrix;
+    mat4 u_projectionMatrix;
+    vec2 u_canvasSize;
+};
 
 out vec2 v_texCoord;
 
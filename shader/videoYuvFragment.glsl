@@ -0,0 +1,29 @@
+precision mediump float;
+
+// 把解码帧的平面转换为 RGB：u_layout 为 0 时 U、V 各一个平面，1 为 NV12（UV 交错在 r、g），2 为 NV21
+uniform sampler2D u_textureY;
+uniform sampler2D u_textureU;
+uniform sampler2D u_textureV;
+uniform int u_layout;
+// 输出纹理的尺寸，平面按归一化坐标采样，色度平面由线性过滤插值到全分辨率
+uniform vec2 u_targetSize;
+// rgb = u_yuvMatrix * (yuv - u_yuvOffset)，范围缩放已并入矩阵
+uniform mat3 u_yuvMatrix;
+uniform vec3 u_yuvOffset;
+
+out vec4 FragColor;
+
+void main() {
+    vec2 uv = gl_FragCoord.xy / u_targetSize;
+    float y = texture(u_textureY, uv).r;
+    vec2 chroma;
+    if (u_layout == 0) {
+        chroma = vec2(texture(u_textureU, uv).r, texture(u_textureV, uv).r);
+    } else if (u_layout == 1) {
+        chroma = texture(u_textureU, uv).rg;
+    } else {
+        chroma = texture(u_textureU, uv).gr;
+    }
+    vec3 rgb = u_yuvMatrix * (vec3(y, chroma) - u_yuvOffset);
+    FragColor = vec4(clamp(rgb, 0.0, 1.0), 1.0);
+}
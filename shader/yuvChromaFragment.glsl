@@ -0,0 +1,28 @@
+precision mediump float;
+
+// 每个输出像素对应画布上 2x2 的像素块，取平均后转换为 BT.709 色度，U、V 分别写入两个颜色附件
+uniform sampler2D u_texture;
+// 色度的缩放：有限范围为 224/255，完整范围为 1
+uniform float u_chromaScale;
+
+layout(location = 0) out vec4 FragU;
+layout(location = 1) out vec4 FragV;
+
+vec3 fetchFlipped(ivec2 size, int x, int y) {
+    // 奇数尺寸时最后一列/行的块只有一半像素在画布内
+    x = min(x, size.x - 1);
+    y = min(y, size.y - 1);
+    return texelFetch(u_texture, ivec2(x, size.y - 1 - y), 0).rgb;
+}
+
+void main() {
+    ivec2 size = textureSize(u_texture, 0);
+    ivec2 coord = ivec2(gl_FragCoord.xy) * 2;
+    vec3 rgb = (fetchFlipped(size, coord.x, coord.y) + fetchFlipped(size, coord.x + 1, coord.y) +
+                fetchFlipped(size, coord.x, coord.y + 1) + fetchFlipped(size, coord.x + 1, coord.y + 1)) * 0.25;
+    float y = dot(rgb, vec3(0.2126, 0.7152, 0.0722));
+    float u = (rgb.b - y) / 1.8556;
+    float v = (rgb.r - y) / 1.5748;
+    FragU = vec4(u * u_chromaScale + 128.0 / 255.0, 0.0, 0.0, 1.0);
+    FragV = vec4(v * u_chromaScale + 128.0 / 255.0, 0.0, 0.0, 1.0);
+}
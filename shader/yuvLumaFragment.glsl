@@ -0,0 +1,16 @@
+precision mediump float;
+
+// 画布颜色（左下角为原点），输出的第 0 行是画面顶部，读回后无需再翻转
+uniform sampler2D u_texture;
+// BT.709 亮度的缩放和偏移：有限范围为 219/255、16/255，完整范围为 1、0
+uniform vec2 u_lumaRange;
+
+out vec4 FragColor;
+
+void main() {
+    ivec2 size = textureSize(u_texture, 0);
+    ivec2 coord = ivec2(gl_FragCoord.xy);
+    vec3 rgb = texelFetch(u_texture, ivec2(coord.x, size.y - 1 - coord.y), 0).rgb;
+    float y = dot(rgb, vec3(0.2126, 0.7152, 0.0722));
+    FragColor = vec4(y * u_lumaRange.x + u_lumaRange.y, 0.0, 0.0, 1.0);
+}
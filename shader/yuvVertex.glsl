@@ -0,0 +1,7 @@
+precision mediump float;
+
+// 不使用顶点缓冲，按 gl_VertexID 生成覆盖整个视口的三角形带
+void main() {
+    vec2 corner = vec2(float(gl_VertexID & 1), float(gl_VertexID >> 1)) * 2.0 - 1.0;
+    gl_Position = vec4(corner, 0.0, 1.0);
+}